@@ -3,8 +3,150 @@
 
 
 #include "cpp11/declarations.hpp"
+#include "fastde_types.h"
 #include <R_ext/Visibility.h>
 
+// cpp11_downsample.cpp
+extern cpp11::writable::list cpp11_sp_downsample(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & ncol, cpp11::doubles const & targets, int const & method, double const & seed, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_downsample(SEXP x, SEXP i, SEXP p, SEXP ncol, SEXP targets, SEXP method, SEXP seed, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_downsample(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(targets), cpp11::as_cpp<cpp11::decay_t<int const &>>(method), cpp11::as_cpp<cpp11::decay_t<double const &>>(seed), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_downsample.cpp
+extern cpp11::writable::list cpp11_sp64_downsample(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & ncol, cpp11::doubles const & targets, int const & method, double const & seed, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_downsample(SEXP x, SEXP i, SEXP p, SEXP ncol, SEXP targets, SEXP method, SEXP seed, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_downsample(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(targets), cpp11::as_cpp<cpp11::decay_t<int const &>>(method), cpp11::as_cpp<cpp11::decay_t<double const &>>(seed), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_fastmath.cpp
+extern int cpp11_set_math_mode(int const & mode);
+extern "C" SEXP _fastde_cpp11_set_math_mode(SEXP mode) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_set_math_mode(cpp11::as_cpp<cpp11::decay_t<int const &>>(mode)));
+  END_CPP11
+}
+// cpp11_fastmath.cpp
+extern int cpp11_get_math_mode();
+extern "C" SEXP _fastde_cpp11_get_math_mode() {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_get_math_mode());
+  END_CPP11
+}
+// cpp11_fastmath.cpp
+extern std::string cpp11_fast_math_target();
+extern "C" SEXP _fastde_cpp11_fast_math_target() {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_fast_math_target());
+  END_CPP11
+}
+// cpp11_fastmath.cpp
+extern cpp11::writable::doubles cpp11_vec_log1p(cpp11::doubles const & x);
+extern "C" SEXP _fastde_cpp11_vec_log1p(SEXP x) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_vec_log1p(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x)));
+  END_CPP11
+}
+// cpp11_fastmath.cpp
+extern cpp11::writable::doubles cpp11_vec_expm1(cpp11::doubles const & x);
+extern "C" SEXP _fastde_cpp11_vec_expm1(SEXP x) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_vec_expm1(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern bool cpp11_h5_exists(std::string const & filename, std::string const & path);
+extern "C" SEXP _fastde_cpp11_h5_exists(SEXP filename, SEXP path) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_exists(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(path)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern cpp11::writable::strings cpp11_h5_list_groups(std::string const & filename, std::string const & path);
+extern "C" SEXP _fastde_cpp11_h5_list_groups(SEXP filename, SEXP path) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_list_groups(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(path)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern cpp11::writable::strings cpp11_h5_read_strings(std::string const & filename, std::string const & path);
+extern "C" SEXP _fastde_cpp11_h5_read_strings(SEXP filename, SEXP path) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_read_strings(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(path)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern bool cpp11_h5_is_group(std::string const & filename, std::string const & path);
+extern "C" SEXP _fastde_cpp11_h5_is_group(SEXP filename, SEXP path) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_is_group(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(path)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern cpp11::writable::doubles cpp11_h5_dims(std::string const & filename, std::string const & path);
+extern "C" SEXP _fastde_cpp11_h5_dims(SEXP filename, SEXP path) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_dims(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(path)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern cpp11::writable::strings cpp11_h5_attr_strings(std::string const & filename, std::string const & path, std::string const & name);
+extern "C" SEXP _fastde_cpp11_h5_attr_strings(SEXP filename, SEXP path, SEXP name) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_attr_strings(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(path), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(name)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern cpp11::writable::doubles cpp11_h5_attr_doubles(std::string const & filename, std::string const & path, std::string const & name);
+extern "C" SEXP _fastde_cpp11_h5_attr_doubles(SEXP filename, SEXP path, SEXP name) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_attr_doubles(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(path), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(name)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern cpp11::writable::doubles cpp11_h5_read_doubles(std::string const & filename, std::string const & path, int const & threads);
+extern "C" SEXP _fastde_cpp11_h5_read_doubles(SEXP filename, SEXP path, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_read_doubles(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(path), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern cpp11::writable::list cpp11_h5_read_sparse(std::string const & filename, std::string const & x_path, std::string const & i_path, std::string const & p_path, bool const & large, int const & threads);
+extern "C" SEXP _fastde_cpp11_h5_read_sparse(SEXP filename, SEXP x_path, SEXP i_path, SEXP p_path, SEXP large, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_read_sparse(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(x_path), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(i_path), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(p_path), cpp11::as_cpp<cpp11::decay_t<bool const &>>(large), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern cpp11::writable::list cpp11_h5_read_sparse_filtered(std::string const & filename, std::string const & x_path, std::string const & i_path, std::string const & p_path, int const & nrow, cpp11::integers const & cols, cpp11::integers const & rows, double const & min_features, double const & min_counts, double const & min_cells, bool const & large, int const & threads);
+extern "C" SEXP _fastde_cpp11_h5_read_sparse_filtered(SEXP filename, SEXP x_path, SEXP i_path, SEXP p_path, SEXP nrow, SEXP cols, SEXP rows, SEXP min_features, SEXP min_counts, SEXP min_cells, SEXP large, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_read_sparse_filtered(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(x_path), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(i_path), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(p_path), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(rows), cpp11::as_cpp<cpp11::decay_t<double const &>>(min_features), cpp11::as_cpp<cpp11::decay_t<double const &>>(min_counts), cpp11::as_cpp<cpp11::decay_t<double const &>>(min_cells), cpp11::as_cpp<cpp11::decay_t<bool const &>>(large), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern cpp11::writable::list cpp11_h5_read_dense_sparse(std::string const & filename, std::string const & path, bool const & cols_are_rows, bool const & large, int const & threads);
+extern "C" SEXP _fastde_cpp11_h5_read_dense_sparse(SEXP filename, SEXP path, SEXP cols_are_rows, SEXP large, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_h5_read_dense_sparse(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(path), cpp11::as_cpp<cpp11::decay_t<bool const &>>(cols_are_rows), cpp11::as_cpp<cpp11::decay_t<bool const &>>(large), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern void cpp11_h5_write_10x(std::string const & filename, std::string const & group, cpp11::doubles const & x, cpp11::integers const & i, cpp11::sexp const & p, cpp11::integers const & dim, std::string const & feature_slot, cpp11::strings const & features, cpp11::strings const & barcodes, int const & chunk, int const & level, int const & threads);
+extern "C" SEXP _fastde_cpp11_h5_write_10x(SEXP filename, SEXP group, SEXP x, SEXP i, SEXP p, SEXP dim, SEXP feature_slot, SEXP features, SEXP barcodes, SEXP chunk, SEXP level, SEXP threads) {
+  BEGIN_CPP11
+    cpp11_h5_write_10x(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(group), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::sexp const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(dim), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(feature_slot), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(barcodes), cpp11::as_cpp<cpp11::decay_t<int const &>>(chunk), cpp11::as_cpp<cpp11::decay_t<int const &>>(level), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads));
+    return R_NilValue;
+  END_CPP11
+}
+// cpp11_fileio.cpp
+extern cpp11::writable::list cpp11_mtx_read_sparse(std::string const & filename, bool const & large, int const & threads);
+extern "C" SEXP _fastde_cpp11_mtx_read_sparse(SEXP filename, SEXP large, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_mtx_read_sparse(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<bool const &>>(large), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
 // cpp11_foldchange.cpp
 extern cpp11::sexp cpp11_ComputeFoldChange(cpp11::doubles_matrix<cpp11::by_column> const & matrix, cpp11::strings const & features, cpp11::integers const & labels, bool calc_percents, std::string fc_name, bool use_expm1, double min_threshold, bool use_log, double log_base, bool use_pseudocount, bool as_dataframe, int threads);
 extern "C" SEXP _fastde_cpp11_ComputeFoldChange(SEXP matrix, SEXP features, SEXP labels, SEXP calc_percents, SEXP fc_name, SEXP use_expm1, SEXP min_threshold, SEXP use_log, SEXP log_base, SEXP use_pseudocount, SEXP as_dataframe, SEXP threads) {
@@ -13,17 +155,31 @@ extern "C" SEXP _fastde_cpp11_ComputeFoldChange(SEXP matrix, SEXP features, SEXP
   END_CPP11
 }
 // cpp11_foldchange.cpp
-extern cpp11::sexp cpp11_ComputeFoldChangeSparse(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, bool calc_percents, std::string fc_name, bool use_expm1, double min_threshold, bool use_log, double log_base, bool use_pseudocount, bool as_dataframe, int threads);
-extern "C" SEXP _fastde_cpp11_ComputeFoldChangeSparse(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP calc_percents, SEXP fc_name, SEXP use_expm1, SEXP min_threshold, SEXP use_log, SEXP log_base, SEXP use_pseudocount, SEXP as_dataframe, SEXP threads) {
+extern cpp11::sexp cpp11_ComputeFoldChangeSparse(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, bool calc_percents, std::string fc_name, bool use_expm1, double min_threshold, bool use_log, double log_base, bool use_pseudocount, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, int threads);
+extern "C" SEXP _fastde_cpp11_ComputeFoldChangeSparse(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP calc_percents, SEXP fc_name, SEXP use_expm1, SEXP min_threshold, SEXP use_log, SEXP log_base, SEXP use_pseudocount, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP threads) {
   BEGIN_CPP11
-    return cpp11::as_sexp(cpp11_ComputeFoldChangeSparse(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<bool>>(calc_percents), cpp11::as_cpp<cpp11::decay_t<std::string>>(fc_name), cpp11::as_cpp<cpp11::decay_t<bool>>(use_expm1), cpp11::as_cpp<cpp11::decay_t<double>>(min_threshold), cpp11::as_cpp<cpp11::decay_t<bool>>(use_log), cpp11::as_cpp<cpp11::decay_t<double>>(log_base), cpp11::as_cpp<cpp11::decay_t<bool>>(use_pseudocount), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+    return cpp11::as_sexp(cpp11_ComputeFoldChangeSparse(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<bool>>(calc_percents), cpp11::as_cpp<cpp11::decay_t<std::string>>(fc_name), cpp11::as_cpp<cpp11::decay_t<bool>>(use_expm1), cpp11::as_cpp<cpp11::decay_t<double>>(min_threshold), cpp11::as_cpp<cpp11::decay_t<bool>>(use_log), cpp11::as_cpp<cpp11::decay_t<double>>(log_base), cpp11::as_cpp<cpp11::decay_t<bool>>(use_pseudocount), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
   END_CPP11
 }
 // cpp11_foldchange.cpp
-extern cpp11::sexp cpp11_ComputeFoldChangeSparse64(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, bool calc_percents, std::string fc_name, bool use_expm1, double min_threshold, bool use_log, double log_base, bool use_pseudocount, bool as_dataframe, int threads);
-extern "C" SEXP _fastde_cpp11_ComputeFoldChangeSparse64(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP calc_percents, SEXP fc_name, SEXP use_expm1, SEXP min_threshold, SEXP use_log, SEXP log_base, SEXP use_pseudocount, SEXP as_dataframe, SEXP threads) {
+extern cpp11::sexp cpp11_ComputeFoldChangeSparse64(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, bool calc_percents, std::string fc_name, bool use_expm1, double min_threshold, bool use_log, double log_base, bool use_pseudocount, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, int threads);
+extern "C" SEXP _fastde_cpp11_ComputeFoldChangeSparse64(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP calc_percents, SEXP fc_name, SEXP use_expm1, SEXP min_threshold, SEXP use_log, SEXP log_base, SEXP use_pseudocount, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP threads) {
   BEGIN_CPP11
-    return cpp11::as_sexp(cpp11_ComputeFoldChangeSparse64(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<bool>>(calc_percents), cpp11::as_cpp<cpp11::decay_t<std::string>>(fc_name), cpp11::as_cpp<cpp11::decay_t<bool>>(use_expm1), cpp11::as_cpp<cpp11::decay_t<double>>(min_threshold), cpp11::as_cpp<cpp11::decay_t<bool>>(use_log), cpp11::as_cpp<cpp11::decay_t<double>>(log_base), cpp11::as_cpp<cpp11::decay_t<bool>>(use_pseudocount), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+    return cpp11::as_sexp(cpp11_ComputeFoldChangeSparse64(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<bool>>(calc_percents), cpp11::as_cpp<cpp11::decay_t<std::string>>(fc_name), cpp11::as_cpp<cpp11::decay_t<bool>>(use_expm1), cpp11::as_cpp<cpp11::decay_t<double>>(min_threshold), cpp11::as_cpp<cpp11::decay_t<bool>>(use_log), cpp11::as_cpp<cpp11::decay_t<double>>(log_base), cpp11::as_cpp<cpp11::decay_t<bool>>(use_pseudocount), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+  END_CPP11
+}
+// cpp11_foldchange.cpp
+extern cpp11::sexp cpp11_spmat_foldchange(cpp11::external_pointer<spmat_mmap> const & handle, cpp11::strings const & features, cpp11::integers const & labels, bool features_as_rows, bool calc_percents, std::string fc_name, bool use_expm1, double min_threshold, bool use_log, double log_base, bool use_pseudocount, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, std::string const & output, int threads);
+extern "C" SEXP _fastde_cpp11_spmat_foldchange(SEXP handle, SEXP features, SEXP labels, SEXP features_as_rows, SEXP calc_percents, SEXP fc_name, SEXP use_expm1, SEXP min_threshold, SEXP use_log, SEXP log_base, SEXP use_pseudocount, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP output, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spmat_foldchange(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<spmat_mmap> const &>>(handle), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<bool>>(calc_percents), cpp11::as_cpp<cpp11::decay_t<std::string>>(fc_name), cpp11::as_cpp<cpp11::decay_t<bool>>(use_expm1), cpp11::as_cpp<cpp11::decay_t<double>>(min_threshold), cpp11::as_cpp<cpp11::decay_t<bool>>(use_log), cpp11::as_cpp<cpp11::decay_t<double>>(log_base), cpp11::as_cpp<cpp11::decay_t<bool>>(use_pseudocount), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(output), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+  END_CPP11
+}
+// cpp11_foldchange.cpp
+extern cpp11::sexp cpp11_spcat_foldchange(cpp11::list const & xs, cpp11::list const & is, cpp11::list const & ps, cpp11::integers const & nrows, cpp11::integers const & ncols, bool by_rows, double const & block_bytes, cpp11::strings const & features, cpp11::integers const & labels, bool features_as_rows, bool calc_percents, std::string fc_name, bool use_expm1, double min_threshold, bool use_log, double log_base, bool use_pseudocount, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, std::string const & output, int threads);
+extern "C" SEXP _fastde_cpp11_spcat_foldchange(SEXP xs, SEXP is, SEXP ps, SEXP nrows, SEXP ncols, SEXP by_rows, SEXP block_bytes, SEXP features, SEXP labels, SEXP features_as_rows, SEXP calc_percents, SEXP fc_name, SEXP use_expm1, SEXP min_threshold, SEXP use_log, SEXP log_base, SEXP use_pseudocount, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP output, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spcat_foldchange(cpp11::as_cpp<cpp11::decay_t<cpp11::list const &>>(xs), cpp11::as_cpp<cpp11::decay_t<cpp11::list const &>>(is), cpp11::as_cpp<cpp11::decay_t<cpp11::list const &>>(ps), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(nrows), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(ncols), cpp11::as_cpp<cpp11::decay_t<bool>>(by_rows), cpp11::as_cpp<cpp11::decay_t<double const &>>(block_bytes), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<bool>>(calc_percents), cpp11::as_cpp<cpp11::decay_t<std::string>>(fc_name), cpp11::as_cpp<cpp11::decay_t<bool>>(use_expm1), cpp11::as_cpp<cpp11::decay_t<double>>(min_threshold), cpp11::as_cpp<cpp11::decay_t<bool>>(use_log), cpp11::as_cpp<cpp11::decay_t<double>>(log_base), cpp11::as_cpp<cpp11::decay_t<bool>>(use_pseudocount), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(output), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
   END_CPP11
 }
 // cpp11_foldchange.cpp
@@ -40,6 +196,100 @@ extern "C" SEXP _fastde_cpp11_FilterFoldChangeMat(SEXP fc, SEXP pct1, SEXP pct2,
     return cpp11::as_sexp(cpp11_FilterFoldChangeMat(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles_matrix<cpp11::by_column> const &>>(fc), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles_matrix<cpp11::by_column> const &>>(pct1), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles_matrix<cpp11::by_column> const &>>(pct2), cpp11::as_cpp<cpp11::decay_t<cpp11::logicals_matrix<cpp11::by_column> const &>>(init_mask), cpp11::as_cpp<cpp11::decay_t<double>>(min_pct), cpp11::as_cpp<cpp11::decay_t<double>>(min_diff_pct), cpp11::as_cpp<cpp11::decay_t<double>>(logfc_threshold), cpp11::as_cpp<cpp11::decay_t<bool>>(only_pos), cpp11::as_cpp<cpp11::decay_t<bool>>(not_count), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
   END_CPP11
 }
+// cpp11_hvf.cpp
+extern cpp11::writable::list cpp11_sp_vst(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, double const & span, double const & clip_max, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_vst(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP span, SEXP clip_max, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_vst(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<double const &>>(span), cpp11::as_cpp<cpp11::decay_t<double const &>>(clip_max), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_hvf.cpp
+extern cpp11::writable::list cpp11_sp64_vst(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, double const & span, double const & clip_max, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_vst(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP span, SEXP clip_max, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_vst(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<double const &>>(span), cpp11::as_cpp<cpp11::decay_t<double const &>>(clip_max), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_mmap.cpp
+extern void cpp11_spmat_write(std::string const & filename, cpp11::doubles const & x, cpp11::integers const & i, cpp11::sexp const & p, int const & nrow, int const & ncol, cpp11::strings const & rownames, cpp11::strings const & colnames, int const & value_type, int const & index_type, bool const & transposed, int const & threads);
+extern "C" SEXP _fastde_cpp11_spmat_write(SEXP filename, SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP rownames, SEXP colnames, SEXP value_type, SEXP index_type, SEXP transposed, SEXP threads) {
+  BEGIN_CPP11
+    cpp11_spmat_write(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::sexp const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(rownames), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(colnames), cpp11::as_cpp<cpp11::decay_t<int const &>>(value_type), cpp11::as_cpp<cpp11::decay_t<int const &>>(index_type), cpp11::as_cpp<cpp11::decay_t<bool const &>>(transposed), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads));
+    return R_NilValue;
+  END_CPP11
+}
+// cpp11_mmap.cpp
+extern cpp11::external_pointer<spmat_mmap> cpp11_spmat_open(std::string const & filename, bool const & validate, int const & threads);
+extern "C" SEXP _fastde_cpp11_spmat_open(SEXP filename, SEXP validate, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spmat_open(cpp11::as_cpp<cpp11::decay_t<std::string const &>>(filename), cpp11::as_cpp<cpp11::decay_t<bool const &>>(validate), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_mmap.cpp
+extern cpp11::writable::list cpp11_spmat_info(cpp11::external_pointer<spmat_mmap> const & handle);
+extern "C" SEXP _fastde_cpp11_spmat_info(SEXP handle) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spmat_info(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<spmat_mmap> const &>>(handle)));
+  END_CPP11
+}
+// cpp11_mmap.cpp
+extern cpp11::writable::list cpp11_spmat_load(cpp11::external_pointer<spmat_mmap> const & handle, bool const & large, int const & threads);
+extern "C" SEXP _fastde_cpp11_spmat_load(SEXP handle, SEXP large, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spmat_load(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<spmat_mmap> const &>>(handle), cpp11::as_cpp<cpp11::decay_t<bool const &>>(large), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_mmap.cpp
+extern cpp11::writable::list cpp11_spmat_altrep(cpp11::external_pointer<spmat_mmap> const & handle, int const & threads);
+extern "C" SEXP _fastde_cpp11_spmat_altrep(SEXP handle, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spmat_altrep(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<spmat_mmap> const &>>(handle), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_mmap.cpp
+extern void cpp11_spmat_build_transpose(cpp11::external_pointer<spmat_mmap> const & handle, int const & threads);
+extern "C" SEXP _fastde_cpp11_spmat_build_transpose(SEXP handle, SEXP threads) {
+  BEGIN_CPP11
+    cpp11_spmat_build_transpose(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<spmat_mmap> const &>>(handle), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads));
+    return R_NilValue;
+  END_CPP11
+}
+// cpp11_mmap.cpp
+extern void cpp11_spmat_set_cache(cpp11::external_pointer<spmat_mmap> const & handle, double const & budget, double const & block_bytes, int const & prefetch);
+extern "C" SEXP _fastde_cpp11_spmat_set_cache(SEXP handle, SEXP budget, SEXP block_bytes, SEXP prefetch) {
+  BEGIN_CPP11
+    cpp11_spmat_set_cache(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<spmat_mmap> const &>>(handle), cpp11::as_cpp<cpp11::decay_t<double const &>>(budget), cpp11::as_cpp<cpp11::decay_t<double const &>>(block_bytes), cpp11::as_cpp<cpp11::decay_t<int const &>>(prefetch));
+    return R_NilValue;
+  END_CPP11
+}
+// cpp11_mmap.cpp
+extern cpp11::writable::list cpp11_spmat_transpose(cpp11::external_pointer<spmat_mmap> const & handle, int const & threads);
+extern "C" SEXP _fastde_cpp11_spmat_transpose(SEXP handle, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spmat_transpose(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<spmat_mmap> const &>>(handle), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_mmap.cpp
+extern cpp11::writable::list cpp11_spmat_normalize(cpp11::external_pointer<spmat_mmap> const & handle, double const & scale_factor, int const & margin, int const & method, int const & threads);
+extern "C" SEXP _fastde_cpp11_spmat_normalize(SEXP handle, SEXP scale_factor, SEXP margin, SEXP method, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spmat_normalize(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<spmat_mmap> const &>>(handle), cpp11::as_cpp<cpp11::decay_t<double const &>>(scale_factor), cpp11::as_cpp<cpp11::decay_t<int const &>>(margin), cpp11::as_cpp<cpp11::decay_t<int const &>>(method), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_module.cpp
+extern cpp11::writable::list cpp11_sp_module_score(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, cpp11::integers const & module_ids, cpp11::integers const & module_offsets, int const & nbin, int const & ctrl, double const & seed, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_module_score(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP module_ids, SEXP module_offsets, SEXP nbin, SEXP ctrl, SEXP seed, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_module_score(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(module_ids), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(module_offsets), cpp11::as_cpp<cpp11::decay_t<int const &>>(nbin), cpp11::as_cpp<cpp11::decay_t<int const &>>(ctrl), cpp11::as_cpp<cpp11::decay_t<double const &>>(seed), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_module.cpp
+extern cpp11::writable::list cpp11_sp64_module_score(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, cpp11::integers const & module_ids, cpp11::integers const & module_offsets, int const & nbin, int const & ctrl, double const & seed, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_module_score(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP module_ids, SEXP module_offsets, SEXP nbin, SEXP ctrl, SEXP seed, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_module_score(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(module_ids), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(module_offsets), cpp11::as_cpp<cpp11::decay_t<int const &>>(nbin), cpp11::as_cpp<cpp11::decay_t<int const &>>(ctrl), cpp11::as_cpp<cpp11::decay_t<double const &>>(seed), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
 // cpp11_normalize.cpp
 extern cpp11::writable::doubles cpp11_sp_normalize(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, double const & scale_factor, int const & margin, int const & method, int const & threads);
 extern "C" SEXP _fastde_cpp11_sp_normalize(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP scale_factor, SEXP margin, SEXP method, SEXP threads) {
@@ -54,6 +304,134 @@ extern "C" SEXP _fastde_cpp11_sp64_normalize(SEXP x, SEXP i, SEXP p, SEXP nrow,
     return cpp11::as_sexp(cpp11_sp64_normalize(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<double const &>>(scale_factor), cpp11::as_cpp<cpp11::decay_t<int const &>>(margin), cpp11::as_cpp<cpp11::decay_t<int const &>>(method), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
   END_CPP11
 }
+// cpp11_normalize.cpp
+extern void cpp11_sp_normalize_inplace(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, double const & scale_factor, int const & margin, int const & method, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_normalize_inplace(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP scale_factor, SEXP margin, SEXP method, SEXP threads) {
+  BEGIN_CPP11
+    cpp11_sp_normalize_inplace(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<double const &>>(scale_factor), cpp11::as_cpp<cpp11::decay_t<int const &>>(margin), cpp11::as_cpp<cpp11::decay_t<int const &>>(method), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads));
+    return R_NilValue;
+  END_CPP11
+}
+// cpp11_normalize.cpp
+extern void cpp11_sp64_normalize_inplace(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, double const & scale_factor, int const & margin, int const & method, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_normalize_inplace(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP scale_factor, SEXP margin, SEXP method, SEXP threads) {
+  BEGIN_CPP11
+    cpp11_sp64_normalize_inplace(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<double const &>>(scale_factor), cpp11::as_cpp<cpp11::decay_t<int const &>>(margin), cpp11::as_cpp<cpp11::decay_t<int const &>>(method), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads));
+    return R_NilValue;
+  END_CPP11
+}
+// cpp11_normalize.cpp
+extern cpp11::writable::list cpp11_sp_pearson_params(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_pearson_params(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_pearson_params(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_normalize.cpp
+extern cpp11::writable::list cpp11_sp64_pearson_params(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_pearson_params(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_pearson_params(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_normalize.cpp
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp_pearson_to_dense(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip, cpp11::integers const & row_ids, cpp11::integers const & col_ids, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_pearson_to_dense(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP gene_frac, SEXP cell_totals, SEXP theta, SEXP clip, SEXP row_ids, SEXP col_ids, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_pearson_to_dense(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(gene_frac), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(cell_totals), cpp11::as_cpp<cpp11::decay_t<double const &>>(theta), cpp11::as_cpp<cpp11::decay_t<double const &>>(clip), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(row_ids), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(col_ids), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_normalize.cpp
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp64_pearson_to_dense(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip, cpp11::integers const & row_ids, cpp11::integers const & col_ids, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_pearson_to_dense(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP gene_frac, SEXP cell_totals, SEXP theta, SEXP clip, SEXP row_ids, SEXP col_ids, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_pearson_to_dense(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(gene_frac), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(cell_totals), cpp11::as_cpp<cpp11::decay_t<double const &>>(theta), cpp11::as_cpp<cpp11::decay_t<double const &>>(clip), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(row_ids), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(col_ids), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_normalize.cpp
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp_pearson_prod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip, cpp11::doubles_matrix<cpp11::by_column> const & mat, bool const & transpose, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_pearson_prod(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP gene_frac, SEXP cell_totals, SEXP theta, SEXP clip, SEXP mat, SEXP transpose, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_pearson_prod(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(gene_frac), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(cell_totals), cpp11::as_cpp<cpp11::decay_t<double const &>>(theta), cpp11::as_cpp<cpp11::decay_t<double const &>>(clip), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles_matrix<cpp11::by_column> const &>>(mat), cpp11::as_cpp<cpp11::decay_t<bool const &>>(transpose), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_normalize.cpp
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp64_pearson_prod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip, cpp11::doubles_matrix<cpp11::by_column> const & mat, bool const & transpose, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_pearson_prod(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP gene_frac, SEXP cell_totals, SEXP theta, SEXP clip, SEXP mat, SEXP transpose, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_pearson_prod(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(gene_frac), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(cell_totals), cpp11::as_cpp<cpp11::decay_t<double const &>>(theta), cpp11::as_cpp<cpp11::decay_t<double const &>>(clip), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles_matrix<cpp11::by_column> const &>>(mat), cpp11::as_cpp<cpp11::decay_t<bool const &>>(transpose), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_normalize.cpp
+extern cpp11::writable::list cpp11_sp_pearson_var(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_pearson_var(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP gene_frac, SEXP cell_totals, SEXP theta, SEXP clip, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_pearson_var(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(gene_frac), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(cell_totals), cpp11::as_cpp<cpp11::decay_t<double const &>>(theta), cpp11::as_cpp<cpp11::decay_t<double const &>>(clip), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_normalize.cpp
+extern cpp11::writable::list cpp11_sp64_pearson_var(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_pearson_var(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP gene_frac, SEXP cell_totals, SEXP theta, SEXP clip, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_pearson_var(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(gene_frac), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(cell_totals), cpp11::as_cpp<cpp11::decay_t<double const &>>(theta), cpp11::as_cpp<cpp11::decay_t<double const &>>(clip), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_qc.cpp
+extern cpp11::writable::list cpp11_sp_qc_metrics(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & ncol, cpp11::integers const & set_masks, int const & nsets, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_qc_metrics(SEXP x, SEXP i, SEXP p, SEXP ncol, SEXP set_masks, SEXP nsets, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_qc_metrics(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(set_masks), cpp11::as_cpp<cpp11::decay_t<int const &>>(nsets), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_qc.cpp
+extern cpp11::writable::list cpp11_sp64_qc_metrics(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & ncol, cpp11::integers const & set_masks, int const & nsets, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_qc_metrics(SEXP x, SEXP i, SEXP p, SEXP ncol, SEXP set_masks, SEXP nsets, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_qc_metrics(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(set_masks), cpp11::as_cpp<cpp11::decay_t<int const &>>(nsets), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_scale.cpp
+extern cpp11::writable::list cpp11_sp_scale_stats(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, bool const & center, bool const & scale, double const & scale_max, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_scale_stats(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP center, SEXP scale, SEXP scale_max, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_scale_stats(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<bool const &>>(center), cpp11::as_cpp<cpp11::decay_t<bool const &>>(scale), cpp11::as_cpp<cpp11::decay_t<double const &>>(scale_max), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_scale.cpp
+extern cpp11::writable::list cpp11_sp64_scale_stats(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, bool const & center, bool const & scale, double const & scale_max, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_scale_stats(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP center, SEXP scale, SEXP scale_max, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_scale_stats(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<bool const &>>(center), cpp11::as_cpp<cpp11::decay_t<bool const &>>(scale), cpp11::as_cpp<cpp11::decay_t<double const &>>(scale_max), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_scale.cpp
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp_scaled_to_dense(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, cpp11::doubles const & centers, cpp11::doubles const & scales, cpp11::doubles const & clip_max, cpp11::doubles const & offsets, cpp11::integers const & row_ids, cpp11::integers const & col_ids, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_scaled_to_dense(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP centers, SEXP scales, SEXP clip_max, SEXP offsets, SEXP row_ids, SEXP col_ids, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_scaled_to_dense(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(centers), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(scales), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(clip_max), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(offsets), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(row_ids), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(col_ids), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_scale.cpp
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp64_scaled_to_dense(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, cpp11::doubles const & centers, cpp11::doubles const & scales, cpp11::doubles const & clip_max, cpp11::doubles const & offsets, cpp11::integers const & row_ids, cpp11::integers const & col_ids, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_scaled_to_dense(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP centers, SEXP scales, SEXP clip_max, SEXP offsets, SEXP row_ids, SEXP col_ids, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_scaled_to_dense(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(centers), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(scales), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(clip_max), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(offsets), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(row_ids), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(col_ids), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_scale.cpp
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp_scaled_prod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, cpp11::doubles const & centers, cpp11::doubles const & scales, cpp11::doubles const & clip_max, cpp11::doubles const & offsets, cpp11::doubles_matrix<cpp11::by_column> const & mat, bool const & transpose, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp_scaled_prod(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP centers, SEXP scales, SEXP clip_max, SEXP offsets, SEXP mat, SEXP transpose, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp_scaled_prod(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(centers), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(scales), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(clip_max), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(offsets), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles_matrix<cpp11::by_column> const &>>(mat), cpp11::as_cpp<cpp11::decay_t<bool const &>>(transpose), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_scale.cpp
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp64_scaled_prod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, cpp11::doubles const & centers, cpp11::doubles const & scales, cpp11::doubles const & clip_max, cpp11::doubles const & offsets, cpp11::doubles_matrix<cpp11::by_column> const & mat, bool const & transpose, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_scaled_prod(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP centers, SEXP scales, SEXP clip_max, SEXP offsets, SEXP mat, SEXP transpose, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_scaled_prod(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(centers), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(scales), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(clip_max), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(offsets), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles_matrix<cpp11::by_column> const &>>(mat), cpp11::as_cpp<cpp11::decay_t<bool const &>>(transpose), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
 // cpp11_sparsemat.cpp
 extern cpp11::writable::list cpp11_sp_transpose(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, int const & threads);
 extern "C" SEXP _fastde_cpp11_sp_transpose(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP threads) {
@@ -69,6 +447,13 @@ extern "C" SEXP _fastde_cpp11_sp64_transpose(SEXP x, SEXP i, SEXP p, SEXP nrow,
   END_CPP11
 }
 // cpp11_sparsemat.cpp
+extern cpp11::writable::list cpp11_sp64_select(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, cpp11::integers const & sel, bool const & by_rows, int const & threads);
+extern "C" SEXP _fastde_cpp11_sp64_select(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP sel, SEXP by_rows, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sp64_select(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<int const &>>(nrow), cpp11::as_cpp<cpp11::decay_t<int const &>>(ncol), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(sel), cpp11::as_cpp<cpp11::decay_t<bool const &>>(by_rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(threads)));
+  END_CPP11
+}
+// cpp11_sparsemat.cpp
 extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp_to_dense(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, int const & threads);
 extern "C" SEXP _fastde_cpp11_sp_to_dense(SEXP x, SEXP i, SEXP p, SEXP nrow, SEXP ncol, SEXP threads) {
   BEGIN_CPP11
@@ -153,17 +538,31 @@ extern "C" SEXP _fastde_cpp11_dense_ttest(SEXP input, SEXP features, SEXP labels
   END_CPP11
 }
 // cpp11_ttest.cpp
-extern cpp11::sexp cpp11_sparse_ttest(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, int alternative, bool var_equal, bool as_dataframe, int threads);
-extern "C" SEXP _fastde_cpp11_sparse_ttest(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP alternative, SEXP var_equal, SEXP as_dataframe, SEXP threads) {
+extern cpp11::sexp cpp11_sparse_ttest(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, int alternative, bool var_equal, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, int threads);
+extern "C" SEXP _fastde_cpp11_sparse_ttest(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP alternative, SEXP var_equal, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_sparse_ttest(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(alternative), cpp11::as_cpp<cpp11::decay_t<bool>>(var_equal), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+  END_CPP11
+}
+// cpp11_ttest.cpp
+extern cpp11::sexp cpp11_sparse64_ttest(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, int alternative, bool var_equal, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, int threads);
+extern "C" SEXP _fastde_cpp11_sparse64_ttest(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP alternative, SEXP var_equal, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP threads) {
   BEGIN_CPP11
-    return cpp11::as_sexp(cpp11_sparse_ttest(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(alternative), cpp11::as_cpp<cpp11::decay_t<bool>>(var_equal), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+    return cpp11::as_sexp(cpp11_sparse64_ttest(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(alternative), cpp11::as_cpp<cpp11::decay_t<bool>>(var_equal), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
   END_CPP11
 }
 // cpp11_ttest.cpp
-extern cpp11::sexp cpp11_sparse64_ttest(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, int alternative, bool var_equal, bool as_dataframe, int threads);
-extern "C" SEXP _fastde_cpp11_sparse64_ttest(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP alternative, SEXP var_equal, SEXP as_dataframe, SEXP threads) {
+extern cpp11::sexp cpp11_spmat_ttest(cpp11::external_pointer<spmat_mmap> const & handle, cpp11::strings const & features, cpp11::integers const & labels, bool features_as_rows, int alternative, bool var_equal, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, std::string const & output, int threads);
+extern "C" SEXP _fastde_cpp11_spmat_ttest(SEXP handle, SEXP features, SEXP labels, SEXP features_as_rows, SEXP alternative, SEXP var_equal, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP output, SEXP threads) {
   BEGIN_CPP11
-    return cpp11::as_sexp(cpp11_sparse64_ttest(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(alternative), cpp11::as_cpp<cpp11::decay_t<bool>>(var_equal), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+    return cpp11::as_sexp(cpp11_spmat_ttest(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<spmat_mmap> const &>>(handle), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(alternative), cpp11::as_cpp<cpp11::decay_t<bool>>(var_equal), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(output), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+  END_CPP11
+}
+// cpp11_ttest.cpp
+extern cpp11::sexp cpp11_spcat_ttest(cpp11::list const & xs, cpp11::list const & is, cpp11::list const & ps, cpp11::integers const & nrows, cpp11::integers const & ncols, bool by_rows, double const & block_bytes, cpp11::strings const & features, cpp11::integers const & labels, bool features_as_rows, int alternative, bool var_equal, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, std::string const & output, int threads);
+extern "C" SEXP _fastde_cpp11_spcat_ttest(SEXP xs, SEXP is, SEXP ps, SEXP nrows, SEXP ncols, SEXP by_rows, SEXP block_bytes, SEXP features, SEXP labels, SEXP features_as_rows, SEXP alternative, SEXP var_equal, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP output, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spcat_ttest(cpp11::as_cpp<cpp11::decay_t<cpp11::list const &>>(xs), cpp11::as_cpp<cpp11::decay_t<cpp11::list const &>>(is), cpp11::as_cpp<cpp11::decay_t<cpp11::list const &>>(ps), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(nrows), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(ncols), cpp11::as_cpp<cpp11::decay_t<bool>>(by_rows), cpp11::as_cpp<cpp11::decay_t<double const &>>(block_bytes), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(alternative), cpp11::as_cpp<cpp11::decay_t<bool>>(var_equal), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(output), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
   END_CPP11
 }
 // cpp11_wmwtest.cpp
@@ -181,17 +580,17 @@ extern "C" SEXP _fastde_cpp11_dense_wmw_vec(SEXP input, SEXP features, SEXP labe
   END_CPP11
 }
 // cpp11_wmwtest.cpp
-extern cpp11::sexp cpp11_sparse_wmw(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, int rtype, bool continuity_correction, bool as_dataframe, int threads);
-extern "C" SEXP _fastde_cpp11_sparse_wmw(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP rtype, SEXP continuity_correction, SEXP as_dataframe, SEXP threads) {
+extern cpp11::sexp cpp11_sparse_wmw(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, int rtype, bool continuity_correction, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, int threads);
+extern "C" SEXP _fastde_cpp11_sparse_wmw(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP rtype, SEXP continuity_correction, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP threads) {
   BEGIN_CPP11
-    return cpp11::as_sexp(cpp11_sparse_wmw(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(rtype), cpp11::as_cpp<cpp11::decay_t<bool>>(continuity_correction), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+    return cpp11::as_sexp(cpp11_sparse_wmw(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(rtype), cpp11::as_cpp<cpp11::decay_t<bool>>(continuity_correction), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
   END_CPP11
 }
 // cpp11_wmwtest.cpp
-extern cpp11::sexp cpp11_sparse64_wmw(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, int rtype, bool continuity_correction, bool as_dataframe, int threads);
-extern "C" SEXP _fastde_cpp11_sparse64_wmw(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP rtype, SEXP continuity_correction, SEXP as_dataframe, SEXP threads) {
+extern cpp11::sexp cpp11_sparse64_wmw(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, cpp11::strings const & features, int const & rows, int const & cols, cpp11::integers const & labels, bool features_as_rows, int rtype, bool continuity_correction, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, int threads);
+extern "C" SEXP _fastde_cpp11_sparse64_wmw(SEXP x, SEXP i, SEXP p, SEXP features, SEXP rows, SEXP cols, SEXP labels, SEXP features_as_rows, SEXP rtype, SEXP continuity_correction, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP threads) {
   BEGIN_CPP11
-    return cpp11::as_sexp(cpp11_sparse64_wmw(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(rtype), cpp11::as_cpp<cpp11::decay_t<bool>>(continuity_correction), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+    return cpp11::as_sexp(cpp11_sparse64_wmw(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(rtype), cpp11::as_cpp<cpp11::decay_t<bool>>(continuity_correction), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
   END_CPP11
 }
 // cpp11_wmwtest.cpp
@@ -208,44 +607,118 @@ extern "C" SEXP _fastde_cpp11_sparse64_wmw_vec(SEXP x, SEXP i, SEXP p, SEXP feat
     return cpp11::as_sexp(cpp11_sparse64_wmw_vec(cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(i), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(p), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<int const &>>(rows), cpp11::as_cpp<cpp11::decay_t<int const &>>(cols), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(rtype), cpp11::as_cpp<cpp11::decay_t<bool>>(continuity_correction), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
   END_CPP11
 }
+// cpp11_wmwtest.cpp
+extern cpp11::sexp cpp11_spmat_wmw(cpp11::external_pointer<spmat_mmap> const & handle, cpp11::strings const & features, cpp11::integers const & labels, bool features_as_rows, int rtype, bool continuity_correction, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, std::string const & output, int threads);
+extern "C" SEXP _fastde_cpp11_spmat_wmw(SEXP handle, SEXP features, SEXP labels, SEXP features_as_rows, SEXP rtype, SEXP continuity_correction, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP output, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spmat_wmw(cpp11::as_cpp<cpp11::decay_t<cpp11::external_pointer<spmat_mmap> const &>>(handle), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(rtype), cpp11::as_cpp<cpp11::decay_t<bool>>(continuity_correction), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(output), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+  END_CPP11
+}
+// cpp11_wmwtest.cpp
+extern cpp11::sexp cpp11_spcat_wmw(cpp11::list const & xs, cpp11::list const & is, cpp11::list const & ps, cpp11::integers const & nrows, cpp11::integers const & ncols, bool by_rows, double const & block_bytes, cpp11::strings const & features, cpp11::integers const & labels, bool features_as_rows, int rtype, bool continuity_correction, bool as_dataframe, int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums, std::string const & output, int threads);
+extern "C" SEXP _fastde_cpp11_spcat_wmw(SEXP xs, SEXP is, SEXP ps, SEXP nrows, SEXP ncols, SEXP by_rows, SEXP block_bytes, SEXP features, SEXP labels, SEXP features_as_rows, SEXP rtype, SEXP continuity_correction, SEXP as_dataframe, SEXP norm_method, SEXP norm_scale, SEXP norm_sums, SEXP output, SEXP threads) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(cpp11_spcat_wmw(cpp11::as_cpp<cpp11::decay_t<cpp11::list const &>>(xs), cpp11::as_cpp<cpp11::decay_t<cpp11::list const &>>(is), cpp11::as_cpp<cpp11::decay_t<cpp11::list const &>>(ps), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(nrows), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(ncols), cpp11::as_cpp<cpp11::decay_t<bool>>(by_rows), cpp11::as_cpp<cpp11::decay_t<double const &>>(block_bytes), cpp11::as_cpp<cpp11::decay_t<cpp11::strings const &>>(features), cpp11::as_cpp<cpp11::decay_t<cpp11::integers const &>>(labels), cpp11::as_cpp<cpp11::decay_t<bool>>(features_as_rows), cpp11::as_cpp<cpp11::decay_t<int>>(rtype), cpp11::as_cpp<cpp11::decay_t<bool>>(continuity_correction), cpp11::as_cpp<cpp11::decay_t<bool>>(as_dataframe), cpp11::as_cpp<cpp11::decay_t<int const &>>(norm_method), cpp11::as_cpp<cpp11::decay_t<double const &>>(norm_scale), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles const &>>(norm_sums), cpp11::as_cpp<cpp11::decay_t<std::string const &>>(output), cpp11::as_cpp<cpp11::decay_t<int>>(threads)));
+  END_CPP11
+}
 
 extern "C" {
 static const R_CallMethodDef CallEntries[] = {
     {"_fastde_cpp11_ComputeFoldChange",         (DL_FUNC) &_fastde_cpp11_ComputeFoldChange,         12},
-    {"_fastde_cpp11_ComputeFoldChangeSparse",   (DL_FUNC) &_fastde_cpp11_ComputeFoldChangeSparse,   17},
-    {"_fastde_cpp11_ComputeFoldChangeSparse64", (DL_FUNC) &_fastde_cpp11_ComputeFoldChangeSparse64, 17},
+    {"_fastde_cpp11_ComputeFoldChangeSparse",   (DL_FUNC) &_fastde_cpp11_ComputeFoldChangeSparse,   20},
+    {"_fastde_cpp11_ComputeFoldChangeSparse64", (DL_FUNC) &_fastde_cpp11_ComputeFoldChangeSparse64, 20},
     {"_fastde_cpp11_FilterFoldChange",          (DL_FUNC) &_fastde_cpp11_FilterFoldChange,          10},
     {"_fastde_cpp11_FilterFoldChangeMat",       (DL_FUNC) &_fastde_cpp11_FilterFoldChangeMat,       10},
     {"_fastde_cpp11_dense_ttest",               (DL_FUNC) &_fastde_cpp11_dense_ttest,                7},
     {"_fastde_cpp11_dense_wmw",                 (DL_FUNC) &_fastde_cpp11_dense_wmw,                  7},
     {"_fastde_cpp11_dense_wmw_vec",             (DL_FUNC) &_fastde_cpp11_dense_wmw_vec,              7},
+    {"_fastde_cpp11_fast_math_target",          (DL_FUNC) &_fastde_cpp11_fast_math_target,           0},
+    {"_fastde_cpp11_get_math_mode",             (DL_FUNC) &_fastde_cpp11_get_math_mode,              0},
+    {"_fastde_cpp11_h5_attr_doubles",           (DL_FUNC) &_fastde_cpp11_h5_attr_doubles,            3},
+    {"_fastde_cpp11_h5_attr_strings",           (DL_FUNC) &_fastde_cpp11_h5_attr_strings,            3},
+    {"_fastde_cpp11_h5_dims",                   (DL_FUNC) &_fastde_cpp11_h5_dims,                    2},
+    {"_fastde_cpp11_h5_exists",                 (DL_FUNC) &_fastde_cpp11_h5_exists,                  2},
+    {"_fastde_cpp11_h5_is_group",               (DL_FUNC) &_fastde_cpp11_h5_is_group,                2},
+    {"_fastde_cpp11_h5_list_groups",            (DL_FUNC) &_fastde_cpp11_h5_list_groups,             2},
+    {"_fastde_cpp11_h5_read_dense_sparse",      (DL_FUNC) &_fastde_cpp11_h5_read_dense_sparse,       5},
+    {"_fastde_cpp11_h5_read_doubles",           (DL_FUNC) &_fastde_cpp11_h5_read_doubles,            3},
+    {"_fastde_cpp11_h5_read_sparse",            (DL_FUNC) &_fastde_cpp11_h5_read_sparse,             6},
+    {"_fastde_cpp11_h5_read_sparse_filtered",   (DL_FUNC) &_fastde_cpp11_h5_read_sparse_filtered,   12},
+    {"_fastde_cpp11_h5_read_strings",           (DL_FUNC) &_fastde_cpp11_h5_read_strings,            2},
+    {"_fastde_cpp11_h5_write_10x",              (DL_FUNC) &_fastde_cpp11_h5_write_10x,              12},
+    {"_fastde_cpp11_mtx_read_sparse",           (DL_FUNC) &_fastde_cpp11_mtx_read_sparse,            3},
+    {"_fastde_cpp11_set_math_mode",             (DL_FUNC) &_fastde_cpp11_set_math_mode,              1},
     {"_fastde_cpp11_sp64_cbind",                (DL_FUNC) &_fastde_cpp11_sp64_cbind,                 7},
     {"_fastde_cpp11_sp64_colSums",              (DL_FUNC) &_fastde_cpp11_sp64_colSums,               4},
+    {"_fastde_cpp11_sp64_downsample",           (DL_FUNC) &_fastde_cpp11_sp64_downsample,            8},
+    {"_fastde_cpp11_sp64_module_score",         (DL_FUNC) &_fastde_cpp11_sp64_module_score,         11},
     {"_fastde_cpp11_sp64_normalize",            (DL_FUNC) &_fastde_cpp11_sp64_normalize,             9},
+    {"_fastde_cpp11_sp64_normalize_inplace",    (DL_FUNC) &_fastde_cpp11_sp64_normalize_inplace,     9},
+    {"_fastde_cpp11_sp64_pearson_params",       (DL_FUNC) &_fastde_cpp11_sp64_pearson_params,        6},
+    {"_fastde_cpp11_sp64_pearson_prod",         (DL_FUNC) &_fastde_cpp11_sp64_pearson_prod,         12},
+    {"_fastde_cpp11_sp64_pearson_to_dense",     (DL_FUNC) &_fastde_cpp11_sp64_pearson_to_dense,     11},
+    {"_fastde_cpp11_sp64_pearson_var",          (DL_FUNC) &_fastde_cpp11_sp64_pearson_var,          10},
+    {"_fastde_cpp11_sp64_qc_metrics",           (DL_FUNC) &_fastde_cpp11_sp64_qc_metrics,            7},
     {"_fastde_cpp11_sp64_rbind",                (DL_FUNC) &_fastde_cpp11_sp64_rbind,                 7},
+    {"_fastde_cpp11_sp64_scale_stats",          (DL_FUNC) &_fastde_cpp11_sp64_scale_stats,           9},
+    {"_fastde_cpp11_sp64_scaled_prod",          (DL_FUNC) &_fastde_cpp11_sp64_scaled_prod,          12},
+    {"_fastde_cpp11_sp64_scaled_to_dense",      (DL_FUNC) &_fastde_cpp11_sp64_scaled_to_dense,      11},
+    {"_fastde_cpp11_sp64_select",               (DL_FUNC) &_fastde_cpp11_sp64_select,                8},
     {"_fastde_cpp11_sp64_to_dense",             (DL_FUNC) &_fastde_cpp11_sp64_to_dense,              6},
     {"_fastde_cpp11_sp64_to_dense_transposed",  (DL_FUNC) &_fastde_cpp11_sp64_to_dense_transposed,   6},
     {"_fastde_cpp11_sp64_transpose",            (DL_FUNC) &_fastde_cpp11_sp64_transpose,             6},
+    {"_fastde_cpp11_sp64_vst",                  (DL_FUNC) &_fastde_cpp11_sp64_vst,                   8},
     {"_fastde_cpp11_sp_cbind",                  (DL_FUNC) &_fastde_cpp11_sp_cbind,                   7},
     {"_fastde_cpp11_sp_colSums",                (DL_FUNC) &_fastde_cpp11_sp_colSums,                 4},
+    {"_fastde_cpp11_sp_downsample",             (DL_FUNC) &_fastde_cpp11_sp_downsample,              8},
+    {"_fastde_cpp11_sp_module_score",           (DL_FUNC) &_fastde_cpp11_sp_module_score,           11},
     {"_fastde_cpp11_sp_normalize",              (DL_FUNC) &_fastde_cpp11_sp_normalize,               9},
+    {"_fastde_cpp11_sp_normalize_inplace",      (DL_FUNC) &_fastde_cpp11_sp_normalize_inplace,       9},
+    {"_fastde_cpp11_sp_pearson_params",         (DL_FUNC) &_fastde_cpp11_sp_pearson_params,          6},
+    {"_fastde_cpp11_sp_pearson_prod",           (DL_FUNC) &_fastde_cpp11_sp_pearson_prod,           12},
+    {"_fastde_cpp11_sp_pearson_to_dense",       (DL_FUNC) &_fastde_cpp11_sp_pearson_to_dense,       11},
+    {"_fastde_cpp11_sp_pearson_var",            (DL_FUNC) &_fastde_cpp11_sp_pearson_var,            10},
+    {"_fastde_cpp11_sp_qc_metrics",             (DL_FUNC) &_fastde_cpp11_sp_qc_metrics,              7},
     {"_fastde_cpp11_sp_rbind",                  (DL_FUNC) &_fastde_cpp11_sp_rbind,                   7},
     {"_fastde_cpp11_sp_rowSums",                (DL_FUNC) &_fastde_cpp11_sp_rowSums,                 5},
+    {"_fastde_cpp11_sp_scale_stats",            (DL_FUNC) &_fastde_cpp11_sp_scale_stats,             9},
+    {"_fastde_cpp11_sp_scaled_prod",            (DL_FUNC) &_fastde_cpp11_sp_scaled_prod,            12},
+    {"_fastde_cpp11_sp_scaled_to_dense",        (DL_FUNC) &_fastde_cpp11_sp_scaled_to_dense,        11},
     {"_fastde_cpp11_sp_to_dense",               (DL_FUNC) &_fastde_cpp11_sp_to_dense,                6},
     {"_fastde_cpp11_sp_to_dense_transposed",    (DL_FUNC) &_fastde_cpp11_sp_to_dense_transposed,     6},
     {"_fastde_cpp11_sp_transpose",              (DL_FUNC) &_fastde_cpp11_sp_transpose,               6},
-    {"_fastde_cpp11_sparse64_ttest",            (DL_FUNC) &_fastde_cpp11_sparse64_ttest,            12},
-    {"_fastde_cpp11_sparse64_wmw",              (DL_FUNC) &_fastde_cpp11_sparse64_wmw,              12},
+    {"_fastde_cpp11_sp_vst",                    (DL_FUNC) &_fastde_cpp11_sp_vst,                     8},
+    {"_fastde_cpp11_sparse64_ttest",            (DL_FUNC) &_fastde_cpp11_sparse64_ttest,            15},
+    {"_fastde_cpp11_sparse64_wmw",              (DL_FUNC) &_fastde_cpp11_sparse64_wmw,              15},
     {"_fastde_cpp11_sparse64_wmw_vec",          (DL_FUNC) &_fastde_cpp11_sparse64_wmw_vec,          12},
-    {"_fastde_cpp11_sparse_ttest",              (DL_FUNC) &_fastde_cpp11_sparse_ttest,              12},
-    {"_fastde_cpp11_sparse_wmw",                (DL_FUNC) &_fastde_cpp11_sparse_wmw,                12},
+    {"_fastde_cpp11_sparse_ttest",              (DL_FUNC) &_fastde_cpp11_sparse_ttest,              15},
+    {"_fastde_cpp11_sparse_wmw",                (DL_FUNC) &_fastde_cpp11_sparse_wmw,                15},
     {"_fastde_cpp11_sparse_wmw_vec",            (DL_FUNC) &_fastde_cpp11_sparse_wmw_vec,            12},
+    {"_fastde_cpp11_spcat_foldchange",          (DL_FUNC) &_fastde_cpp11_spcat_foldchange,          23},
+    {"_fastde_cpp11_spcat_ttest",               (DL_FUNC) &_fastde_cpp11_spcat_ttest,               18},
+    {"_fastde_cpp11_spcat_wmw",                 (DL_FUNC) &_fastde_cpp11_spcat_wmw,                 18},
+    {"_fastde_cpp11_spmat_altrep",              (DL_FUNC) &_fastde_cpp11_spmat_altrep,               2},
+    {"_fastde_cpp11_spmat_build_transpose",     (DL_FUNC) &_fastde_cpp11_spmat_build_transpose,      2},
+    {"_fastde_cpp11_spmat_foldchange",          (DL_FUNC) &_fastde_cpp11_spmat_foldchange,          17},
+    {"_fastde_cpp11_spmat_info",                (DL_FUNC) &_fastde_cpp11_spmat_info,                 1},
+    {"_fastde_cpp11_spmat_load",                (DL_FUNC) &_fastde_cpp11_spmat_load,                 3},
+    {"_fastde_cpp11_spmat_normalize",           (DL_FUNC) &_fastde_cpp11_spmat_normalize,            5},
+    {"_fastde_cpp11_spmat_open",                (DL_FUNC) &_fastde_cpp11_spmat_open,                 3},
+    {"_fastde_cpp11_spmat_set_cache",           (DL_FUNC) &_fastde_cpp11_spmat_set_cache,            4},
+    {"_fastde_cpp11_spmat_transpose",           (DL_FUNC) &_fastde_cpp11_spmat_transpose,            2},
+    {"_fastde_cpp11_spmat_ttest",               (DL_FUNC) &_fastde_cpp11_spmat_ttest,               12},
+    {"_fastde_cpp11_spmat_wmw",                 (DL_FUNC) &_fastde_cpp11_spmat_wmw,                 12},
+    {"_fastde_cpp11_spmat_write",               (DL_FUNC) &_fastde_cpp11_spmat_write,               12},
+    {"_fastde_cpp11_vec_expm1",                 (DL_FUNC) &_fastde_cpp11_vec_expm1,                  1},
+    {"_fastde_cpp11_vec_log1p",                 (DL_FUNC) &_fastde_cpp11_vec_log1p,                  1},
     {NULL, NULL, 0}
 };
 }
 
+void fastde_init_altrep(DllInfo* dll);
 extern "C" attribute_visible void R_init_fastde(DllInfo* dll){
   R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
   R_useDynamicSymbols(dll, FALSE);
+  fastde_init_altrep(dll);
   R_forceSymbols(dll, TRUE);
 }
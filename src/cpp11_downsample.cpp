@@ -0,0 +1,59 @@
+#include <vector>
+#include <cstdint>
+
+#include <cpp11/sexp.hpp>
+#include <cpp11/list.hpp>
+#include <cpp11/named_arg.hpp>
+#include <cpp11/integers.hpp>
+#include <cpp11/doubles.hpp>
+
+#include "utils_downsample.hpp"
+
+// method:  0 = binomial, 1 = hypergeometric.  targets: 1 or ncol values.
+template <typename PT>
+extern cpp11::writable::list _sp_downsample(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::r_vector<PT> const & p, int const & ncol,
+    cpp11::doubles const & targets, int const & method, double const & seed, int const & threads) {
+
+    size_t nelem = x.size();
+
+    // sample into scratch space aligned with the input.
+    std::vector<double> xs(nelem);
+    std::vector<int> is(nelem);
+    std::vector<size_t> counts(ncol);
+    csc_downsample_cols(x, i, p, ncol, targets, method, static_cast<uint64_t>(seed), 
+        xs.data(), is.data(), counts.data(), threads);
+
+    cpp11::writable::r_vector<PT> tp(ncol + 1);
+    size_t nz = 0;
+    tp[0] = 0;
+    for (int c = 0; c < ncol; ++c) {
+        nz += counts[c];
+        tp[c + 1] = nz;
+    }
+
+    cpp11::writable::doubles tx(nz);
+    cpp11::writable::integers ti(nz);
+    csc_compact_cols(xs.data(), is.data(), p, tp, ncol, tx, ti, threads);
+
+    cpp11::named_arg _tx("x"); _tx = tx;
+    cpp11::named_arg _ti("i"); _ti = ti;
+    cpp11::named_arg _tp("p"); _tp = tp;
+    cpp11::writable::list out( { _tx, _ti, _tp} );
+    return out;
+}
+
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp_downsample(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & ncol,
+    cpp11::doubles const & targets, int const & method, double const & seed, int const & threads) {
+    return _sp_downsample(x, i, p, ncol, targets, method, seed, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp64_downsample(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & ncol,
+    cpp11::doubles const & targets, int const & method, double const & seed, int const & threads) {
+    return _sp_downsample(x, i, p, ncol, targets, method, seed, threads);
+}
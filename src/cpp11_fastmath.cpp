@@ -0,0 +1,36 @@
+#include <string>
+
+#include <cpp11/sexp.hpp>
+#include <cpp11/doubles.hpp>
+
+#include "utils_fastmath.hpp"
+
+// mode:  0 = strict, 1 = fast.  returns the previous mode.
+[[cpp11::register]]
+extern int cpp11_set_math_mode(int const & mode) {
+    return set_math_mode(mode);
+}
+
+[[cpp11::register]]
+extern int cpp11_get_math_mode() {
+    return get_math_mode();
+}
+
+[[cpp11::register]]
+extern std::string cpp11_fast_math_target() {
+    return std::string(fast_math_target());
+}
+
+[[cpp11::register]]
+extern cpp11::writable::doubles cpp11_vec_log1p(cpp11::doubles const & x) {
+    cpp11::writable::doubles out(x.size());
+    vec_log1p(REAL(x), x.size(), REAL(out));
+    return out;
+}
+
+[[cpp11::register]]
+extern cpp11::writable::doubles cpp11_vec_expm1(cpp11::doubles const & x) {
+    cpp11::writable::doubles out(x.size());
+    vec_expm1(REAL(x), x.size(), REAL(out));
+    return out;
+}
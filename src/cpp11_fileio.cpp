@@ -0,0 +1,361 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <exception>
+
+#include <cpp11/sexp.hpp>
+#include <cpp11/list.hpp>
+#include <cpp11/named_arg.hpp>
+#include <cpp11/strings.hpp>
+#include <cpp11/integers.hpp>
+#include <cpp11/doubles.hpp>
+
+#include "utils_h5.hpp"
+#include "utils_mtx.hpp"
+
+
+[[cpp11::register]]
+extern bool cpp11_h5_exists(std::string const & filename, std::string const & path) {
+    h5_id file(h5_open_file(filename), H5Fclose);
+    return h5_exists(file, path);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::strings cpp11_h5_list_groups(std::string const & filename, std::string const & path) {
+    h5_id file(h5_open_file(filename), H5Fclose);
+    std::vector<std::string> names = h5_list_groups(file, path);
+    cpp11::writable::strings out(names.size());
+    for (size_t k = 0; k < names.size(); ++k) out[k] = names[k];
+    return out;
+}
+
+[[cpp11::register]]
+extern cpp11::writable::strings cpp11_h5_read_strings(std::string const & filename, std::string const & path) {
+    h5_id file(h5_open_file(filename), H5Fclose);
+    std::vector<std::string> vals = h5_read_strings(file, path);
+    cpp11::writable::strings out(vals.size());
+    for (size_t k = 0; k < vals.size(); ++k) out[k] = vals[k];
+    return out;
+}
+
+[[cpp11::register]]
+extern bool cpp11_h5_is_group(std::string const & filename, std::string const & path) {
+    h5_id file(h5_open_file(filename), H5Fclose);
+    return h5_is_group(file, path);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::doubles cpp11_h5_dims(std::string const & filename, std::string const & path) {
+    h5_id file(h5_open_file(filename), H5Fclose);
+    std::vector<size_t> dims = h5_dims(file, path);
+    cpp11::writable::doubles out(dims.size());
+    for (size_t k = 0; k < dims.size(); ++k) out[k] = dims[k];
+    return out;
+}
+
+// empty if the attribute does not exist.
+[[cpp11::register]]
+extern cpp11::writable::strings cpp11_h5_attr_strings(std::string const & filename, std::string const & path, std::string const & name) {
+    h5_id file(h5_open_file(filename), H5Fclose);
+    std::vector<std::string> vals;
+    if (h5_attr_exists(file, path, name)) vals = h5_read_attr_strings(file, path, name);
+    cpp11::writable::strings out(vals.size());
+    for (size_t k = 0; k < vals.size(); ++k) out[k] = vals[k];
+    return out;
+}
+
+// empty if the attribute does not exist.
+[[cpp11::register]]
+extern cpp11::writable::doubles cpp11_h5_attr_doubles(std::string const & filename, std::string const & path, std::string const & name) {
+    h5_id file(h5_open_file(filename), H5Fclose);
+    std::vector<double> vals;
+    if (h5_attr_exists(file, path, name)) vals = h5_read_attr_doubles(file, path, name);
+    cpp11::writable::doubles out(vals.size());
+    std::copy(vals.begin(), vals.end(), REAL(out));
+    return out;
+}
+
+[[cpp11::register]]
+extern cpp11::writable::doubles cpp11_h5_read_doubles(std::string const & filename, std::string const & path, int const & threads) {
+    h5_id file(h5_open_file(filename), H5Fclose);
+    size_t len = h5_length(file, path);
+    cpp11::writable::doubles out(len);
+    h5_read_1d(file, path, 0, len, REAL(out), threads);
+    return out;
+}
+
+// compressed sparse matrix from its three 1D datasets.  each output vector is allocated once and filled
+// directly from the file.  large:  p returned as doubles (dgCMatrix64), otherwise as integers.
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_h5_read_sparse(std::string const & filename, 
+    std::string const & x_path, std::string const & i_path, std::string const & p_path,
+    bool const & large, int const & threads) {
+
+    h5_id file(h5_open_file(filename), H5Fclose);
+    size_t nnz = h5_length(file, x_path);
+    if (h5_length(file, i_path) != nnz) cpp11::stop("%s and %s have different lengths", x_path.c_str(), i_path.c_str());
+    size_t np = h5_length(file, p_path);
+    if (np == 0) cpp11::stop("%s is empty", p_path.c_str());
+    if (!large && nnz > 2147483647UL) cpp11::stop("%.0f non-zero elements do not fit in a dgCMatrix", static_cast<double>(nnz));
+
+    cpp11::writable::doubles x(static_cast<R_xlen_t>(nnz));
+    cpp11::writable::integers i(static_cast<R_xlen_t>(nnz));
+    h5_read_1d(file, x_path, 0, nnz, REAL(x), threads);
+    h5_read_1d(file, i_path, 0, nnz, INTEGER(i), threads);
+
+    cpp11::named_arg _tx("x"); _tx = x;
+    cpp11::named_arg _ti("i"); _ti = i;
+    cpp11::named_arg _tp("p");
+    if (large) {
+        cpp11::writable::doubles p(static_cast<R_xlen_t>(np));
+        h5_read_1d(file, p_path, 0, np, REAL(p), threads);
+        if (static_cast<size_t>(REAL(p)[np - 1]) != nnz) cpp11::stop("%s does not end at the number of non-zeros", p_path.c_str());
+        _tp = p;
+    } else {
+        cpp11::writable::integers p(static_cast<R_xlen_t>(np));
+        h5_read_1d(file, p_path, 0, np, INTEGER(p), threads);
+        if (static_cast<size_t>(INTEGER(p)[np - 1]) != nnz) cpp11::stop("%s does not end at the number of non-zeros", p_path.c_str());
+        _tp = p;
+    }
+    cpp11::writable::list out( {_tx, _ti, _tp} );
+    return out;
+}
+
+// filtered compressed sparse column matrix (genes x cells, 10X).  only the selected columns are read, and only the
+// kept entries are allocated.  cols, rows:  0-based ids to consider, ascending;  empty for all.  filters, as in 
+// Seurat's CreateSeuratObject:  columns with fewer than min_features entries or min_counts total are dropped, 
+// counted over the considered rows;  then rows present in fewer than min_cells of the kept columns.
+// returns x, i, p, and the 1-based ids of the kept rows and columns.
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_h5_read_sparse_filtered(std::string const & filename, 
+    std::string const & x_path, std::string const & i_path, std::string const & p_path, int const & nrow,
+    cpp11::integers const & cols, cpp11::integers const & rows, 
+    double const & min_features, double const & min_counts, double const & min_cells,
+    bool const & large, int const & threads) {
+
+    h5_id file(h5_open_file(filename), H5Fclose);
+    size_t nnz = h5_length(file, x_path);
+    if (h5_length(file, i_path) != nnz) cpp11::stop("%s and %s have different lengths", x_path.c_str(), i_path.c_str());
+    size_t np = h5_length(file, p_path);
+    if (np == 0) cpp11::stop("%s is empty", p_path.c_str());
+    size_t ncol = np - 1;
+
+    std::vector<long> p(np);
+    h5_read_1d(file, p_path, 0, np, p.data(), threads);
+    if ((p[0] != 0) || (static_cast<size_t>(p[ncol]) != nnz)) cpp11::stop("%s does not span the non-zeros", p_path.c_str());
+
+    // ---- candidate columns and rows.
+    std::vector<size_t> cids;
+    if (cols.size() == 0) {
+        cids.resize(ncol);
+        for (size_t c = 0; c < ncol; ++c) cids[c] = c;
+    } else {
+        cids.reserve(cols.size());
+        for (auto c : cols) {
+            if ((c < 0) || (static_cast<size_t>(c) >= ncol) || (!cids.empty() && static_cast<size_t>(c) <= cids.back()))
+                cpp11::stop("column ids must be ascending and within the matrix");
+            cids.push_back(c);
+        }
+    }
+    std::vector<int> rowmap;
+    if (rows.size() > 0) {
+        rowmap.assign(nrow, -1);
+        int prev = -1;
+        for (auto r : rows) {
+            if ((r <= prev) || (r >= nrow)) cpp11::stop("row ids must be ascending and within the matrix");
+            rowmap[r] = 0;
+            prev = r;
+        }
+    }
+
+    // ---- cells:  entry counts from indptr (or the indices, if rows are selected), totals from the data.
+    std::vector<size_t> counts(cids.size());
+    std::vector<double> sums;
+    if ((min_features > 0) || (min_counts > 0)) {
+        if (min_counts > 0) sums.resize(cids.size());
+        h5_csc_column_stats(file, x_path, i_path, p.data(), cids, rowmap, counts.data(), 
+            min_counts > 0 ? sums.data() : NULL, threads);
+        size_t k = 0;
+        for (size_t j = 0; j < cids.size(); ++j) {
+            if (counts[j] < min_features) continue;
+            if ((min_counts > 0) && (sums[j] < min_counts)) continue;
+            cids[k] = cids[j];
+            ++k;
+        }
+        cids.resize(k);
+    }
+
+    // ---- genes:  per-row count prepass over the kept cells.
+    if (min_cells > 0) {
+        std::vector<size_t> rcounts(nrow);
+        h5_csc_row_counts(file, i_path, p.data(), cids, nrow, rcounts.data(), threads);
+        if (rowmap.empty()) rowmap.assign(nrow, 0);
+        for (int r = 0; r < nrow; ++r) {
+            if (rcounts[r] < min_cells) rowmap[r] = -1;
+        }
+    }
+    std::vector<int> rids;
+    if (!rowmap.empty()) {
+        for (int r = 0; r < nrow; ++r) {
+            if (rowmap[r] < 0) continue;
+            rowmap[r] = rids.size();
+            rids.push_back(r + 1);
+        }
+    }
+
+    // ---- output sizes, then read only what is kept.
+    counts.resize(cids.size());
+    h5_csc_column_stats(file, x_path, i_path, p.data(), cids, rowmap, counts.data(), NULL, threads);
+    std::vector<size_t> offsets(cids.size() + 1, 0);
+    for (size_t j = 0; j < cids.size(); ++j) offsets[j + 1] = offsets[j] + counts[j];
+    size_t onnz = offsets.back();
+    if (!large && onnz > 2147483647UL) cpp11::stop("%.0f non-zero elements do not fit in a dgCMatrix", static_cast<double>(onnz));
+
+    cpp11::writable::doubles x(static_cast<R_xlen_t>(onnz));
+    cpp11::writable::integers i(static_cast<R_xlen_t>(onnz));
+    h5_read_csc_filtered(file, x_path, i_path, p.data(), cids, rowmap, offsets.data(), REAL(x), INTEGER(i), threads);
+
+    cpp11::named_arg _tx("x"); _tx = x;
+    cpp11::named_arg _ti("i"); _ti = i;
+    cpp11::named_arg _tp("p");
+    if (large) {
+        cpp11::writable::doubles op(static_cast<R_xlen_t>(offsets.size()));
+        std::copy(offsets.begin(), offsets.end(), REAL(op));
+        _tp = op;
+    } else {
+        cpp11::writable::integers op(static_cast<R_xlen_t>(offsets.size()));
+        std::copy(offsets.begin(), offsets.end(), INTEGER(op));
+        _tp = op;
+    }
+    cpp11::writable::integers ocols(static_cast<R_xlen_t>(cids.size()));
+    for (size_t j = 0; j < cids.size(); ++j) ocols[j] = cids[j] + 1;
+    cpp11::writable::integers orows(static_cast<R_xlen_t>(rowmap.empty() ? nrow : rids.size()));
+    for (R_xlen_t r = 0; r < orows.size(); ++r) orows[r] = rowmap.empty() ? r + 1 : rids[r];
+    cpp11::named_arg _tc("cols"); _tc = ocols;
+    cpp11::named_arg _tr("rows"); _tr = orows;
+    cpp11::writable::list out( {_tx, _ti, _tp, _tr, _tc} );
+    return out;
+}
+
+// sparsify a dense 2D dataset.  cols_are_rows:  HDF5 rows become the output columns.
+// p is returned as integers if the non-zeros fit in a dgCMatrix and large is false.
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_h5_read_dense_sparse(std::string const & filename, std::string const & path,
+    bool const & cols_are_rows, bool const & large, int const & threads) {
+
+    h5_id file(h5_open_file(filename), H5Fclose);
+    std::vector<long> vp;
+    size_t nrow, ncol;
+    h5_count_dense_csc(file, path, cols_are_rows, vp, nrow, ncol, threads);
+
+    cpp11::writable::doubles x(static_cast<R_xlen_t>(vp.back()));
+    cpp11::writable::integers i(static_cast<R_xlen_t>(vp.back()));
+    h5_read_dense_csc(file, path, cols_are_rows, vp.data(), REAL(x), INTEGER(i), threads);
+
+    cpp11::named_arg _tx("x"); _tx = x;
+    cpp11::named_arg _ti("i"); _ti = i;
+    cpp11::named_arg _tp("p");
+    if (large || (vp.back() > 2147483647L)) {
+        cpp11::writable::doubles p(static_cast<R_xlen_t>(vp.size()));
+        std::copy(vp.begin(), vp.end(), REAL(p));
+        _tp = p;
+    } else {
+        cpp11::writable::integers p(static_cast<R_xlen_t>(vp.size()));
+        std::copy(vp.begin(), vp.end(), INTEGER(p));
+        _tp = p;
+    }
+    cpp11::writable::integers dim(2);
+    dim[0] = nrow;
+    dim[1] = ncol;
+    cpp11::named_arg _td("Dim"); _td = dim;
+    cpp11::writable::list out( {_tx, _ti, _tp, _td} );
+    return out;
+}
+
+// 10X CellRanger (v2 layout) sparse matrix group.  data, indices and indptr are written in chunks of chunk elements,
+// compressed by the threads at level (0 for uncompressed).  indptr is stored as int64, as CellRanger does, 
+// from either integer (dgCMatrix) or double (dgCMatrix64) p.  empty names are not written.
+[[cpp11::register]]
+extern void cpp11_h5_write_10x(std::string const & filename, std::string const & group,
+    cpp11::doubles const & x, cpp11::integers const & i, cpp11::sexp const & p, cpp11::integers const & dim,
+    std::string const & feature_slot, cpp11::strings const & features, cpp11::strings const & barcodes,
+    int const & chunk, int const & level, int const & threads) {
+
+    if (i.size() != x.size()) cpp11::stop("x and i have different lengths");
+    h5_id file(h5_create_file(filename), H5Fclose);
+    h5_id grp(h5_create_group(file, group), H5Gclose);
+
+    h5_write_1d<double, double>(grp, "data", REAL(x), x.size(), chunk, level, threads);
+    h5_write_1d<int, int32_t>(grp, "indices", INTEGER(i), i.size(), chunk, level, threads);
+    if (TYPEOF(p) == REALSXP) 
+        h5_write_1d<double, int64_t>(grp, "indptr", REAL(p), Rf_xlength(p), chunk, level, threads);
+    else if (TYPEOF(p) == INTSXP) 
+        h5_write_1d<int, int64_t>(grp, "indptr", INTEGER(p), Rf_xlength(p), chunk, level, threads);
+    else cpp11::stop("p must be integer or double");
+    h5_write_1d<int, int32_t>(grp, "shape", INTEGER(dim), dim.size(), dim.size(), 0, 1);
+
+    std::vector<std::string> names;
+    if (features.size() > 0) {
+        names.assign(features.begin(), features.end());
+        h5_write_strings(grp, feature_slot, names, level);
+    }
+    if (barcodes.size() > 0) {
+        names.assign(barcodes.begin(), barcodes.end());
+        h5_write_strings(grp, "barcodes", names, level);
+    }
+}
+
+// Matrix Market coordinate file (plain or gzip), read directly into CSC.
+// p is returned as doubles (dgCMatrix64) if large or if the non-zeros exceed 2^31-1, otherwise as integers.
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_mtx_read_sparse(std::string const & filename, bool const & large, int const & threads) {
+
+    mtx_header header;
+    gzFile file = mtx_open(filename, header);
+    if (header.nrow > 2147483647UL || header.ncol > 2147483647UL) {
+        gzclose(file);
+        cpp11::stop("%s:  dimensions exceed 2^31-1", filename.c_str());
+    }
+    bool is_large = large || (header.nnz > 2147483647UL);
+
+    cpp11::writable::doubles x(static_cast<R_xlen_t>(header.nnz));
+    cpp11::writable::integers i(static_cast<R_xlen_t>(header.nnz));
+    cpp11::named_arg _tx("x");
+    cpp11::named_arg _ti("i");
+    cpp11::named_arg _tp("p");
+    size_t nnz = 0;
+    try {
+        if (is_large) {
+            cpp11::writable::doubles p(static_cast<R_xlen_t>(header.ncol + 1));
+            nnz = mtx_read_csc(file, header, REAL(x), INTEGER(i), REAL(p), threads);
+            _tp = p;
+        } else {
+            cpp11::writable::integers p(static_cast<R_xlen_t>(header.ncol + 1));
+            nnz = mtx_read_csc(file, header, REAL(x), INTEGER(i), INTEGER(p), threads);
+            _tp = p;
+        }
+    } catch (std::exception const & e) {
+        gzclose(file);
+        cpp11::stop("%s:  %s", filename.c_str(), e.what());
+    }
+    gzclose(file);
+    if (nnz < header.nnz) {
+        // repeated entries were summed:  copies of the leading entries.
+        cpp11::writable::doubles sx(static_cast<R_xlen_t>(nnz));
+        cpp11::writable::integers si(static_cast<R_xlen_t>(nnz));
+        std::copy(REAL(x), REAL(x) + nnz, REAL(sx));
+        std::copy(INTEGER(i), INTEGER(i) + nnz, INTEGER(si));
+        _tx = sx;
+        _ti = si;
+    } else {
+        _tx = x;
+        _ti = i;
+    }
+
+    cpp11::writable::integers dim(2);
+    dim[0] = header.nrow;
+    dim[1] = header.ncol;
+    cpp11::named_arg _td("Dim"); _td = dim;
+    cpp11::writable::list out( {_tx, _ti, _tp, _td} );
+    return out;
+}
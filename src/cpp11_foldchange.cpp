@@ -2,6 +2,8 @@
 
 #include <chrono>
 
+#include <omp.h>
+
 #include <cpp11/sexp.hpp>
 #include <cpp11/matrix.hpp>
 #include <cpp11/strings.hpp>
@@ -11,6 +13,13 @@
 #include "utils_data.hpp"
 #include "fastde/benchmark_utils.hpp"
 #include "utils_sparsemat.hpp"
+#include "utils_normalize.hpp"
+#include "utils_fastmath.hpp"
+#include "utils_mmap.hpp"
+#include "utils_altrep.hpp"
+#include "utils_concat.hpp"
+#include "utils_sink.hpp"
+#include <cpp11/external_pointer.hpp>
 
 
 [[cpp11::register]]
@@ -102,6 +111,7 @@ extern cpp11::sexp _compute_foldchange_sparse(
   bool use_expm1, double min_threshold, 
   bool use_log, double log_base, bool use_pseudocount, 
   bool as_dataframe,
+  int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
   int threads) {
 
     using PT2 = typename std::conditional<std::is_same<PT, double>::value, long, int>::type;
@@ -137,6 +147,27 @@ extern cpp11::sexp _compute_foldchange_sparse(
   }
   // Rprintf("Sparse DIM: samples %lu x features %lu, non-zeros %lu\n", nsamples, nfeatures, nelem); 
 
+  // ---- on-the-fly normalization of the working copy.  rows are samples now.
+  if (norm_method >= 0) {
+    csc_normalize_by_row_inplace(x, i, nelem, norm_method, norm_scale, norm_sums, threads);
+  }
+
+  // ---- expm1 on the working copy with the vectorized kernel, instead of per element in the summary.
+  // only when the percent threshold is 0, since x > 0 iff expm1(x) > 0.
+  if (use_expm1 && (min_threshold == 0.0) && (get_math_mode() == MATH_FAST)) {
+#pragma omp parallel num_threads(threads)
+    {
+      int tid = omp_get_thread_num();
+      size_t block = nelem / threads;
+      int rem = nelem - threads * block;
+      size_t offset = tid * block + (tid > rem ? rem : tid);
+      int nid = tid + 1;
+      size_t end = nid * block + (nid > rem ? rem : nid);
+      vec_expm1(x + offset, end - offset, x + offset);
+    }
+    use_expm1 = false;
+  }
+
   // ---- label vector
   int * lab = reinterpret_cast<int *>(malloc(nsamples * sizeof(int)));
   copy_rvector_to_cppvector(labels, lab, nsamples);
@@ -209,10 +240,11 @@ extern cpp11::sexp cpp11_ComputeFoldChangeSparse(
   bool use_expm1, double min_threshold, 
   bool use_log, double log_base, bool use_pseudocount, 
   bool as_dataframe,
+  int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
   int threads) {
     return _compute_foldchange_sparse(x, i, p, features, rows, cols, 
       labels, features_as_rows, calc_percents, fc_name, use_expm1, min_threshold, 
-      use_log, log_base, use_pseudocount, as_dataframe, threads);
+      use_log, log_base, use_pseudocount, as_dataframe, norm_method, norm_scale, norm_sums, threads);
 }
 
 
@@ -230,11 +262,175 @@ extern cpp11::sexp cpp11_ComputeFoldChangeSparse64(
   bool use_expm1, double min_threshold, 
   bool use_log, double log_base, bool use_pseudocount, 
   bool as_dataframe,
+  int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
   int threads) {
     return _compute_foldchange_sparse(x, i, p, features, rows, cols, 
       labels, features_as_rows, calc_percents, fc_name, use_expm1, min_threshold, 
-      use_log, log_base, use_pseudocount, as_dataframe, threads);
+      use_log, log_base, use_pseudocount, as_dataframe, norm_method, norm_scale, norm_sums, threads);
+  }
+
+
+// runs the kernel on feature blocks, see _compute_wmwtest_blocks.
+template <typename SOURCE>
+static cpp11::sexp _compute_foldchange_blocks(
+  SOURCE const & blocks, int const & nsamples,
+  cpp11::strings const & features,
+  cpp11::integers const & labels,
+  bool calc_percents, std::string fc_name, 
+  bool use_expm1, double min_threshold, 
+  bool use_log, double log_base, bool use_pseudocount, 
+  bool as_dataframe,
+  int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
+  std::string const & output,
+  int threads) {
+
+  std::chrono::time_point<std::chrono::steady_clock, std::chrono::duration<double>> start;
+  start = std::chrono::steady_clock::now();
+
+  // ---- label vector
+  std::vector<int> lab(nsamples);
+  copy_rvector_to_cppvector(labels, lab.data(), nsamples);
+
+  // ---- output pval matrix
+  std::vector<double> fc;
+  std::vector<double> p1;
+  std::vector<double> p2;
+  std::vector<std::pair<int, size_t> > sorted_cluster_counts;
+  // or streamed to the output file block by block
+  std::unique_ptr<tsv_sink> sink;
+  std::vector<std::string> names;
+  if (!output.empty()) {
+    if (calc_percents) sink.reset(new tsv_sink(output, {fc_name, "pct.1", "pct.2"}));
+    else sink.reset(new tsv_sink(output, {fc_name}));
+    names.assign(features.begin(), features.end());
+  }
+
+  // expm1 on the working copy, as in _compute_foldchange_sparse.
+  bool pre_expm1 = use_expm1 && (min_threshold == 0.0) && (get_math_mode() == MATH_FAST);
+  std::vector<double> tx;
+  std::vector<double> bfc, bp1, bp2;
+  blocks([&](double * x, int * i, long * p, size_t const & first, size_t const & count) {
+      size_t nelem = p[count];
+      if ((norm_method >= 0) || pre_expm1) {
+        tx.assign(x, x + nelem);
+        x = tx.data();
+      }
+      if (norm_method >= 0) {
+        csc_normalize_by_row_inplace(x, static_cast<int const *>(i), nelem, norm_method, norm_scale, norm_sums, threads);
+      }
+      if (pre_expm1) {
+#pragma omp parallel num_threads(threads)
+        {
+          int tid = omp_get_thread_num();
+          size_t block = nelem / threads;
+          size_t rem = nelem - threads * block;
+          size_t offset = tid * block + (static_cast<size_t>(tid) > rem ? rem : tid);
+          int nid = tid + 1;
+          size_t end = nid * block + (static_cast<size_t>(nid) > rem ? rem : nid);
+          vec_expm1(x + offset, end - offset, x + offset);
+        }
+      }
+
+      bfc.clear();  bp1.clear();  bp2.clear();
+      sorted_cluster_counts.clear();
+      omp_sparse_foldchange(x, i, p, nsamples, static_cast<int>(count), lab.data(), 
+        calc_percents, fc_name, use_expm1 && !pre_expm1, min_threshold, 
+        use_log, log_base, use_pseudocount, 
+        bfc, bp1, bp2, sorted_cluster_counts, threads);
+      if (sink) {
+        if (calc_percents) sink->write(names, first, count, sorted_cluster_counts, {bfc.data(), bp1.data(), bp2.data()}, threads);
+        else sink->write(names, first, count, sorted_cluster_counts, {bfc.data()}, threads);
+        return;
+      }
+      fc.insert(fc.end(), bfc.begin(), bfc.end());
+      p1.insert(p1.end(), bp1.begin(), bp1.end());
+      p2.insert(p2.end(), bp2.begin(), bp2.end());
+    });
+
+  Rprintf("[TIME] FC blocks Elapsed(ms)= %f\n", since(start).count());
+
+  if (sink) {
+    sink->close();
+    return cpp11::as_sexp(export_sink_summary(sink->filename, sink->rows, sink->bytes, sorted_cluster_counts));
+  }
+
+  // ------------------------ generate output
+  cpp11::sexp out;
+  if (as_dataframe) {
+    if (calc_percents)
+      out = cpp11::as_sexp(export_fc_to_r_dataframe(
+        fc, fc_name, 
+        p1, "pct.1", 
+        p2, "pct.2",
+        sorted_cluster_counts, features));
+    else
+      out = cpp11::as_sexp(export_vec_to_r_dataframe(fc, fc_name,
+      sorted_cluster_counts, features));
+  } else {
+    if (calc_percents)
+      out = cpp11::as_sexp(export_fc_to_r_matrix(
+        fc, fc_name, 
+        p1, "pct.1", 
+        p2, "pct.2",
+        sorted_cluster_counts));
+    else
+      out = cpp11::as_sexp(export_vec_to_r_matrix<cpp11::writable::doubles_matrix<cpp11::by_column>>(fc, 
+        sorted_cluster_counts.size(), 
+        fc.size() / sorted_cluster_counts.size()));
   }
+  return out;
+}
+
+// memory mapped matrix, in memory or out of core by feature blocks.  see cpp11_spmat_wmw.
+[[cpp11::register]]
+extern cpp11::sexp cpp11_spmat_foldchange(
+  cpp11::external_pointer<spmat_mmap> const & handle,
+  cpp11::strings const & features,
+  cpp11::integers const & labels,
+  bool features_as_rows,
+  bool calc_percents, std::string fc_name, 
+  bool use_expm1, double min_threshold, 
+  bool use_log, double log_base, bool use_pseudocount, 
+  bool as_dataframe,
+  int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
+  std::string const & output,
+  int threads) {
+
+  spmat_mmap & mat = *spmat_attach(handle);
+  int nsamples = features_as_rows ? mat.header.ncol : mat.header.nrow;
+
+  return _compute_foldchange_blocks([&](spmat_block_fn const & f) { spmat_feature_blocks(mat, features_as_rows, threads, f); },
+    nsamples, features, labels, calc_percents, fc_name, use_expm1, min_threshold,
+    use_log, log_base, use_pseudocount, as_dataframe,
+    norm_method, norm_scale, norm_sums, output, threads);
+}
+
+// virtual concatenation of dgCMatrix / dgCMatrix64 slots.  see cpp11_spcat_wmw.
+[[cpp11::register]]
+extern cpp11::sexp cpp11_spcat_foldchange(
+  cpp11::list const & xs, cpp11::list const & is, cpp11::list const & ps,
+  cpp11::integers const & nrows, cpp11::integers const & ncols,
+  bool by_rows, double const & block_bytes,
+  cpp11::strings const & features,
+  cpp11::integers const & labels,
+  bool features_as_rows,
+  bool calc_percents, std::string fc_name, 
+  bool use_expm1, double min_threshold, 
+  bool use_log, double log_base, bool use_pseudocount, 
+  bool as_dataframe,
+  int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
+  std::string const & output,
+  int threads) {
+
+  spcat cat(by_rows, static_cast<size_t>(block_bytes));
+  import_rlist_to_spcat(xs, is, ps, nrows, ncols, cat);
+  int nsamples = features_as_rows ? cat.ncol : cat.nrow;
+
+  return _compute_foldchange_blocks([&](spmat_block_fn const & f) { spcat_feature_blocks(cat, features_as_rows, threads, f); },
+    nsamples, features, labels, calc_percents, fc_name, use_expm1, min_threshold,
+    use_log, log_base, use_pseudocount, as_dataframe,
+    norm_method, norm_scale, norm_sums, output, threads);
+}
 
 
 
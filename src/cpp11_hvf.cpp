@@ -0,0 +1,77 @@
+#include <vector>
+#include <cmath>
+
+#include <cpp11/sexp.hpp>
+#include <cpp11/list.hpp>
+#include <cpp11/integers.hpp>
+#include <cpp11/doubles.hpp>
+
+#include "utils_hvf.hpp"
+
+// FindVariableFeatures, selection.method = "vst".  features in rows, raw counts.
+// clip_max <= 0 means sqrt(ncol), Seurat's 'auto'.
+template <typename PT>
+extern cpp11::writable::list _sp_vst(cpp11::doubles const & x,
+    cpp11::integers const & i, PT const & p, int const & nrow, int const & ncol,
+    double const & span, double const & clip_max, int const & threads) {
+
+    cpp11::writable::doubles means(nrow);
+    cpp11::writable::doubles vars(nrow);
+    cpp11::writable::doubles expected(nrow);
+    cpp11::writable::doubles standardized(nrow);
+
+    double * mean = REAL(means);
+    double * var = REAL(vars);
+    double * ex = REAL(expected);
+
+    // pass 1:  mean and variance.
+    csc_row_mean_var(x, i, p, nrow, ncol, mean, var, threads);
+
+    // fit log10(variance) ~ log10(mean) over the non-constant features.
+    std::vector<size_t> ids;
+    ids.reserve(nrow);
+    for (int r = 0; r < nrow; ++r) {
+        if (var[r] > 0) ids.push_back(r);
+    }
+    size_t nfit = ids.size();
+    std::vector<double> lx(nfit), ly(nfit), fit(nfit);
+    for (size_t e = 0; e < nfit; ++e) {
+        lx[e] = log10(mean[ids[e]]);
+        ly[e] = log10(var[ids[e]]);
+    }
+    loess_fit_direct(lx.data(), ly.data(), nfit, span, 2, fit.data(), threads);
+
+    // expected sd.  constant features get 0 and are skipped by the second pass.
+    std::vector<double> sds(nrow, 0);
+    for (int r = 0; r < nrow; ++r) ex[r] = 0;
+    for (size_t e = 0; e < nfit; ++e) {
+        ex[ids[e]] = pow(10.0, fit[e]);
+        sds[ids[e]] = sqrt(ex[ids[e]]);
+    }
+
+    // pass 2:  clipped standardized variance.
+    double vmax = (clip_max > 0) ? clip_max : sqrt(static_cast<double>(ncol));
+    csc_row_clipped_std_var(x, i, p, nrow, ncol, mean, sds.data(), vmax, REAL(standardized), threads);
+
+    cpp11::writable::list out;
+    out.push_back(means);
+    out.push_back(vars);
+    out.push_back(expected);
+    out.push_back(standardized);
+    return out;
+}
+
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp_vst(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol,
+    double const & span, double const & clip_max, int const & threads) {
+    return _sp_vst(x, i, p, nrow, ncol, span, clip_max, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp64_vst(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol,
+    double const & span, double const & clip_max, int const & threads) {
+    return _sp_vst(x, i, p, nrow, ncol, span, clip_max, threads);
+}
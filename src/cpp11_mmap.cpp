@@ -0,0 +1,226 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#include <cpp11/sexp.hpp>
+#include <cpp11/list.hpp>
+#include <cpp11/named_arg.hpp>
+#include <cpp11/strings.hpp>
+#include <cpp11/integers.hpp>
+#include <cpp11/doubles.hpp>
+#include <cpp11/external_pointer.hpp>
+
+#include <omp.h>
+
+#include "utils_mmap.hpp"
+#include "utils_altrep.hpp"
+#include "utils_sparsemat.hpp"
+#include "utils_normalize.hpp"
+
+
+// x, i, p from a dgCMatrix (integer p) or dgCMatrix64 (double p).  empty names are not stored.
+// value_type:  SPMAT_F64, SPMAT_F32, SPMAT_U16 or SPMAT_U32 storage for x.
+// index_type:  SPMAT_IDX_I32 or SPMAT_IDX_VARINT storage for i.
+// transposed:  also store the transpose, so that neither orientation needs a transpose when used.
+[[cpp11::register]]
+extern void cpp11_spmat_write(std::string const & filename,
+    cpp11::doubles const & x, cpp11::integers const & i, cpp11::sexp const & p, int const & nrow, int const & ncol,
+    cpp11::strings const & rownames, cpp11::strings const & colnames, int const & value_type, int const & index_type,
+    bool const & transposed, int const & threads) {
+
+    if (Rf_xlength(p) != static_cast<R_xlen_t>(ncol) + 1) cpp11::stop("p must have ncol + 1 entries");
+    std::vector<std::string> rn(rownames.begin(), rownames.end());
+    std::vector<std::string> cn(colnames.begin(), colnames.end());
+    if (TYPEOF(p) == REALSXP) {
+        if (static_cast<R_xlen_t>(REAL(p)[ncol]) != x.size()) cpp11::stop("p does not end at the number of non-zeros");
+        spmat_write(filename, REAL_RO(x), INTEGER_RO(i), REAL_RO(p), nrow, ncol, rn, cn, value_type, index_type, transposed, threads);
+    } else if (TYPEOF(p) == INTSXP) {
+        if (static_cast<R_xlen_t>(INTEGER(p)[ncol]) != x.size()) cpp11::stop("p does not end at the number of non-zeros");
+        spmat_write(filename, REAL_RO(x), INTEGER_RO(i), INTEGER_RO(p), nrow, ncol, rn, cn, value_type, index_type, transposed, threads);
+    } else cpp11::stop("p must be integer or double");
+}
+
+// map and check the file, every index too if validate.  the handle unmaps it when garbage collected, and records
+// the file so that a serialized copy can map it again.
+[[cpp11::register]]
+extern cpp11::external_pointer<spmat_mmap> cpp11_spmat_open(std::string const & filename, bool const & validate, int const & threads) {
+    cpp11::external_pointer<spmat_mmap> handle(spmat_open(filename, validate ? SPMAT_CHECK_ALL : SPMAT_CHECK_POINTERS, threads));
+    spmat_handle_record(handle);
+    return handle;
+}
+
+static spmat_mmap & _spmat_get(cpp11::external_pointer<spmat_mmap> const & handle) {
+    return *spmat_attach(handle);
+}
+
+// Dim, nnz, Dimnames (NULL for names that were not stored), transposed (0 none, 1 stored in the file, 2 built in memory),
+// cache_budget and prefetch (out-of-core settings), value_type (SPMAT_F64 etc.), index_type (SPMAT_IDX_I32 etc.)
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_spmat_info(cpp11::external_pointer<spmat_mmap> const & handle) {
+    spmat_mmap const & mat = _spmat_get(handle);
+
+    cpp11::writable::integers dim(2);
+    dim[0] = mat.header.nrow;
+    dim[1] = mat.header.ncol;
+    cpp11::named_arg _td("Dim"); _td = dim;
+    cpp11::named_arg _tn("nnz"); _tn = cpp11::as_sexp(static_cast<double>(mat.header.nnz));
+
+    cpp11::writable::list dimnames(2);
+    for (int d = 0; d < 2; ++d) {
+        std::vector<std::string> names = spmat_names(mat, d == 0);
+        if (names.empty()) continue;
+        cpp11::writable::strings out(names.size());
+        for (size_t k = 0; k < names.size(); ++k) out[k] = names[k];
+        dimnames[d] = out;
+    }
+    cpp11::named_arg _tdn("Dimnames"); _tdn = dimnames;
+    cpp11::named_arg _tt("transposed"); _tt = cpp11::as_sexp(mat.tp == NULL ? 0 : (mat.header.tp_offset != 0 ? 1 : 2));
+    cpp11::named_arg _tc("cache_budget"); _tc = cpp11::as_sexp(static_cast<double>(mat.cache_budget));
+    cpp11::named_arg _tf("prefetch"); _tf = cpp11::as_sexp(static_cast<int>(mat.prefetch));
+    cpp11::named_arg _tv("value_type"); _tv = cpp11::as_sexp(mat.value_type);
+    cpp11::named_arg _ti("index_type"); _ti = cpp11::as_sexp(mat.index_type);
+    cpp11::writable::list out( {_td, _tn, _tdn, _tt, _tc, _tf, _tv, _ti} );
+    return out;
+}
+
+// copy the arrays into R vectors, x widened to doubles and i decoded.  p as doubles (dgCMatrix64) if large or if nnz exceeds 2^31-1.
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_spmat_load(cpp11::external_pointer<spmat_mmap> const & handle,
+    bool const & large, int const & threads) {
+    spmat_mmap const & mat = _spmat_get(handle);
+    size_t const nnz = mat.header.nnz;
+    size_t const np = mat.header.ncol + 1;
+
+    cpp11::writable::doubles x(static_cast<R_xlen_t>(nnz));
+    cpp11::writable::integers i(static_cast<R_xlen_t>(nnz));
+    double * ox = REAL(x);
+    int * oi = INTEGER(i);
+    bool is_large = large || (nnz > 2147483647UL);
+    cpp11::writable::doubles pd(static_cast<R_xlen_t>(is_large ? np : 0));
+    cpp11::writable::integers pi(static_cast<R_xlen_t>(is_large ? 0 : np));
+    double * opd = REAL(pd);
+    int * opi = INTEGER(pi);
+    spmat_values(mat, false, 0, nnz, ox, threads);
+    spmat_indices(mat, false, 0, mat.header.ncol, oi, threads);
+
+#pragma omp parallel num_threads(threads)
+{
+    int tid = omp_get_thread_num();
+    size_t block = np / threads;
+    size_t rem = np - threads * block;
+    size_t offset = tid * block + (static_cast<size_t>(tid) > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (static_cast<size_t>(nid) > rem ? rem : nid);
+    if (is_large) for (; offset < end; ++offset) opd[offset] = mat.p[offset];
+    else for (; offset < end; ++offset) opi[offset] = mat.p[offset];
+}
+
+    cpp11::named_arg _tx("x"); _tx = x;
+    cpp11::named_arg _ti("i"); _ti = i;
+    cpp11::named_arg _tp("p");
+    if (is_large) _tp = pd;
+    else _tp = pi;
+    cpp11::writable::list out( {_tx, _ti, _tp} );
+    return out;
+}
+
+// x, i, p as ALTREP views of the mapping, for a dgCMatrix64 that is read from the file on demand.
+// threads are used if R materializes a vector.
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_spmat_altrep(cpp11::external_pointer<spmat_mmap> const & handle, int const & threads) {
+    _spmat_get(handle);
+    cpp11::named_arg _tx("x"); _tx = spmat_altrep_x(handle, threads);
+    cpp11::named_arg _ti("i"); _ti = spmat_altrep_i(handle, threads);
+    cpp11::named_arg _tp("p"); _tp = spmat_altrep_p(handle, threads);
+    cpp11::writable::list out( {_tx, _ti, _tp} );
+    return out;
+}
+
+[[cpp11::init]]
+void fastde_init_altrep(DllInfo * dll) {
+    spmat_altrep_init(dll);
+}
+
+// build the transpose and keep it with the handle, if the file does not store it.
+[[cpp11::register]]
+extern void cpp11_spmat_build_transpose(cpp11::external_pointer<spmat_mmap> const & handle, int const & threads) {
+    spmat_transposed(_spmat_get(handle), threads);
+}
+
+// out-of-core mode:  DE kernels read blocks of about block_bytes through an LRU cache of at most budget bytes,
+// with up to prefetch blocks read in the background.  budget 0 returns to using the mapped arrays directly.
+[[cpp11::register]]
+extern void cpp11_spmat_set_cache(cpp11::external_pointer<spmat_mmap> const & handle, double const & budget, double const & block_bytes,
+    int const & prefetch) {
+    if ((budget < 0) || (block_bytes < 0) || (prefetch < 0)) cpp11::stop("budget, block size and prefetch must not be negative");
+    spmat_set_cache(_spmat_get(handle), static_cast<size_t>(budget), static_cast<size_t>(block_bytes), static_cast<size_t>(prefetch));
+    spmat_handle_record(handle);
+}
+
+// the transpose as R vectors.  copied from the file if stored, else transposed straight from the mapped arrays
+// (not kept).  p is returned as doubles, for dgCMatrix64.
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_spmat_transpose(cpp11::external_pointer<spmat_mmap> const & handle, int const & threads) {
+    spmat_mmap const & mat = _spmat_get(handle);
+    size_t const nnz = mat.header.nnz;
+    int const nrow = mat.header.nrow;
+
+    cpp11::writable::doubles x(static_cast<R_xlen_t>(nnz));
+    cpp11::writable::integers i(static_cast<R_xlen_t>(nnz));
+    cpp11::writable::doubles p(static_cast<R_xlen_t>(nrow + 1));
+    std::vector<long> tp(nrow + 1);
+    spmat_transpose_to(mat, REAL(x), INTEGER(i), tp.data(), threads);
+    std::copy(tp.begin(), tp.end(), REAL(p));
+
+    cpp11::named_arg _tx("x"); _tx = x;
+    cpp11::named_arg _ti("i"); _ti = i;
+    cpp11::named_arg _tp("p"); _tp = p;
+    cpp11::writable::list out( {_tx, _ti, _tp} );
+    return out;
+}
+
+// normalized x, same methods as cpp11_sp64_normalize, with i and p copied out of the mapping
+// (p as doubles), i.e. the slots of a dgCMatrix64.  clr reads the copied i.
+// margin:  1 = rowsum, 2 = colsum
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_spmat_normalize(cpp11::external_pointer<spmat_mmap> const & handle,
+    double const & scale_factor, int const & margin,
+    int const & method, int const & threads) {
+    spmat_mmap const & mat = _spmat_get(handle);
+    size_t const nnz = mat.header.nnz;
+    size_t const nrow = mat.header.nrow;
+    size_t const ncol = mat.header.ncol;
+    size_t const np = ncol + 1;
+
+    cpp11::writable::doubles xv(static_cast<R_xlen_t>(nnz));
+    cpp11::writable::integers iv(static_cast<R_xlen_t>(nnz));
+    cpp11::writable::doubles pv(static_cast<R_xlen_t>(np));
+    double * x = REAL(xv);
+    int * i = INTEGER(iv);
+    double * op = REAL(pv);
+    spmat_values(mat, false, 0, nnz, x, threads);
+    spmat_indices(mat, false, 0, ncol, i, threads);
+#pragma omp parallel for num_threads(threads) schedule(static)
+    for (size_t c = 0; c < np; ++c) op[c] = mat.p[c];
+
+    if (method == 0) {
+      // log normal
+      csc_log_normalize_inplace(x, mat.p, ncol, scale_factor, threads);
+    } else if (method == 1) {
+      // clr
+      if (margin == 1)
+        csc_clr_rows_inplace(x, i, mat.p, nrow, ncol, threads);
+      else if (margin == 2)
+        csc_clr_cols_inplace(x, i, mat.p, nrow, ncol, threads);
+    } else if (method == 2) {
+      // relative count.
+      csc_relative_count_inplace(x, mat.p, ncol, scale_factor, threads);
+    }
+
+    cpp11::named_arg _tx("x"); _tx = xv;
+    cpp11::named_arg _ti("i"); _ti = iv;
+    cpp11::named_arg _tp("p"); _tp = pv;
+    cpp11::writable::list out( {_tx, _ti, _tp} );
+    return out;
+}
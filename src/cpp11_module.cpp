@@ -0,0 +1,54 @@
+#include <vector>
+#include <cstdint>
+
+#include <cpp11/sexp.hpp>
+#include <cpp11/matrix.hpp>
+#include <cpp11/list.hpp>
+#include <cpp11/integers.hpp>
+#include <cpp11/doubles.hpp>
+
+#include "utils_data.hpp"
+#include "utils_module.hpp"
+
+// features in rows.  modules as flattened 0-based row ids with offsets (nmodules + 1).
+// returns the cells x modules scores, and the control sets in the same flattened form.
+template <typename PT>
+extern cpp11::writable::list _sp_module_score(cpp11::doubles const & x,
+    cpp11::integers const & i, PT const & p, int const & nrow, int const & ncol,
+    cpp11::integers const & module_ids, cpp11::integers const & module_offsets,
+    int const & nbin, int const & ctrl, double const & seed, int const & threads) {
+
+    size_t nmodules = module_offsets.size() - 1;
+
+    std::vector<int> ctrl_ids;
+    std::vector<int> ctrl_offsets;
+    csc_module_controls(x, i, p, nrow, ncol, INTEGER(module_ids), INTEGER(module_offsets), nmodules,
+        nbin, ctrl, static_cast<uint64_t>(seed), ctrl_ids, ctrl_offsets, threads);
+
+    std::vector<double> scores(static_cast<size_t>(ncol) * nmodules);
+    csc_module_scores(x, i, p, nrow, ncol, INTEGER(module_ids), INTEGER(module_offsets), nmodules,
+        ctrl_ids.data(), ctrl_offsets.data(), scores.data(), threads);
+
+    cpp11::writable::list out;
+    out.push_back(export_vec_to_r_matrix<cpp11::writable::doubles_matrix<cpp11::by_column>>(scores, ncol, nmodules));
+    out.push_back(cpp11::writable::integers(ctrl_ids.begin(), ctrl_ids.end()));
+    out.push_back(cpp11::writable::integers(ctrl_offsets.begin(), ctrl_offsets.end()));
+    return out;
+}
+
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp_module_score(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol,
+    cpp11::integers const & module_ids, cpp11::integers const & module_offsets,
+    int const & nbin, int const & ctrl, double const & seed, int const & threads) {
+    return _sp_module_score(x, i, p, nrow, ncol, module_ids, module_offsets, nbin, ctrl, seed, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp64_module_score(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol,
+    cpp11::integers const & module_ids, cpp11::integers const & module_offsets,
+    int const & nbin, int const & ctrl, double const & seed, int const & threads) {
+    return _sp_module_score(x, i, p, nrow, ncol, module_ids, module_offsets, nbin, ctrl, seed, threads);
+}
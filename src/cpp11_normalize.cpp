@@ -1,14 +1,19 @@
 #include "fastde/normalize.hpp"
 
 #include <chrono>
+#include <vector>
+#include <algorithm>
 
 #include <cpp11/sexp.hpp>
 #include <cpp11/matrix.hpp>
+#include <cpp11/list.hpp>
 #include <cpp11/strings.hpp>
 #include <cpp11/integers.hpp>
 #include <cpp11/doubles.hpp>
 
 #include "utils_data.hpp"
+#include "utils_normalize.hpp"
+#include "utils_fastmath.hpp"
 #include "fastde/benchmark_utils.hpp"
 
 // margin:  1 = rowsum, 2 = colsum
@@ -24,11 +29,16 @@ extern cpp11::writable::doubles cpp11_sp_normalize(cpp11::doubles const & x,
 
     if (method == 0) {
       // log normal
-      csc_log_normalize_vec(x, p, ncol, scale_factor, xv, threads);
+      if (get_math_mode() == MATH_FAST) {
+        // the in-tree kernel uses the vectorized log1p.
+        std::copy(x.begin(), x.end(), REAL(xv));
+        csc_log_normalize_inplace(REAL(xv), p, ncol, scale_factor, threads);
+      } else
+        csc_log_normalize_vec(x, p, ncol, scale_factor, xv, threads);
     } else if (method == 1) {
       // clr
       if (margin == 1) 
-        csc_clr_rows_vec(x, i, p, nrow, ncol, xv, threads);
+        csc_clr_rows(REAL(static_cast<SEXP>(x)), i, p, nrow, ncol, REAL(xv), threads);
       else if (margin == 2)
         csc_clr_cols_vec(x, i, p, nrow, ncol, xv, threads);
     } else if (method == 2) {
@@ -54,11 +64,16 @@ extern cpp11::writable::doubles cpp11_sp64_normalize(cpp11::doubles const & x,
 
     if (method == 0) {
       // log normal
-      csc_log_normalize_vec(x, p, ncol, scale_factor, xv, threads);
+      if (get_math_mode() == MATH_FAST) {
+        // the in-tree kernel uses the vectorized log1p.
+        std::copy(x.begin(), x.end(), REAL(xv));
+        csc_log_normalize_inplace(REAL(xv), p, ncol, scale_factor, threads);
+      } else
+        csc_log_normalize_vec(x, p, ncol, scale_factor, xv, threads);
     } else if (method == 1) {
       // clr
       if (margin == 1) 
-        csc_clr_rows_vec(x, i, p, nrow, ncol, xv, threads);
+        csc_clr_rows(REAL(static_cast<SEXP>(x)), i, p, nrow, ncol, REAL(xv), threads);
       else if (margin == 2)
         csc_clr_cols_vec(x, i, p, nrow, ncol, xv, threads);
     } else if (method == 2) {
@@ -69,4 +84,193 @@ extern cpp11::writable::doubles cpp11_sp64_normalize(cpp11::doubles const & x,
     return xv;
 
 
-}
\ No newline at end of file
+}
+
+// in-place normalization.  x is overwritten, i and p are reused by the caller.
+// only use when no other R object shares x.
+template <typename PT>
+extern void _sp_normalize_inplace(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::r_vector<PT> const & p, int const & nrow, int const & ncol, 
+    double const & scale_factor, int const & margin, 
+    int const & method, int const & threads) {
+
+    // write through the R vector's buffer directly.
+    double * xv = REAL(static_cast<SEXP>(x));
+
+    if (method == 0) {
+      // log normal
+      csc_log_normalize_inplace(xv, p, ncol, scale_factor, threads);
+    } else if (method == 1) {
+      // clr
+      if (margin == 1) 
+        csc_clr_rows_inplace(xv, i, p, nrow, ncol, threads);
+      else if (margin == 2)
+        csc_clr_cols_inplace(xv, i, p, nrow, ncol, threads);
+    } else if (method == 2) {
+      // relative count.
+      csc_relative_count_inplace(xv, p, ncol, scale_factor, threads);
+    }
+}
+
+// margin:  1 = rowsum, 2 = colsum
+[[cpp11::register]]
+extern void cpp11_sp_normalize_inplace(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol,
+    double const & scale_factor, int const & margin, 
+    int const & method, int const & threads) {
+
+    _sp_normalize_inplace(x, i, p, nrow, ncol, scale_factor, margin, method, threads);
+}
+
+// margin:  1 = rowsum, 2 = colsum
+[[cpp11::register]]
+extern void cpp11_sp64_normalize_inplace(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol,
+    double const & scale_factor, int const & margin, 
+    int const & method, int const & threads) {
+
+    _sp_normalize_inplace(x, i, p, nrow, ncol, scale_factor, margin, method, threads);
+}
+
+
+// ------- analytic Pearson residuals.  features in rows, raw counts.  see utils_normalize.hpp.
+
+template <typename PT>
+extern cpp11::writable::list _sp_pearson_params(cpp11::doubles const & x,
+    cpp11::integers const & i, PT const & p, int const & nrow, int const & ncol, int const & threads) {
+
+    cpp11::writable::doubles row_sums(nrow);
+    cpp11::writable::doubles col_sums(ncol);
+
+    csc_row_col_sums(x, i, p, nrow, ncol, REAL(row_sums), REAL(col_sums), threads);
+
+    cpp11::writable::list out;
+    out.push_back(row_sums);
+    out.push_back(col_sums);
+    return out;
+}
+
+template <typename PT>
+extern cpp11::writable::doubles_matrix<cpp11::by_column> _sp_pearson_to_dense(cpp11::doubles const & x,
+    cpp11::integers const & i, PT const & p, int const & nrow, 
+    cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip,
+    cpp11::integers const & row_ids, cpp11::integers const & col_ids, int const & threads) {
+
+    size_t nr = row_ids.size();
+    size_t nc = col_ids.size();
+    std::vector<double> vec(nr * nc);
+
+    csc_pearson_to_dense(x, i, p, nrow, REAL(gene_frac), REAL(cell_totals), theta, clip,
+        INTEGER(row_ids), nr, INTEGER(col_ids), nc, vec.data(), threads);
+
+    return export_vec_to_r_matrix<cpp11::writable::doubles_matrix<cpp11::by_column>>(vec, nr, nc);
+}
+
+// transpose = false: R * mat, mat is ncol x k.  transpose = true: R^T * mat, mat is nrow x k.
+template <typename PT>
+extern cpp11::writable::doubles_matrix<cpp11::by_column> _sp_pearson_prod(cpp11::doubles const & x,
+    cpp11::integers const & i, PT const & p, int const & nrow, int const & ncol,
+    cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip,
+    cpp11::doubles_matrix<cpp11::by_column> const & mat, bool const & transpose, int const & threads) {
+
+    size_t n = mat.nrow();
+    size_t k = mat.ncol();
+
+    // kernels walk one row of mat at a time, so make it row-major.
+    std::vector<double> B(n * k);
+    for (size_t c = 0; c < k; ++c) {
+        for (size_t r = 0; r < n; ++r) {
+            B[r * k + c] = mat(r, c);
+        }
+    }
+
+    size_t nout = transpose ? ncol : nrow;
+    std::vector<double> vec(nout * k);
+    if (transpose) 
+        csc_pearson_tprod(x, i, p, nrow, ncol, REAL(gene_frac), REAL(cell_totals), theta, clip, 
+            B.data(), k, vec.data(), threads);
+    else 
+        csc_pearson_prod(x, i, p, nrow, ncol, REAL(gene_frac), REAL(cell_totals), theta, clip, 
+            B.data(), k, vec.data(), threads);
+
+    return export_vec_to_r_matrix<cpp11::writable::doubles_matrix<cpp11::by_column>>(vec, nout, k);
+}
+
+template <typename PT>
+extern cpp11::writable::list _sp_pearson_var(cpp11::doubles const & x,
+    cpp11::integers const & i, PT const & p, int const & nrow, int const & ncol,
+    cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip,
+    int const & threads) {
+
+    cpp11::writable::doubles means(nrow);
+    cpp11::writable::doubles vars(nrow);
+
+    csc_pearson_row_var(x, i, p, nrow, ncol, REAL(gene_frac), REAL(cell_totals), theta, clip, 
+        REAL(means), REAL(vars), threads);
+
+    cpp11::writable::list out;
+    out.push_back(means);
+    out.push_back(vars);
+    return out;
+}
+
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp_pearson_params(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, int const & threads) {
+    return _sp_pearson_params(x, i, p, nrow, ncol, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp64_pearson_params(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, int const & threads) {
+    return _sp_pearson_params(x, i, p, nrow, ncol, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp_pearson_to_dense(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & nrow, 
+    cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip,
+    cpp11::integers const & row_ids, cpp11::integers const & col_ids, int const & threads) {
+    return _sp_pearson_to_dense(x, i, p, nrow, gene_frac, cell_totals, theta, clip, row_ids, col_ids, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp64_pearson_to_dense(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, 
+    cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip,
+    cpp11::integers const & row_ids, cpp11::integers const & col_ids, int const & threads) {
+    return _sp_pearson_to_dense(x, i, p, nrow, gene_frac, cell_totals, theta, clip, row_ids, col_ids, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp_pearson_prod(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol,
+    cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip,
+    cpp11::doubles_matrix<cpp11::by_column> const & mat, bool const & transpose, int const & threads) {
+    return _sp_pearson_prod(x, i, p, nrow, ncol, gene_frac, cell_totals, theta, clip, mat, transpose, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp64_pearson_prod(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol,
+    cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip,
+    cpp11::doubles_matrix<cpp11::by_column> const & mat, bool const & transpose, int const & threads) {
+    return _sp_pearson_prod(x, i, p, nrow, ncol, gene_frac, cell_totals, theta, clip, mat, transpose, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp_pearson_var(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol,
+    cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip,
+    int const & threads) {
+    return _sp_pearson_var(x, i, p, nrow, ncol, gene_frac, cell_totals, theta, clip, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp64_pearson_var(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol,
+    cpp11::doubles const & gene_frac, cpp11::doubles const & cell_totals, double const & theta, double const & clip,
+    int const & threads) {
+    return _sp_pearson_var(x, i, p, nrow, ncol, gene_frac, cell_totals, theta, clip, threads);
+}
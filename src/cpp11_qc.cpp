@@ -0,0 +1,44 @@
+#include <vector>
+
+#include <cpp11/sexp.hpp>
+#include <cpp11/matrix.hpp>
+#include <cpp11/list.hpp>
+#include <cpp11/integers.hpp>
+#include <cpp11/doubles.hpp>
+
+#include "utils_data.hpp"
+#include "utils_qc.hpp"
+
+// cells in columns.  set_masks:  one int per row, bit s set for membership in feature set s.
+template <typename PT>
+extern cpp11::writable::list _sp_qc_metrics(cpp11::doubles const & x,
+    cpp11::integers const & i, PT const & p, int const & ncol,
+    cpp11::integers const & set_masks, int const & nsets, int const & threads) {
+
+    cpp11::writable::doubles totals(ncol);
+    cpp11::writable::integers nfeatures(ncol);
+    std::vector<double> sums(static_cast<size_t>(ncol) * nsets);
+
+    csc_col_qc(x, i, p, ncol, set_masks, nsets, REAL(totals), INTEGER(nfeatures), sums.data(), threads);
+
+    cpp11::writable::list out;
+    out.push_back(totals);
+    out.push_back(nfeatures);
+    out.push_back(export_vec_to_r_matrix<cpp11::writable::doubles_matrix<cpp11::by_column>>(sums, ncol, nsets));
+    return out;
+}
+
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp_qc_metrics(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & ncol,
+    cpp11::integers const & set_masks, int const & nsets, int const & threads) {
+    return _sp_qc_metrics(x, i, p, ncol, set_masks, nsets, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp64_qc_metrics(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & ncol,
+    cpp11::integers const & set_masks, int const & nsets, int const & threads) {
+    return _sp_qc_metrics(x, i, p, ncol, set_masks, nsets, threads);
+}
@@ -0,0 +1,137 @@
+#include <vector>
+
+#include <cpp11/sexp.hpp>
+#include <cpp11/matrix.hpp>
+#include <cpp11/list.hpp>
+#include <cpp11/integers.hpp>
+#include <cpp11/doubles.hpp>
+
+#include "utils_data.hpp"
+#include "utils_scale.hpp"
+
+// implicit ScaleData.  features in rows.  the scaled matrix is described by 4 per-row vectors, see utils_scale.hpp.
+
+template <typename PT>
+extern cpp11::writable::list _sp_scale_stats(cpp11::doubles const & x,
+    cpp11::integers const & i, PT const & p, int const & nrow, int const & ncol,
+    bool const & center, bool const & scale, double const & scale_max, int const & threads) {
+
+    cpp11::writable::doubles centers(nrow);
+    cpp11::writable::doubles scales(nrow);
+    cpp11::writable::doubles clip_max(nrow);
+    cpp11::writable::doubles offsets(nrow);
+
+    csc_row_scale_stats(x, i, p, nrow, ncol, center, scale, scale_max, 
+        REAL(centers), REAL(scales), REAL(clip_max), REAL(offsets), threads);
+
+    cpp11::writable::list out;
+    out.push_back(centers);
+    out.push_back(scales);
+    out.push_back(clip_max);
+    out.push_back(offsets);
+    return out;
+}
+
+template <typename PT>
+extern cpp11::writable::doubles_matrix<cpp11::by_column> _sp_scaled_to_dense(cpp11::doubles const & x,
+    cpp11::integers const & i, PT const & p, int const & nrow, 
+    cpp11::doubles const & centers, cpp11::doubles const & scales, 
+    cpp11::doubles const & clip_max, cpp11::doubles const & offsets,
+    cpp11::integers const & row_ids, cpp11::integers const & col_ids, int const & threads) {
+
+    size_t nr = row_ids.size();
+    size_t nc = col_ids.size();
+    std::vector<double> vec(nr * nc);
+
+    csc_row_scaled_to_dense(x, i, p, nrow, 
+        REAL(centers), REAL(scales), REAL(clip_max), REAL(offsets),
+        INTEGER(row_ids), nr, INTEGER(col_ids), nc, vec.data(), threads);
+
+    return export_vec_to_r_matrix<cpp11::writable::doubles_matrix<cpp11::by_column>>(vec, nr, nc);
+}
+
+// transpose = false: Z * mat, mat is ncol x k.  transpose = true: Z^T * mat, mat is nrow x k.
+template <typename PT>
+extern cpp11::writable::doubles_matrix<cpp11::by_column> _sp_scaled_prod(cpp11::doubles const & x,
+    cpp11::integers const & i, PT const & p, int const & nrow, int const & ncol,
+    cpp11::doubles const & centers, cpp11::doubles const & scales, 
+    cpp11::doubles const & clip_max, cpp11::doubles const & offsets,
+    cpp11::doubles_matrix<cpp11::by_column> const & mat, bool const & transpose, int const & threads) {
+
+    size_t n = mat.nrow();
+    size_t k = mat.ncol();
+
+    // kernels walk one row of mat at a time, so make it row-major.
+    std::vector<double> B(n * k);
+    for (size_t c = 0; c < k; ++c) {
+        for (size_t r = 0; r < n; ++r) {
+            B[r * k + c] = mat(r, c);
+        }
+    }
+
+    size_t nout = transpose ? ncol : nrow;
+    std::vector<double> vec(nout * k);
+    if (transpose) 
+        csc_row_scaled_tprod(x, i, p, nrow, ncol, 
+            REAL(centers), REAL(scales), REAL(clip_max), REAL(offsets),
+            B.data(), k, vec.data(), threads);
+    else 
+        csc_row_scaled_prod(x, i, p, nrow, ncol, 
+            REAL(centers), REAL(scales), REAL(clip_max), REAL(offsets),
+            B.data(), k, vec.data(), threads);
+
+    return export_vec_to_r_matrix<cpp11::writable::doubles_matrix<cpp11::by_column>>(vec, nout, k);
+}
+
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp_scale_stats(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol,
+    bool const & center, bool const & scale, double const & scale_max, int const & threads) {
+    return _sp_scale_stats(x, i, p, nrow, ncol, center, scale, scale_max, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp64_scale_stats(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol,
+    bool const & center, bool const & scale, double const & scale_max, int const & threads) {
+    return _sp_scale_stats(x, i, p, nrow, ncol, center, scale, scale_max, threads);
+}
+
+
+[[cpp11::register]]
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp_scaled_to_dense(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & nrow, 
+    cpp11::doubles const & centers, cpp11::doubles const & scales, 
+    cpp11::doubles const & clip_max, cpp11::doubles const & offsets,
+    cpp11::integers const & row_ids, cpp11::integers const & col_ids, int const & threads) {
+    return _sp_scaled_to_dense(x, i, p, nrow, centers, scales, clip_max, offsets, row_ids, col_ids, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp64_scaled_to_dense(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, 
+    cpp11::doubles const & centers, cpp11::doubles const & scales, 
+    cpp11::doubles const & clip_max, cpp11::doubles const & offsets,
+    cpp11::integers const & row_ids, cpp11::integers const & col_ids, int const & threads) {
+    return _sp_scaled_to_dense(x, i, p, nrow, centers, scales, clip_max, offsets, row_ids, col_ids, threads);
+}
+
+
+[[cpp11::register]]
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp_scaled_prod(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol,
+    cpp11::doubles const & centers, cpp11::doubles const & scales, 
+    cpp11::doubles const & clip_max, cpp11::doubles const & offsets,
+    cpp11::doubles_matrix<cpp11::by_column> const & mat, bool const & transpose, int const & threads) {
+    return _sp_scaled_prod(x, i, p, nrow, ncol, centers, scales, clip_max, offsets, mat, transpose, threads);
+}
+
+[[cpp11::register]]
+extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp64_scaled_prod(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol,
+    cpp11::doubles const & centers, cpp11::doubles const & scales, 
+    cpp11::doubles const & clip_max, cpp11::doubles const & offsets,
+    cpp11::doubles_matrix<cpp11::by_column> const & mat, bool const & transpose, int const & threads) {
+    return _sp_scaled_prod(x, i, p, nrow, ncol, centers, scales, clip_max, offsets, mat, transpose, threads);
+}
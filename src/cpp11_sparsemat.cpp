@@ -6,6 +6,7 @@
 
 #include "cpp11/r_vector.hpp"
 #include "cpp11/list_of.hpp"
+#include "cpp11/named_arg.hpp"
 #include <R.h>
 #include <vector>
 
@@ -68,6 +69,40 @@ extern cpp11::writable::list cpp11_sp64_transpose(cpp11::doubles const & x,
 
 
 
+// rows (by_rows) or columns of a dgCMatrix64, sel 0-based and in output order, repeats allowed.  Matrix cannot
+// subset a double p.
+[[cpp11::register]]
+extern cpp11::writable::list cpp11_sp64_select(cpp11::doubles const & x,
+    cpp11::integers const & i, cpp11::doubles const & p, int const & nrow, int const & ncol, 
+    cpp11::integers const & sel, bool const & by_rows, int const & threads) {
+
+    if (p.size() != static_cast<R_xlen_t>(ncol) + 1) cpp11::stop("p must have ncol + 1 entries");
+    int const n = by_rows ? nrow : ncol;
+    size_t const nsel = sel.size();
+    int const * s = INTEGER_RO(sel);
+    for (size_t k = 0; k < nsel; ++k) {
+        if ((s[k] < 0) || (s[k] >= n)) cpp11::stop("selection out of range");
+    }
+
+    cpp11::writable::doubles pv(static_cast<R_xlen_t>(by_rows ? ncol + 1 : nsel + 1));
+    if (by_rows) _sp_select_rows_count(INTEGER_RO(i), REAL_RO(p), nrow, ncol, s, nsel, REAL(pv), threads);
+    else _sp_select_cols_count(REAL_RO(p), s, nsel, REAL(pv));
+
+    R_xlen_t nz = static_cast<R_xlen_t>(REAL(pv)[pv.size() - 1]);
+    cpp11::writable::doubles xv(nz);
+    cpp11::writable::integers iv(nz);
+    if (by_rows) _sp_select_rows(REAL_RO(x), INTEGER_RO(i), REAL_RO(p), nrow, ncol, s, nsel, REAL_RO(pv), REAL(xv), INTEGER(iv), threads);
+    else _sp_select_cols(REAL_RO(x), INTEGER_RO(i), REAL_RO(p), s, nsel, REAL_RO(pv), REAL(xv), INTEGER(iv), threads);
+
+    cpp11::named_arg _tx("x"); _tx = xv;
+    cpp11::named_arg _ti("i"); _ti = iv;
+    cpp11::named_arg _tp("p"); _tp = pv;
+    cpp11::writable::list out( {_tx, _ti, _tp} );
+    return out;
+}
+
+
+
 [[cpp11::register]]
 extern cpp11::writable::doubles_matrix<cpp11::by_column> cpp11_sp_to_dense(cpp11::doubles const & x,
     cpp11::integers const & i, cpp11::integers const & p, int const & nrow, int const & ncol, int const & threads) {
@@ -9,6 +9,12 @@
 #include "fastde/benchmark_utils.hpp"
 #include "utils_data.hpp"
 #include "utils_sparsemat.hpp"
+#include "utils_normalize.hpp"
+#include "utils_mmap.hpp"
+#include "utils_altrep.hpp"
+#include "utils_concat.hpp"
+#include "utils_sink.hpp"
+#include <cpp11/external_pointer.hpp>
 
 [[cpp11::register]]
 extern cpp11::sexp cpp11_dense_ttest(
@@ -75,6 +81,7 @@ extern cpp11::sexp _compute_ttest_sparse(
     int alternative, 
     bool var_equal, 
     bool as_dataframe,
+    int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
     int threads) {
   // Rprintf("here 1\n");
 
@@ -111,6 +118,11 @@ extern cpp11::sexp _compute_ttest_sparse(
   }
   // Rprintf("Sparse DIM: samples %lu x features %lu, non-zeros %lu\n", nsamples, nfeatures, nelem); 
 
+  // ---- on-the-fly normalization of the working copy.  rows are samples now.
+  if (norm_method >= 0) {
+    csc_normalize_by_row_inplace(x, i, nelem, norm_method, norm_scale, norm_sums, threads);
+  }
+
   // ---- label vector
   int * lab = reinterpret_cast<int *>(malloc(nsamples * sizeof(int)));
   copy_rvector_to_cppvector(labels, lab, nsamples);
@@ -156,10 +168,11 @@ extern cpp11::sexp cpp11_sparse_ttest(
     int alternative, 
     bool var_equal, 
     bool as_dataframe,
+    int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
     int threads) {
 
     return _compute_ttest_sparse(x, i, p, features, rows, cols,
-      labels, features_as_rows, alternative, var_equal, as_dataframe, threads);
+      labels, features_as_rows, alternative, var_equal, as_dataframe, norm_method, norm_scale, norm_sums, threads);
 
 }
 
@@ -175,10 +188,124 @@ extern cpp11::sexp cpp11_sparse64_ttest(
     int alternative, 
     bool var_equal, 
     bool as_dataframe,
+    int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
     int threads) {
 
     return _compute_ttest_sparse(x, i, p, features, rows, cols,
-      labels, features_as_rows, alternative, var_equal, as_dataframe, threads);
+      labels, features_as_rows, alternative, var_equal, as_dataframe, norm_method, norm_scale, norm_sums, threads);
+
+}
+
+
+// runs the kernel on feature blocks, see _compute_wmwtest_blocks.
+template <typename SOURCE>
+static cpp11::sexp _compute_ttest_blocks(
+    SOURCE const & blocks, int const & nsamples,
+    cpp11::strings const & features,
+    cpp11::integers const & labels,
+    int alternative, 
+    bool var_equal, 
+    bool as_dataframe,
+    int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
+    std::string const & output,
+    int threads) {
+
+  std::chrono::time_point<std::chrono::steady_clock, std::chrono::duration<double>> start;
+  start = std::chrono::steady_clock::now();
+
+  // ---- label vector
+  std::vector<int> lab(nsamples);
+  copy_rvector_to_cppvector(labels, lab.data(), nsamples);
+
+  // ---- output pval matrix, or streamed to the output file block by block
+  std::vector<double> pv;
+  std::vector<std::pair<int, size_t> > sorted_cluster_counts;
+  std::unique_ptr<tsv_sink> sink;
+  std::vector<std::string> names;
+  if (!output.empty()) {
+    sink.reset(new tsv_sink(output, {"p_val"}));
+    names.assign(features.begin(), features.end());
+  }
+
+  std::vector<double> tx;
+  std::vector<double> bpv;
+  blocks([&](double * x, int * i, long * p, size_t const & first, size_t const & count) {
+      size_t nelem = p[count];
+      if (norm_method >= 0) {
+        tx.assign(x, x + nelem);
+        x = tx.data();
+        csc_normalize_by_row_inplace(x, static_cast<int const *>(i), nelem, norm_method, norm_scale, norm_sums, threads);
+      }
+
+      bpv.clear();
+      sorted_cluster_counts.clear();
+      omp_sparse_ttest(x, i, p, nsamples, static_cast<int>(count), lab.data(), 
+        alternative, var_equal, 
+        bpv, sorted_cluster_counts, threads);
+      if (sink) sink->write(names, first, count, sorted_cluster_counts, {bpv.data()}, threads);
+      else pv.insert(pv.end(), bpv.begin(), bpv.end());
+    });
+
+  Rprintf("[TIME] TTEST blocks Elapsed(ms)= %f\n", since(start).count());
+
+  if (sink) {
+    sink->close();
+    return cpp11::as_sexp(export_sink_summary(sink->filename, sink->rows, sink->bytes, sorted_cluster_counts));
+  }
+
+  // ------------------------ generate output
+  if (as_dataframe) {
+    return(cpp11::as_sexp(export_vec_to_r_dataframe(pv, "p_val", sorted_cluster_counts, features)));
+  } else {
+    // use clust for column names.
+    return (cpp11::as_sexp(export_vec_to_r_matrix<cpp11::writable::doubles_matrix<cpp11::by_column>>(pv,
+      sorted_cluster_counts.size(), pv.size() / sorted_cluster_counts.size())));
+  }
+}
 
+// memory mapped matrix, in memory or out of core by feature blocks.  see cpp11_spmat_wmw.
+[[cpp11::register]]
+extern cpp11::sexp cpp11_spmat_ttest(
+    cpp11::external_pointer<spmat_mmap> const & handle,
+    cpp11::strings const & features,
+    cpp11::integers const & labels,
+    bool features_as_rows,
+    int alternative, 
+    bool var_equal, 
+    bool as_dataframe,
+    int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
+    std::string const & output,
+    int threads) {
+
+  spmat_mmap & mat = *spmat_attach(handle);
+  int nsamples = features_as_rows ? mat.header.ncol : mat.header.nrow;
+
+  return _compute_ttest_blocks([&](spmat_block_fn const & f) { spmat_feature_blocks(mat, features_as_rows, threads, f); },
+    nsamples, features, labels, alternative, var_equal, as_dataframe,
+    norm_method, norm_scale, norm_sums, output, threads);
 }
 
+// virtual concatenation of dgCMatrix / dgCMatrix64 slots.  see cpp11_spcat_wmw.
+[[cpp11::register]]
+extern cpp11::sexp cpp11_spcat_ttest(
+    cpp11::list const & xs, cpp11::list const & is, cpp11::list const & ps,
+    cpp11::integers const & nrows, cpp11::integers const & ncols,
+    bool by_rows, double const & block_bytes,
+    cpp11::strings const & features,
+    cpp11::integers const & labels,
+    bool features_as_rows,
+    int alternative, 
+    bool var_equal, 
+    bool as_dataframe,
+    int const & norm_method, double const & norm_scale, cpp11::doubles const & norm_sums,
+    std::string const & output,
+    int threads) {
+
+  spcat cat(by_rows, static_cast<size_t>(block_bytes));
+  import_rlist_to_spcat(xs, is, ps, nrows, ncols, cat);
+  int nsamples = features_as_rows ? cat.ncol : cat.nrow;
+
+  return _compute_ttest_blocks([&](spmat_block_fn const & f) { spcat_feature_blocks(cat, features_as_rows, threads, f); },
+    nsamples, features, labels, alternative, var_equal, as_dataframe,
+    norm_method, norm_scale, norm_sums, output, threads);
+}
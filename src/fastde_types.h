@@ -0,0 +1,5 @@
+#pragma once
+
+// types used in the cpp11 registered function signatures.
+#include <cpp11/external_pointer.hpp>
+#include "utils_mmap.hpp"
@@ -0,0 +1 @@
+#include "utils_altrep.tpp"
@@ -0,0 +1,6 @@
+#include "utils_concat.tpp"
+
+
+template void spcat_add(spcat & cat, double const * x, int const * i, int const * p, size_t const & nrow, size_t const & ncol);
+template void spcat_add(spcat & cat, double const * x, int const * i, double const * p, size_t const & nrow, size_t const & ncol);
+template void spcat_add(spcat & cat, double const * x, int const * i, long const * p, size_t const & nrow, size_t const & ncol);
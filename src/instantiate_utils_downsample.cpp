@@ -0,0 +1,13 @@
+#include "utils_downsample.tpp"
+#include "cpp11/doubles.hpp"
+#include "cpp11/integers.hpp"
+
+
+template void csc_downsample_cols(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & cols, cpp11::doubles const & targets, int const & method, uint64_t const & seed, double * xs, int * is, size_t * counts, int const & threads);
+
+template void csc_downsample_cols(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & cols, cpp11::doubles const & targets, int const & method, uint64_t const & seed, double * xs, int * is, size_t * counts, int const & threads);
+
+
+template void csc_compact_cols(double const * xs, int const * is, cpp11::integers const & p, cpp11::writable::integers const & out_p, size_t const & cols, cpp11::writable::doubles & out_x, cpp11::writable::integers & out_i, int const & threads);
+
+template void csc_compact_cols(double const * xs, int const * is, cpp11::doubles const & p, cpp11::writable::doubles const & out_p, size_t const & cols, cpp11::writable::doubles & out_x, cpp11::writable::integers & out_i, int const & threads);
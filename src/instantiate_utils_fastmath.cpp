@@ -0,0 +1,3 @@
+#include "utils_fastmath.tpp"
+
+// ------- no templates.  this translation unit owns the math mode and the dispatch table.
@@ -0,0 +1,14 @@
+#include "utils_h5.tpp"
+
+
+template void h5_read_1d(hid_t const & file, std::string const & path, size_t const & start, size_t const & count, double * out, int const & threads);
+template void h5_read_1d(hid_t const & file, std::string const & path, size_t const & start, size_t const & count, int * out, int const & threads);
+template void h5_read_1d(hid_t const & file, std::string const & path, size_t const & start, size_t const & count, long * out, int const & threads);
+
+template void h5_count_dense_csc(hid_t const & file, std::string const & path, bool const & cols_are_rows, std::vector<long> & p, size_t & nrow, size_t & ncol, int const & threads);
+template void h5_read_dense_csc(hid_t const & file, std::string const & path, bool const & cols_are_rows, long const * p, double * x, int * i, int const & threads);
+
+template void h5_write_1d<double, double>(hid_t const & loc, std::string const & path, double const * in, size_t const & count, size_t const & chunk, int const & level, int const & threads);
+template void h5_write_1d<int, int32_t>(hid_t const & loc, std::string const & path, int const * in, size_t const & count, size_t const & chunk, int const & level, int const & threads);
+template void h5_write_1d<int, int64_t>(hid_t const & loc, std::string const & path, int const * in, size_t const & count, size_t const & chunk, int const & level, int const & threads);
+template void h5_write_1d<double, int64_t>(hid_t const & loc, std::string const & path, double const * in, size_t const & count, size_t const & chunk, int const & level, int const & threads);
@@ -0,0 +1,13 @@
+#include "utils_hvf.tpp"
+#include "cpp11/doubles.hpp"
+#include "cpp11/integers.hpp"
+
+
+template void csc_row_mean_var(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, double * means, double * vars, int const & threads);
+
+template void csc_row_mean_var(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, double * means, double * vars, int const & threads);
+
+
+template void csc_row_clipped_std_var(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, double const * means, double const * sds, double const & vmax, double * out, int const & threads);
+
+template void csc_row_clipped_std_var(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, double const * means, double const * sds, double const & vmax, double * out, int const & threads);
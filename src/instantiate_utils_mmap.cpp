@@ -0,0 +1,5 @@
+#include "utils_mmap.tpp"
+
+
+template void spmat_write(std::string const & filename, double const * x, int const * i, int const * p, size_t const & nrow, size_t const & ncol, std::vector<std::string> const & rownames, std::vector<std::string> const & colnames, int const & value_type, int const & index_type, bool const & transposed, int const & threads);
+template void spmat_write(std::string const & filename, double const * x, int const * i, double const * p, size_t const & nrow, size_t const & ncol, std::vector<std::string> const & rownames, std::vector<std::string> const & colnames, int const & value_type, int const & index_type, bool const & transposed, int const & threads);
@@ -0,0 +1,13 @@
+#include "utils_module.tpp"
+#include "cpp11/doubles.hpp"
+#include "cpp11/integers.hpp"
+
+
+template void csc_module_controls(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, int const * module_ids, int const * module_offsets, size_t const & nmodules, int const & nbin, int const & ctrl, uint64_t const & seed, std::vector<int> & ctrl_ids, std::vector<int> & ctrl_offsets, int const & threads);
+
+template void csc_module_controls(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, int const * module_ids, int const * module_offsets, size_t const & nmodules, int const & nbin, int const & ctrl, uint64_t const & seed, std::vector<int> & ctrl_ids, std::vector<int> & ctrl_offsets, int const & threads);
+
+
+template void csc_module_scores(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, int const * module_ids, int const * module_offsets, size_t const & nmodules, int const * ctrl_ids, int const * ctrl_offsets, double * scores, int const & threads);
+
+template void csc_module_scores(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, int const * module_ids, int const * module_offsets, size_t const & nmodules, int const * ctrl_ids, int const * ctrl_offsets, double * scores, int const & threads);
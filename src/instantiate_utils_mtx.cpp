@@ -0,0 +1,5 @@
+#include "utils_mtx.tpp"
+
+
+template size_t mtx_read_csc(gzFile file, mtx_header const & header, double * x, int * i, int * p, int const & threads);
+template size_t mtx_read_csc(gzFile file, mtx_header const & header, double * x, int * i, double * p, int const & threads);
@@ -0,0 +1,63 @@
+#include "utils_normalize.tpp"
+#include "cpp11/doubles.hpp"
+#include "cpp11/integers.hpp"
+
+
+template void csc_log_normalize_inplace(double * x, cpp11::integers const & p, size_t const & cols, double const & scale_factor, int const & threads);
+
+template void csc_log_normalize_inplace(double * x, cpp11::doubles const & p, size_t const & cols, double const & scale_factor, int const & threads);
+
+
+template void csc_relative_count_inplace(double * x, cpp11::integers const & p, size_t const & cols, double const & scale_factor, int const & threads);
+
+template void csc_relative_count_inplace(double * x, cpp11::doubles const & p, size_t const & cols, double const & scale_factor, int const & threads);
+
+
+template void csc_clr_cols_inplace(double * x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, int const & threads);
+
+template void csc_clr_cols_inplace(double * x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, int const & threads);
+
+template void csc_clr_rows(double const * x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, double * out, int const & threads);
+
+template void csc_clr_rows(double const * x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, double * out, int const & threads);
+
+template void csc_clr_rows_inplace(double * x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, int const & threads);
+
+template void csc_clr_rows_inplace(double * x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, int const & threads);
+
+
+template void csc_normalize_by_row_inplace(double * x, int const * i, size_t const & nelem, int const & method, double const & scale_factor, cpp11::doubles const & row_sums, int const & threads);
+
+
+template void csc_row_col_sums(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, double * row_sums, double * col_sums, int const & threads);
+
+template void csc_row_col_sums(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, double * row_sums, double * col_sums, int const & threads);
+
+
+template void csc_pearson_to_dense(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, double const * gene_frac, double const * cell_totals, double const & theta, double const & clip, int const * row_ids, size_t const & nrow_out, int const * col_ids, size_t const & ncol_out, double * out, int const & threads);
+
+template void csc_pearson_to_dense(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, double const * gene_frac, double const * cell_totals, double const & theta, double const & clip, int const * row_ids, size_t const & nrow_out, int const * col_ids, size_t const & ncol_out, double * out, int const & threads);
+
+
+template void csc_pearson_prod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, double const * gene_frac, double const * cell_totals, double const & theta, double const & clip, double const * B, size_t const & k, double * out, int const & threads);
+
+template void csc_pearson_prod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, double const * gene_frac, double const * cell_totals, double const & theta, double const & clip, double const * B, size_t const & k, double * out, int const & threads);
+
+
+template void csc_pearson_tprod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, double const * gene_frac, double const * cell_totals, double const & theta, double const & clip, double const * U, size_t const & k, double * out, int const & threads);
+
+template void csc_pearson_tprod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, double const * gene_frac, double const * cell_totals, double const & theta, double const & clip, double const * U, size_t const & k, double * out, int const & threads);
+
+
+template void csc_pearson_row_var(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, double const * gene_frac, double const * cell_totals, double const & theta, double const & clip, double * means, double * vars, int const & threads);
+
+template void csc_pearson_row_var(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, double const * gene_frac, double const * cell_totals, double const & theta, double const & clip, double * means, double * vars, int const & threads);
+
+// raw arrays, e.g. memory mapped.
+template void csc_log_normalize_inplace(double * x, long * const & p, size_t const & cols, double const & scale_factor, int const & threads);
+
+template void csc_relative_count_inplace(double * x, long * const & p, size_t const & cols, double const & scale_factor, int const & threads);
+
+template void csc_clr_cols_inplace(double * x, int * const & i, long * const & p, size_t const & rows, size_t const & cols, int const & threads);
+
+template void csc_clr_rows_inplace(double * x, int * const & i, long * const & p, size_t const & rows, size_t const & cols, int const & threads);
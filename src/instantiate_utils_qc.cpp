@@ -0,0 +1,8 @@
+#include "utils_qc.tpp"
+#include "cpp11/doubles.hpp"
+#include "cpp11/integers.hpp"
+
+
+template void csc_col_qc(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & cols, cpp11::integers const & set_masks, size_t const & nsets, double * totals, int * nfeatures, double * set_sums, int const & threads);
+
+template void csc_col_qc(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & cols, cpp11::integers const & set_masks, size_t const & nsets, double * totals, int * nfeatures, double * set_sums, int const & threads);
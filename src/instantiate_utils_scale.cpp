@@ -0,0 +1,22 @@
+#include "utils_scale.tpp"
+#include "cpp11/doubles.hpp"
+#include "cpp11/integers.hpp"
+
+template void csc_row_scale_stats(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, bool const & center, bool const & scale, double const & scale_max, double * centers, double * scales, double * clip_max, double * offsets, int const & threads);
+
+template void csc_row_scale_stats(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, bool const & center, bool const & scale, double const & scale_max, double * centers, double * scales, double * clip_max, double * offsets, int const & threads);
+
+
+template void csc_row_scaled_to_dense(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, double const * centers, double const * scales, double const * clip_max, double const * offsets, int const * row_ids, size_t const & nrow_out, int const * col_ids, size_t const & ncol_out, double * out, int const & threads);
+
+template void csc_row_scaled_to_dense(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, double const * centers, double const * scales, double const * clip_max, double const * offsets, int const * row_ids, size_t const & nrow_out, int const * col_ids, size_t const & ncol_out, double * out, int const & threads);
+
+
+template void csc_row_scaled_prod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, double const * centers, double const * scales, double const * clip_max, double const * offsets, double const * B, size_t const & k, double * out, int const & threads);
+
+template void csc_row_scaled_prod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, double const * centers, double const * scales, double const * clip_max, double const * offsets, double const * B, size_t const & k, double * out, int const & threads);
+
+
+template void csc_row_scaled_tprod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::integers const & p, size_t const & rows, size_t const & cols, double const * centers, double const * scales, double const * clip_max, double const * offsets, double const * U, size_t const & k, double * out, int const & threads);
+
+template void csc_row_scaled_tprod(cpp11::doubles const & x, cpp11::integers const & i, cpp11::doubles const & p, size_t const & rows, size_t const & cols, double const * centers, double const * scales, double const * clip_max, double const * offsets, double const * U, size_t const & k, double * out, int const & threads);
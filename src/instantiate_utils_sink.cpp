@@ -0,0 +1 @@
+#include "utils_sink.tpp"
@@ -714,3 +714,53 @@ template void csc_rowsums_vec(
     cpp11::writable::doubles & out,
     int const & threads);
 
+
+// raw arrays, e.g. memory mapped.  compact value types of the native file format.
+template void _sp_transpose_par(
+    double const * x, 
+    int const * i, 
+    long const * p, 
+    size_t const & nelem,
+    int const & nrow, int const & ncol,
+    double * tx, 
+    int * ti, 
+    long * tp, 
+    int const & threads);
+template void _sp_transpose_par(
+    float const * x, 
+    int const * i, 
+    long const * p, 
+    size_t const & nelem,
+    int const & nrow, int const & ncol,
+    float * tx, 
+    int * ti, 
+    long * tp, 
+    int const & threads);
+template void _sp_transpose_par(
+    uint16_t const * x, 
+    int const * i, 
+    long const * p, 
+    size_t const & nelem,
+    int const & nrow, int const & ncol,
+    uint16_t * tx, 
+    int * ti, 
+    long * tp, 
+    int const & threads);
+template void _sp_transpose_par(
+    uint32_t const * x, 
+    int const * i, 
+    long const * p, 
+    size_t const & nelem,
+    int const & nrow, int const & ncol,
+    uint32_t * tx, 
+    int * ti, 
+    long * tp, 
+    int const & threads);
+
+template void _sp_select_cols_count(double const * p, int const * sel, size_t const & nsel, double * op);
+template void _sp_select_cols(double const * x, int const * i, double const * p, int const * sel, size_t const & nsel, 
+    double const * op, double * ox, int * oi, int const & threads);
+template void _sp_select_rows_count(int const * i, double const * p, size_t const & nrow, size_t const & ncol, 
+    int const * sel, size_t const & nsel, double * op, int const & threads);
+template void _sp_select_rows(double const * x, int const * i, double const * p, size_t const & nrow, size_t const & ncol, 
+    int const * sel, size_t const & nsel, double const * op, double * ox, int * oi, int const & threads);
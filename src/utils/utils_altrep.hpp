@@ -0,0 +1,42 @@
+#pragma once
+
+#include "cpp11/R.hpp"
+#include "cpp11/altrep.hpp"
+#include <R_ext/Rdynload.h>
+
+#include "utils_mmap.hpp"
+
+/*
+ * ALTREP vectors over the arrays of a memory mapped matrix (utils_mmap), for the slots of a dgCMatrix64 that
+ * stays in the file.  R sees ordinary double / integer vectors;  elements and regions are read from the mapping
+ * (compact values widened, coded indices decoded), and nothing is copied into R's heap until R asks for a
+ * writable pointer (e.g. REAL() from C code), which materializes the vector once.  x as doubles and i as int32
+ * hand out the mapping itself for read-only access.  duplication produces ordinary vectors.  the vectors keep the
+ * handle, so the mapping lives as long as any of them.
+ *
+ * handles survive serialization, e.g. to future / parallel workers on the same machine:  the external pointer
+ * arrives as NULL, and its tag records the file, the out-of-core settings and how far the file was checked, so
+ * the first use maps the file again without repeating the checks (see spmat_attach).  views that were not materialized serialize as their handle, not their contents.
+ */
+
+// x (doubles), i (integers) and p (doubles) of the matrix behind handle, an external pointer to an spmat_mmap.
+// threads are used when a vector is materialized.
+extern SEXP spmat_altrep_x(SEXP handle, int const & threads);
+extern SEXP spmat_altrep_i(SEXP handle, int const & threads);
+extern SEXP spmat_altrep_p(SEXP handle, int const & threads);
+
+// the int64 column pointers straight from the mapping if v is a p vector that has not been materialized
+// (so cannot have been modified), else NULL.  saves converting doubles back to int64.
+extern long const * spmat_altrep_int64(SEXP v);
+
+// the mapping behind handle, an external pointer to an spmat_mmap.  a handle that was serialized is reattached
+// in place, by mapping the file named in its tag with the recorded out-of-core settings.  throws
+// std::runtime_error if the handle has no record or the file cannot be mapped.
+extern spmat_mmap * spmat_attach(SEXP handle);
+
+// record the file and out-of-core settings of the mapping in the tag of handle.  after opening, and after each
+// change of settings.
+extern void spmat_handle_record(SEXP handle);
+
+// register the classes.  once, from R_init_fastde.
+extern void spmat_altrep_init(DllInfo * dll);
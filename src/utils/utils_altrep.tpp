@@ -0,0 +1,292 @@
+#pragma once
+
+#include "utils_altrep.hpp"
+
+/*
+ * ALTREP views of memory mapped matrices
+ *
+ */
+
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+
+#include <omp.h>
+
+
+// which array a class shows.
+#define _SPMAT_VIEW_X 0
+#define _SPMAT_VIEW_I 1
+#define _SPMAT_VIEW_P 2
+
+static R_altrep_class_t _spmat_altrep_classes[3];
+static char const * _spmat_altrep_names[3] = {"x", "i", "p"};
+
+// the tag of a handle is list(filename, c(cache_budget, cache_block_bytes, prefetch, checked)).
+static void _spmat_handle_finalize(SEXP handle) {
+    spmat_mmap * m = static_cast<spmat_mmap *>(R_ExternalPtrAddr(handle));
+    if (m == NULL) return;
+    R_ClearExternalPtr(handle);
+    delete m;
+}
+
+void spmat_handle_record(SEXP handle) {
+    spmat_mmap const * m = static_cast<spmat_mmap const *>(R_ExternalPtrAddr(handle));
+    if (m == NULL) return;
+    SEXP tag = PROTECT(Rf_allocVector(VECSXP, 2));
+    SET_VECTOR_ELT(tag, 0, Rf_mkString(m->filename.c_str()));
+    SEXP cache = Rf_allocVector(REALSXP, 4);
+    SET_VECTOR_ELT(tag, 1, cache);
+    REAL(cache)[0] = static_cast<double>(m->cache_budget);
+    REAL(cache)[1] = static_cast<double>(m->cache_block_bytes);
+    REAL(cache)[2] = static_cast<double>(m->prefetch);
+    REAL(cache)[3] = static_cast<double>(m->checked);
+    R_SetExternalPtrTag(handle, tag);
+    UNPROTECT(1);
+}
+
+spmat_mmap * spmat_attach(SEXP handle) {
+    spmat_mmap * m = static_cast<spmat_mmap *>(R_ExternalPtrAddr(handle));
+    if (m != NULL) return m;
+
+    SEXP tag = R_ExternalPtrTag(handle);
+    if ((TYPEOF(tag) != VECSXP) || (Rf_xlength(tag) != 2) ||
+        (TYPEOF(VECTOR_ELT(tag, 0)) != STRSXP) || (Rf_xlength(VECTOR_ELT(tag, 0)) != 1) ||
+        (TYPEOF(VECTOR_ELT(tag, 1)) != REALSXP) || (Rf_xlength(VECTOR_ELT(tag, 1)) != 4))
+        throw std::runtime_error("the memory mapped matrix has been released");
+
+    // a file the publishing session checked is not scanned again, only its header:  reattaching stays cheap for
+    // each worker.  otherwise it is checked with the OpenMP default, a worker has no thread setting of its own.
+    double const * cache = REAL(VECTOR_ELT(tag, 1));
+    int const checked = static_cast<int>(cache[3]);
+    std::unique_ptr<spmat_mmap> mat(spmat_open(CHAR(STRING_ELT(VECTOR_ELT(tag, 0), 0)),
+        (checked >= SPMAT_CHECK_POINTERS) ? SPMAT_CHECK_HEADER : SPMAT_CHECK_POINTERS, omp_get_max_threads()));
+    mat->checked = std::max(mat->checked, checked);
+    if (cache[0] > 0) spmat_set_cache(*mat, static_cast<size_t>(cache[0]), static_cast<size_t>(cache[1]), static_cast<size_t>(cache[2]));
+    R_SetExternalPtrAddr(handle, mat.get());
+    R_RegisterCFinalizerEx(handle, _spmat_handle_finalize, TRUE);
+    return mat.release();
+}
+
+
+// data1 is list(handle, threads).  data2 is the materialized vector, or NULL.
+static spmat_mmap & _spmat_altrep_mat(SEXP v) {
+    spmat_mmap * m = NULL;
+    char err[1024] = "";
+    try {
+        m = spmat_attach(VECTOR_ELT(R_altrep_data1(v), 0));
+    } catch (std::exception const & e) {
+        snprintf(err, sizeof(err), "%s", e.what());
+    }
+    // R errors jump, so not from within the handler.
+    if (m == NULL) Rf_error("%s", err);
+    return *m;
+}
+
+static int _spmat_altrep_threads(SEXP v) {
+    return INTEGER(VECTOR_ELT(R_altrep_data1(v), 1))[0];
+}
+
+template <int K>
+static R_xlen_t _spmat_altrep_length(SEXP v) {
+    spmat_header const & h = _spmat_altrep_mat(v).header;
+    return static_cast<R_xlen_t>(K == _SPMAT_VIEW_P ? h.ncol + 1 : h.nnz);
+}
+
+// elements [start, start + n) from the mapping, as the R type.
+template <int K>
+static void _spmat_altrep_fill(SEXP v, R_xlen_t const & start, R_xlen_t const & n, void * out, int const & threads) {
+    spmat_mmap const & mat = _spmat_altrep_mat(v);
+    if (K == _SPMAT_VIEW_X) spmat_values(mat, false, start, n, static_cast<double *>(out), threads);
+    else if (K == _SPMAT_VIEW_I) {
+        if ((start == 0) && (static_cast<uint64_t>(n) == mat.header.nnz)) spmat_indices(mat, false, 0, mat.header.ncol, static_cast<int *>(out), threads);
+        else spmat_indices_at(mat, false, start, n, static_cast<int *>(out));
+    } else {
+        double * o = static_cast<double *>(out);
+        for (R_xlen_t k = 0; k < n; ++k) o[k] = static_cast<double>(mat.p[start + k]);
+    }
+}
+
+template <int K>
+static void * _spmat_altrep_ptr(SEXP d) {
+    return (K == _SPMAT_VIEW_I) ? static_cast<void *>(INTEGER(d)) : static_cast<void *>(REAL(d));
+}
+
+// the mapping itself if it has the R layout (doubles, int32), else NULL.
+template <int K>
+static void * _spmat_altrep_direct(SEXP v) {
+    spmat_mmap const & mat = _spmat_altrep_mat(v);
+    if ((K == _SPMAT_VIEW_X) && (mat.value_type == SPMAT_F64)) return mat.x;
+    if ((K == _SPMAT_VIEW_I) && (mat.i != NULL)) return mat.i;
+    return NULL;
+}
+
+template <int K>
+static SEXP _spmat_altrep_copy(SEXP v) {
+    R_xlen_t n = _spmat_altrep_length<K>(v);
+    SEXP out = PROTECT(Rf_allocVector(K == _SPMAT_VIEW_I ? INTSXP : REALSXP, n));
+    SEXP d = R_altrep_data2(v);
+    if (d != R_NilValue) memcpy(_spmat_altrep_ptr<K>(out), _spmat_altrep_ptr<K>(d), n * (K == _SPMAT_VIEW_I ? sizeof(int) : sizeof(double)));
+    else _spmat_altrep_fill<K>(v, 0, n, _spmat_altrep_ptr<K>(out), _spmat_altrep_threads(v));
+    UNPROTECT(1);
+    return out;
+}
+
+// a writable pointer, or one of a type R cannot read from the mapping:  copy once into data2.
+template <int K>
+static void * _spmat_altrep_dataptr(SEXP v, Rboolean writeable) {
+    SEXP d = R_altrep_data2(v);
+    if (d == R_NilValue) {
+        if (!writeable) {
+            void * direct = _spmat_altrep_direct<K>(v);
+            if (direct != NULL) return direct;
+        }
+        d = _spmat_altrep_copy<K>(v);
+        R_set_altrep_data2(v, d);
+    }
+    return _spmat_altrep_ptr<K>(d);
+}
+
+template <int K>
+static void const * _spmat_altrep_dataptr_or_null(SEXP v) {
+    SEXP d = R_altrep_data2(v);
+    if (d != R_NilValue) return _spmat_altrep_ptr<K>(d);
+    return _spmat_altrep_direct<K>(v);
+}
+
+template <int K>
+static SEXP _spmat_altrep_duplicate(SEXP v, Rboolean deep) {
+    return _spmat_altrep_copy<K>(v);
+}
+
+// a view that was not materialized serializes as data1, so a copy in another process maps the file again,
+// once for all the views of a handle (R serializes the shared handle once).  a materialized one serializes
+// its contents, as an ordinary vector.
+template <int K>
+static SEXP _spmat_altrep_serialized_state(SEXP v) {
+    if (R_altrep_data2(v) != R_NilValue) return NULL;
+    return R_altrep_data1(v);
+}
+
+template <int K>
+static SEXP _spmat_altrep_unserialize(SEXP cls, SEXP state) {
+    if ((TYPEOF(state) != VECSXP) || (Rf_xlength(state) != 2) || (TYPEOF(VECTOR_ELT(state, 0)) != EXTPTRSXP))
+        Rf_error("invalid serialized fastde memory mapped %s", _spmat_altrep_names[K]);
+    return R_new_altrep(_spmat_altrep_classes[K], state, R_NilValue);
+}
+
+template <int K>
+static Rboolean _spmat_altrep_inspect(SEXP v, int pre, int deep, int pvec, void (*inspect_subtree)(SEXP, int, int, int)) {
+    Rprintf(" fastde memory mapped %s of %s%s\n", _spmat_altrep_names[K], _spmat_altrep_mat(v).filename.c_str(),
+        R_altrep_data2(v) == R_NilValue ? "" : ", materialized");
+    return TRUE;
+}
+
+template <int K>
+static double _spmat_altrep_real_elt(SEXP v, R_xlen_t k) {
+    SEXP d = R_altrep_data2(v);
+    if (d != R_NilValue) return REAL(d)[k];
+    double out;
+    _spmat_altrep_fill<K>(v, k, 1, &out, 1);
+    return out;
+}
+
+template <int K>
+static int _spmat_altrep_int_elt(SEXP v, R_xlen_t k) {
+    SEXP d = R_altrep_data2(v);
+    if (d != R_NilValue) return INTEGER(d)[k];
+    int out;
+    _spmat_altrep_fill<K>(v, k, 1, &out, 1);
+    return out;
+}
+
+template <int K, typename T>
+static R_xlen_t _spmat_altrep_region(SEXP v, R_xlen_t start, R_xlen_t n, T * buf) {
+    R_xlen_t len = _spmat_altrep_length<K>(v);
+    if (start >= len) return 0;
+    n = std::min(n, len - start);
+    SEXP d = R_altrep_data2(v);
+    if (d != R_NilValue) memcpy(buf, static_cast<T const *>(_spmat_altrep_ptr<K>(d)) + start, n * sizeof(T));
+    else _spmat_altrep_fill<K>(v, start, n, buf, 1);
+    return n;
+}
+
+static R_xlen_t _spmat_altrep_real_region_x(SEXP v, R_xlen_t start, R_xlen_t n, double * buf) {
+    return _spmat_altrep_region<_SPMAT_VIEW_X>(v, start, n, buf);
+}
+static R_xlen_t _spmat_altrep_real_region_p(SEXP v, R_xlen_t start, R_xlen_t n, double * buf) {
+    return _spmat_altrep_region<_SPMAT_VIEW_P>(v, start, n, buf);
+}
+static R_xlen_t _spmat_altrep_int_region(SEXP v, R_xlen_t start, R_xlen_t n, int * buf) {
+    return _spmat_altrep_region<_SPMAT_VIEW_I>(v, start, n, buf);
+}
+
+// column pointers start at 0 and never decrease;  neither p nor i hold NA.
+static int _spmat_altrep_sorted(SEXP v) {
+    return SORTED_INCR;
+}
+static int _spmat_altrep_no_na(SEXP v) {
+    return 1;
+}
+
+template <int K>
+static void _spmat_altrep_methods(R_altrep_class_t & cls) {
+    R_set_altrep_Length_method(cls, _spmat_altrep_length<K>);
+    R_set_altrep_Inspect_method(cls, _spmat_altrep_inspect<K>);
+    R_set_altrep_Duplicate_method(cls, _spmat_altrep_duplicate<K>);
+    R_set_altrep_Serialized_state_method(cls, _spmat_altrep_serialized_state<K>);
+    R_set_altrep_Unserialize_method(cls, _spmat_altrep_unserialize<K>);
+    R_set_altvec_Dataptr_method(cls, _spmat_altrep_dataptr<K>);
+    R_set_altvec_Dataptr_or_null_method(cls, _spmat_altrep_dataptr_or_null<K>);
+}
+
+void spmat_altrep_init(DllInfo * dll) {
+    R_altrep_class_t & cx = _spmat_altrep_classes[_SPMAT_VIEW_X];
+    cx = R_make_altreal_class("spmat_x", "fastde", dll);
+    _spmat_altrep_methods<_SPMAT_VIEW_X>(cx);
+    R_set_altreal_Elt_method(cx, _spmat_altrep_real_elt<_SPMAT_VIEW_X>);
+    R_set_altreal_Get_region_method(cx, _spmat_altrep_real_region_x);
+
+    R_altrep_class_t & ci = _spmat_altrep_classes[_SPMAT_VIEW_I];
+    ci = R_make_altinteger_class("spmat_i", "fastde", dll);
+    _spmat_altrep_methods<_SPMAT_VIEW_I>(ci);
+    R_set_altinteger_Elt_method(ci, _spmat_altrep_int_elt<_SPMAT_VIEW_I>);
+    R_set_altinteger_Get_region_method(ci, _spmat_altrep_int_region);
+    R_set_altinteger_No_NA_method(ci, _spmat_altrep_no_na);
+
+    R_altrep_class_t & cp = _spmat_altrep_classes[_SPMAT_VIEW_P];
+    cp = R_make_altreal_class("spmat_p", "fastde", dll);
+    _spmat_altrep_methods<_SPMAT_VIEW_P>(cp);
+    R_set_altreal_Elt_method(cp, _spmat_altrep_real_elt<_SPMAT_VIEW_P>);
+    R_set_altreal_Get_region_method(cp, _spmat_altrep_real_region_p);
+    R_set_altreal_Is_sorted_method(cp, _spmat_altrep_sorted);
+    R_set_altreal_No_NA_method(cp, _spmat_altrep_no_na);
+}
+
+static SEXP _spmat_altrep_new(int const & kind, SEXP handle, int const & threads) {
+    SEXP data1 = PROTECT(Rf_allocVector(VECSXP, 2));
+    SET_VECTOR_ELT(data1, 0, handle);
+    SET_VECTOR_ELT(data1, 1, Rf_ScalarInteger(threads));
+    SEXP out = R_new_altrep(_spmat_altrep_classes[kind], data1, R_NilValue);
+    UNPROTECT(1);
+    return out;
+}
+
+SEXP spmat_altrep_x(SEXP handle, int const & threads) {
+    return _spmat_altrep_new(_SPMAT_VIEW_X, handle, threads);
+}
+
+SEXP spmat_altrep_i(SEXP handle, int const & threads) {
+    return _spmat_altrep_new(_SPMAT_VIEW_I, handle, threads);
+}
+
+SEXP spmat_altrep_p(SEXP handle, int const & threads) {
+    return _spmat_altrep_new(_SPMAT_VIEW_P, handle, threads);
+}
+
+long const * spmat_altrep_int64(SEXP v) {
+    if (!ALTREP(v) || !R_altrep_inherits(v, _spmat_altrep_classes[_SPMAT_VIEW_P]) || (R_altrep_data2(v) != R_NilValue)) return NULL;
+    return _spmat_altrep_mat(v).p;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+#include "utils_mmap.hpp"
+
+/*
+ * virtual concatenation of CSC matrices, e.g. the per-sample count layers of a Seurat v5 assay, used by the DE
+ * kernels as if they had been combined with cbind (by columns) or rbind (by rows), without building the combined
+ * x, i, p.  the parts are used in place.  the kernels see blocks of consecutive features (see spmat_feature_blocks),
+ * assembled from the parts one block at a time:
+ *   features in the columns of the parts:  a feature's columns from the parts that have it, rows shifted by the
+ *       parts' row offsets.  when a part has all samples (cbind), blocks stay within parts and use its arrays as is.
+ *   features in the rows of the parts:  the transpose of the block's rows, gathered from all parts in one pass
+ *       with per-column cursors, so each entry is read once over all blocks and samples stay sorted.
+ * a block holds about block_bytes of x and i (0:  all features in one block).
+ */
+
+// one part.  p is converted to int64 (ncol + 1 entries);  x and i are not copied.
+struct spcat_part {
+    double const * x;
+    int const * i;
+    std::vector<long> p;
+    size_t nrow;
+    size_t ncol;
+    size_t row_offset;   // of the part's first row and column in the concatenation
+    size_t col_offset;
+};
+
+struct spcat {
+    bool by_rows;
+    size_t block_bytes;
+    size_t nrow;
+    size_t ncol;
+    size_t nnz;
+    std::vector<spcat_part> parts;
+
+    spcat(bool const & _by_rows, size_t const & _block_bytes) : by_rows(_by_rows), block_bytes(_block_bytes), nrow(0), ncol(0), nnz(0) {}
+};
+
+// append a part.  throws std::invalid_argument if its shared dimension (rows for cbind, columns for rbind)
+// differs from the first part's, or if p does not start at 0 and increase.
+template <typename PT>
+extern void spcat_add(spcat & cat, double const * x, int const * i, PT const * p, size_t const & nrow, size_t const & ncol);
+
+// call f(x, i, p, first, count) for consecutive blocks of features of the concatenation, in order, with the
+// contract of spmat_feature_blocks:  features [first, first + count) as columns, samples as rows numbered in
+// the concatenation, p[0] == 0, x not modified.  row indices within the parts must increase.
+extern void spcat_feature_blocks(spcat const & cat, bool const & features_as_rows, int const & threads, spmat_block_fn const & f);
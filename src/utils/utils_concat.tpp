@@ -0,0 +1,283 @@
+#pragma once
+
+#include "utils_concat.hpp"
+
+/*
+ * virtual concatenation of sparse matrices
+ *
+ */
+
+#include <vector>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+
+#include <omp.h>
+
+
+template <typename PT>
+void spcat_add(spcat & cat, double const * x, int const * i, PT const * p, size_t const & nrow, size_t const & ncol) {
+    if (!cat.parts.empty()) {
+        if (cat.by_rows && (ncol != cat.ncol)) throw std::invalid_argument("matrices concatenated by rows must have the same number of columns");
+        if (!cat.by_rows && (nrow != cat.nrow)) throw std::invalid_argument("matrices concatenated by columns must have the same number of rows");
+    }
+
+    spcat_part part;
+    part.x = x;
+    part.i = i;
+    part.nrow = nrow;
+    part.ncol = ncol;
+    part.row_offset = cat.by_rows ? cat.nrow : 0;
+    part.col_offset = cat.by_rows ? 0 : cat.ncol;
+    part.p.resize(ncol + 1);
+    bool ok = (p[0] == 0);
+    for (size_t c = 0; c <= ncol; ++c) {
+        part.p[c] = static_cast<long>(p[c]);
+        if (c > 0) ok &= (part.p[c] >= part.p[c - 1]);
+    }
+    if (!ok) throw std::invalid_argument("column pointers must start at 0 and not decrease");
+
+    if (cat.by_rows) {
+        cat.nrow += nrow;
+        cat.ncol = ncol;
+    } else {
+        cat.nrow = nrow;
+        cat.ncol += ncol;
+    }
+    cat.nnz += part.p[ncol];
+    cat.parts.push_back(std::move(part));
+}
+
+
+// block bounds over the feature offsets fp, about target elements per block.  blocks also end where a part
+// ends if breaks is not empty (features in the columns of parts that hold all samples).
+static std::vector<size_t> _spcat_block_bounds(std::vector<long> const & fp, size_t const & target, std::vector<size_t> const & breaks) {
+    size_t nfeatures = fp.size() - 1;
+    std::vector<size_t> bounds(1, 0);
+    size_t t = std::max(target, static_cast<size_t>(1));
+    auto brk = breaks.begin();
+    for (size_t f = 1; f <= nfeatures; ++f) {
+        while ((brk != breaks.end()) && (*brk < f)) ++brk;
+        bool part_end = (brk != breaks.end()) && (*brk == f);
+        if ((f == nfeatures) || part_end || (static_cast<size_t>(fp[f + 1] - fp[bounds.back()]) > t)) bounds.push_back(f);
+    }
+    if (nfeatures == 0) bounds.push_back(0);
+    return bounds;
+}
+
+// features in the columns of the parts.
+static void _spcat_column_blocks(spcat const & cat, int const & threads, size_t const & target, spmat_block_fn const & f) {
+    size_t const nfeatures = cat.ncol;
+    size_t const nparts = cat.parts.size();
+
+    // feature offsets in the concatenation.  for cbind each feature is in one part, for rbind in all.
+    std::vector<long> fp(nfeatures + 1, 0);
+    for (auto const & part : cat.parts) {
+        for (size_t c = 0; c < part.ncol; ++c) fp[part.col_offset + c + 1] += part.p[c + 1] - part.p[c];
+    }
+    for (size_t c = 0; c < nfeatures; ++c) fp[c + 1] += fp[c];
+
+    std::vector<size_t> breaks;
+    if (!cat.by_rows) {
+        for (auto const & part : cat.parts) breaks.push_back(part.col_offset + part.ncol);
+    }
+    std::vector<size_t> bounds = _spcat_block_bounds(fp, target, breaks);
+
+    std::vector<double> bx;
+    std::vector<int> bi;
+    std::vector<long> lp;
+    size_t k = 0;   // for cbind, the part holding the current block
+    for (size_t b = 0; b + 1 < bounds.size(); ++b) {
+        size_t first = bounds[b];
+        size_t count = bounds[b + 1] - first;
+        lp.resize(count + 1);
+
+        if (!cat.by_rows) {
+            // within one part, whose rows are the samples:  its arrays as they are.
+            while ((k + 1 < nparts) && (cat.parts[k].col_offset + cat.parts[k].ncol <= first)) ++k;
+            spcat_part const & part = cat.parts[k];
+            size_t lf = first - part.col_offset;
+            long start = part.p[lf];
+            for (size_t c = 0; c <= count; ++c) lp[c] = part.p[lf + c] - start;
+            f(const_cast<double *>(part.x) + start, const_cast<int *>(part.i) + start, lp.data(), first, count);
+            continue;
+        }
+
+        // each feature from every part, in part order so rows increase.
+        for (size_t c = 0; c <= count; ++c) lp[c] = fp[first + c] - fp[first];
+        bx.resize(lp[count]);
+        bi.resize(lp[count]);
+        double * ox = bx.data();
+        int * oi = bi.data();
+        // row indices checked, since offset into the concatenation they would land in another part.
+        bool ok = true;
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64) reduction(&&:ok)
+        for (size_t c = 0; c < count; ++c) {
+            long o = lp[c];
+            for (size_t q = 0; q < nparts; ++q) {
+                spcat_part const & part = cat.parts[q];
+                long s = part.p[first + c];
+                long e = part.p[first + c + 1];
+                int ro = static_cast<int>(part.row_offset);
+                int nr = static_cast<int>(part.nrow);
+                if (e > s) memcpy(ox + o, part.x + s, (e - s) * sizeof(double));
+                for (long j = s; j < e; ++j, ++o) {
+                    if ((part.i[j] < 0) || (part.i[j] >= nr)) ok = false;
+                    oi[o] = part.i[j] + ro;
+                }
+            }
+        }
+        if (!ok) throw std::invalid_argument("row index out of range in a concatenated matrix");
+        f(ox, oi, lp.data(), first, count);
+    }
+}
+
+// a range of columns of a part, the unit of parallel work when gathering rows.
+struct _spcat_piece {
+    size_t part;
+    size_t c0;
+    size_t c1;
+};
+
+// features in the rows of the parts.
+static void _spcat_row_blocks(spcat const & cat, int const & threads, size_t const & target, spmat_block_fn const & f) {
+    size_t const nfeatures = cat.nrow;
+    size_t const nparts = cat.parts.size();
+
+    // pieces of about nnz / (2 * threads) entries, never across parts, in sample order.
+    std::vector<_spcat_piece> pieces;
+    size_t per_piece = std::max(cat.nnz / (2 * static_cast<size_t>(threads)), static_cast<size_t>(1));
+    for (size_t q = 0; q < nparts; ++q) {
+        spcat_part const & part = cat.parts[q];
+        size_t c0 = 0;
+        for (size_t c = 1; c <= part.ncol; ++c) {
+            if ((c == part.ncol) || (static_cast<size_t>(part.p[c] - part.p[c0]) >= per_piece)) {
+                pieces.push_back({q, c0, c});
+                c0 = c;
+            }
+        }
+    }
+    size_t const npieces = pieces.size();
+
+    // per row counts (so block sizes), and the row indices checked, since they address the counts and the
+    // gather below relies on their order.
+    std::vector<std::vector<long> > tcounts(threads);
+    bool ok = true, sorted = true;
+#pragma omp parallel num_threads(threads) reduction(&&:ok, sorted)
+    {
+        std::vector<long> & cnt = tcounts[omp_get_thread_num()];
+        cnt.assign(nfeatures, 0);
+#pragma omp for schedule(dynamic, 1)
+        for (size_t j = 0; j < npieces; ++j) {
+            spcat_part const & part = cat.parts[pieces[j].part];
+            int const nr = static_cast<int>(part.nrow);
+            for (size_t c = pieces[j].c0; c < pieces[j].c1; ++c) {
+                int prev = -1;
+                for (long e = part.p[c]; e < part.p[c + 1]; ++e) {
+                    int r = part.i[e];
+                    if ((r < 0) || (r >= nr)) ok = false;
+                    else if (r <= prev) sorted = false;
+                    else ++cnt[part.row_offset + r];
+                    prev = r;
+                }
+            }
+        }
+    }
+    if (!ok) throw std::invalid_argument("row index out of range in a concatenated matrix");
+    if (!sorted) throw std::invalid_argument("row indices must increase within each column of a concatenated matrix");
+    std::vector<long> fp(nfeatures + 1, 0);
+    for (auto const & cnt : tcounts) {
+        if (cnt.empty()) continue;   // a thread the runtime did not start
+        for (size_t r = 0; r < nfeatures; ++r) fp[r + 1] += cnt[r];
+    }
+    tcounts.clear();
+    for (size_t r = 0; r < nfeatures; ++r) fp[r + 1] += fp[r];
+
+    std::vector<size_t> bounds = _spcat_block_bounds(fp, target, std::vector<size_t>());
+
+    // per column, the first entry not yet gathered.  rows increase within columns and blocks are in row order,
+    // so the cursors only move forward.
+    std::vector<std::vector<long> > cursor(nparts);
+    for (size_t q = 0; q < nparts; ++q) cursor[q].assign(cat.parts[q].p.begin(), cat.parts[q].p.end() - 1);
+
+    std::vector<size_t> active;
+    std::vector<long> pos;     // active pieces x features of the block:  counts, then output positions
+    std::vector<double> bx;
+    std::vector<int> bi;
+    std::vector<long> lp;
+    for (size_t b = 0; b + 1 < bounds.size(); ++b) {
+        size_t first = bounds[b];
+        size_t count = bounds[b + 1] - first;
+        size_t last = first + count;
+
+        // pieces of the parts with rows in the block (for cbind, all).
+        active.clear();
+        for (size_t j = 0; j < npieces; ++j) {
+            spcat_part const & part = cat.parts[pieces[j].part];
+            if ((part.row_offset < last) && (part.row_offset + part.nrow > first)) active.push_back(j);
+        }
+        size_t const nactive = active.size();
+        pos.assign(nactive * count, 0);
+
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+        for (size_t a = 0; a < nactive; ++a) {
+            _spcat_piece const & piece = pieces[active[a]];
+            spcat_part const & part = cat.parts[piece.part];
+            long * cnt = pos.data() + a * count;
+            long const * cur = cursor[piece.part].data();
+            long const lo = static_cast<long>(first) - static_cast<long>(part.row_offset);
+            long const hi = static_cast<long>(last) - static_cast<long>(part.row_offset);
+            for (size_t c = piece.c0; c < piece.c1; ++c) {
+                long e = cur[c];
+                long const end = part.p[c + 1];
+                for (; (e < end) && (part.i[e] < hi); ++e) ++cnt[part.i[e] - lo];
+            }
+        }
+
+        lp.resize(count + 1);
+        for (size_t c = 0; c <= count; ++c) lp[c] = fp[first + c] - fp[first];
+#pragma omp parallel for num_threads(threads) schedule(static)
+        for (size_t r = 0; r < count; ++r) {
+            long o = lp[r];
+            for (size_t a = 0; a < nactive; ++a) {
+                long n = pos[a * count + r];
+                pos[a * count + r] = o;
+                o += n;
+            }
+        }
+
+        bx.resize(lp[count]);
+        bi.resize(lp[count]);
+        double * ox = bx.data();
+        int * oi = bi.data();
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1)
+        for (size_t a = 0; a < nactive; ++a) {
+            _spcat_piece const & piece = pieces[active[a]];
+            spcat_part const & part = cat.parts[piece.part];
+            long * o = pos.data() + a * count;
+            long * cur = cursor[piece.part].data();
+            long const lo = static_cast<long>(first) - static_cast<long>(part.row_offset);
+            long const hi = static_cast<long>(last) - static_cast<long>(part.row_offset);
+            int const co = static_cast<int>(part.col_offset);
+            for (size_t c = piece.c0; c < piece.c1; ++c) {
+                long e = cur[c];
+                long const end = part.p[c + 1];
+                for (; (e < end) && (part.i[e] < hi); ++e) {
+                    long k = o[part.i[e] - lo]++;
+                    ox[k] = part.x[e];
+                    oi[k] = co + static_cast<int>(c);
+                }
+                cur[c] = e;
+            }
+        }
+        f(ox, oi, lp.data(), first, count);
+    }
+}
+
+void spcat_feature_blocks(spcat const & cat, bool const & features_as_rows, int const & threads, spmat_block_fn const & f) {
+    if (cat.parts.empty()) throw std::invalid_argument("no matrices to concatenate");
+    size_t target = (cat.block_bytes == 0) ? std::numeric_limits<size_t>::max() : cat.block_bytes / (sizeof(double) + sizeof(int));
+    if (features_as_rows) _spcat_row_blocks(cat, threads, target, f);
+    else _spcat_column_blocks(cat, threads, target, f);
+}
@@ -140,3 +140,19 @@ cpp11::writable::data_frame export_fc_to_r_dataframe(
     std::vector<std::pair<int, size_t> > const & sorted_labels,
     cpp11::strings const & features
 );
+
+struct spcat;
+
+// append dgCMatrix (integer p) or dgCMatrix64 (double p) slots to a virtual concatenation (see utils_concat.hpp).
+// x and i are used in place, so the R vectors must outlive cat.  throws std::invalid_argument for bad slots.
+void import_rlist_to_spcat(
+    cpp11::list const & xs, cpp11::list const & is, cpp11::list const & ps,
+    cpp11::integers const & nrows, cpp11::integers const & ncols,
+    spcat & cat
+);
+
+// what a streaming result sink wrote (see utils_sink.hpp):  file, rows, bytes, and the cluster ids.
+cpp11::writable::list export_sink_summary(
+    std::string const & filename, size_t const & rows, size_t const & bytes,
+    std::vector<std::pair<int, size_t> > const & sorted_labels
+);
@@ -3,6 +3,10 @@
 // ------- function definition
 
 #include "utils_data.hpp"
+#include "utils_altrep.hpp"
+#include "utils_concat.hpp"
+
+#include <stdexcept>
 
 
 
@@ -94,7 +98,10 @@ size_t copy_rvector_to_cppvector(cpp11::doubles const & _vector,
     if (offset >= veclen) return 0;  // offset is greater than vector length
     size_t len = std::min(length, veclen - offset);   // length to return
     vec.clear();
-    vec.insert(vec.end(), _vector.begin() + offset, _vector.begin() + offset + len);
+    // p of a memory mapped dgCMatrix64 is int64 already.
+    long const * lp = spmat_altrep_int64(_vector);
+    if (lp != NULL) vec.insert(vec.end(), lp + offset, lp + offset + len);
+    else vec.insert(vec.end(), _vector.begin() + offset, _vector.begin() + offset + len);
 
     return len;
 }
@@ -134,7 +141,9 @@ size_t copy_rvector_to_cppvector(cpp11::doubles const & _vector,
     size_t veclen = static_cast<size_t>(_vector.size());
     if (offset >= veclen) return 0;  // offset is greater than vector length
     size_t len = std::min(length, veclen - offset);   // length to return
-    std::copy(_vector.begin() + offset, _vector.begin() + offset + len, vec);
+    long const * lp = spmat_altrep_int64(_vector);
+    if (lp != NULL) std::copy(lp + offset, lp + offset + len, vec);
+    else std::copy(_vector.begin() + offset, _vector.begin() + offset + len, vec);
 
     return len;
 }
@@ -337,3 +346,45 @@ cpp11::writable::data_frame export_fc_to_r_dataframe(
 }
 
 
+
+cpp11::writable::list export_sink_summary(
+    std::string const & filename, size_t const & rows, size_t const & bytes,
+    std::vector<std::pair<int, size_t> > const & sorted_labels
+) {
+    cpp11::writable::integers clust(sorted_labels.size());
+    for (size_t l = 0; l < sorted_labels.size(); ++l) clust[l] = sorted_labels[l].first;
+
+    cpp11::named_arg _fn("file"); _fn = cpp11::as_sexp(filename.c_str());
+    cpp11::named_arg _rw("rows"); _rw = cpp11::as_sexp(static_cast<double>(rows));
+    cpp11::named_arg _by("bytes"); _by = cpp11::as_sexp(static_cast<double>(bytes));
+    cpp11::named_arg _cl("clusters"); _cl = clust;
+    return cpp11::writable::list( {_fn, _rw, _by, _cl} );
+}
+
+void import_rlist_to_spcat(
+    cpp11::list const & xs, cpp11::list const & is, cpp11::list const & ps,
+    cpp11::integers const & nrows, cpp11::integers const & ncols,
+    spcat & cat
+) {
+    R_xlen_t n = xs.size();
+    if ((is.size() != n) || (ps.size() != n) || (nrows.size() != n) || (ncols.size() != n))
+        throw std::invalid_argument("x, i, p, nrow and ncol must have one entry per matrix");
+
+    for (R_xlen_t k = 0; k < n; ++k) {
+        SEXP x = xs[k];
+        SEXP i = is[k];
+        SEXP p = ps[k];
+        if ((TYPEOF(x) != REALSXP) || (TYPEOF(i) != INTSXP) || (Rf_xlength(x) != Rf_xlength(i)))
+            throw std::invalid_argument("x must be double and i integer, of the same length");
+        if ((nrows[k] < 0) || (ncols[k] < 0) || (Rf_xlength(p) != static_cast<R_xlen_t>(ncols[k]) + 1))
+            throw std::invalid_argument("p must have ncol + 1 entries");
+
+        // the int64 pointers of a lazily loaded memory mapped matrix, without converting them to doubles.
+        long const * lp = spmat_altrep_int64(p);
+        if (lp != NULL) spcat_add(cat, REAL_RO(x), INTEGER_RO(i), lp, nrows[k], ncols[k]);
+        else if (TYPEOF(p) == REALSXP) spcat_add(cat, REAL_RO(x), INTEGER_RO(i), REAL_RO(p), nrows[k], ncols[k]);
+        else if (TYPEOF(p) == INTSXP) spcat_add(cat, REAL_RO(x), INTEGER_RO(i), INTEGER_RO(p), nrows[k], ncols[k]);
+        else throw std::invalid_argument("p must be integer or double");
+        if (cat.parts.back().p.back() != Rf_xlength(x)) throw std::invalid_argument("p does not end at the number of non-zeros");
+    }
+}
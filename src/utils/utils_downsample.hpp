@@ -0,0 +1,38 @@
+#pragma once 
+
+#include <stddef.h>
+#include <cstdint>
+
+/*
+ * count downsampling for R dgCMatrix / dgCMatrix64, cells in columns.
+ *
+ * each column with more than its target total is thinned:
+ *   method 0 (binomial):        each count c becomes Binomial(c, target / total).  expected total is target.
+ *   method 1 (hypergeometric):  target counts are drawn without replacement.  total is exactly target.
+ * columns at or below target are copied.  values are rounded to integer counts.
+ * column j uses its own random stream derived from (seed, j), so results do not depend on the thread count.
+ */
+
+// pass 1:  sample every column into xs / is (aligned with x), survivors compacted to the front of the column's range.
+// counts[j] is the number of nonzeros kept in column j.  targets has 1 (recycled) or cols entries.
+template <typename XVEC, typename IVEC, typename PVEC, typename TVEC>
+extern void csc_downsample_cols(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & cols,
+    TVEC const & targets, 
+    int const & method, 
+    uint64_t const & seed,
+    double * xs, int * is, size_t * counts,
+    int const & threads);
+
+// pass 2:  copy the compacted columns to the output.  out_p has cols + 1 entries, computed from counts.
+template <typename PVEC, typename OXVEC, typename OIVEC, typename OPVEC>
+extern void csc_compact_cols(
+    double const * xs, int const * is, 
+    PVEC const & p, 
+    OPVEC const & out_p, 
+    size_t const & cols,
+    OXVEC & out_x, OIVEC & out_i,
+    int const & threads);
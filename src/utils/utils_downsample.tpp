@@ -0,0 +1,165 @@
+#pragma once
+
+#include "utils_downsample.hpp"
+#include "utils_random.hpp"
+
+/*
+ * count downsampling for R dgCMatrix / dgCMatrix64
+ *
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include <omp.h>
+
+
+static inline double _lchoose(double const & n, double const & k) {
+    return lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0);
+}
+
+// inversion, searching outward from the mode so the pmf never underflows and the cost is O(sd).
+// up(x) = pmf(x + 1) / pmf(x),  down(x) = pmf(x - 1) / pmf(x).
+template <typename UP, typename DOWN>
+static inline long _inverse_from_mode(double u, long const & lo, long const & hi, long const & mode, double const & pmode, 
+    UP const & up, DOWN const & down) {
+    u -= pmode;
+    if (u < 0) return mode;
+    long l = mode, r = mode;
+    double pl = pmode, pr = pmode;
+    while ((l > lo) || (r < hi)) {
+        if (r < hi) {
+            pr *= up(r);
+            ++r;
+            u -= pr;
+            if (u < 0) return r;
+        }
+        if (l > lo) {
+            pl *= down(l);
+            --l;
+            u -= pl;
+            if (u < 0) return l;
+        }
+    }
+    return mode;   // rounding leftover.
+}
+
+static inline long _binomial(splitmix64_stream & rng, long const & n, double const & prob) {
+    if ((n <= 0) || (prob <= 0)) return 0;
+    if (prob >= 1) return n;
+    double q = 1.0 - prob;
+    double pq = prob / q;
+    long mode = std::min(n, static_cast<long>(floor((n + 1) * prob)));
+    double pmode = exp(_lchoose(n, mode) + mode * log(prob) + (n - mode) * log1p(-prob));
+    return _inverse_from_mode(rng.uniform(), 0, n, mode, pmode,
+        [n, pq](long const & x) { return static_cast<double>(n - x) / static_cast<double>(x + 1) * pq; },
+        [n, pq](long const & x) { return static_cast<double>(x) / static_cast<double>(n - x + 1) / pq; });
+}
+
+// number of successes in k draws without replacement, c successes in a population of N.
+static inline long _hypergeometric(splitmix64_stream & rng, long const & c, long const & N, long const & k) {
+    long lo = std::max(0L, k - (N - c));
+    long hi = std::min(c, k);
+    if (lo >= hi) return lo;
+    long mode = static_cast<long>(floor(static_cast<double>(k + 1) * static_cast<double>(c + 1) / static_cast<double>(N + 2)));
+    mode = std::min(hi, std::max(lo, mode));
+    double pmode = exp(_lchoose(c, mode) + _lchoose(N - c, k - mode) - _lchoose(N, k));
+    long f = N - c - k;
+    return _inverse_from_mode(rng.uniform(), lo, hi, mode, pmode,
+        [c, k, f](long const & x) { return static_cast<double>(c - x) * static_cast<double>(k - x) / (static_cast<double>(x + 1) * static_cast<double>(f + x + 1)); },
+        [c, k, f](long const & x) { return static_cast<double>(x) * static_cast<double>(f + x) / (static_cast<double>(c - x + 1) * static_cast<double>(k - x + 1)); });
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC, typename TVEC>
+extern void csc_downsample_cols(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & cols,
+    TVEC const & targets, 
+    int const & method, 
+    uint64_t const & seed,
+    double * xs, int * is, size_t * counts,
+    int const & threads) {
+
+    size_t ntargets = targets.size();
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    size_t start, end2, out;
+    long total, target, c, h, remaining;
+    for (; offset < end; ++offset) {
+        start = p[offset];
+        end2 = p[offset + 1];
+        target = static_cast<long>(round(targets[ntargets == 1 ? 0 : offset]));
+
+        total = 0;
+        for (size_t e = start; e < end2; ++e) {
+            total += static_cast<long>(round(x[e]));
+        }
+
+        splitmix64_stream rng(seed, offset);
+        out = start;
+        remaining = total;
+        for (size_t e = start; e < end2; ++e) {
+            c = static_cast<long>(round(x[e]));
+            if (total <= target) h = c;
+            else if (method == 0) h = _binomial(rng, c, static_cast<double>(target) / static_cast<double>(total));
+            else {
+                h = _hypergeometric(rng, c, remaining, target);
+                remaining -= c;
+                target -= h;
+            }
+            // drop new zeros in the same pass.
+            if (h > 0) {
+                xs[out] = static_cast<double>(h);
+                is[out] = i[e];
+                ++out;
+            }
+        }
+        counts[offset] = out - start;
+    }
+}
+
+}
+
+
+template <typename PVEC, typename OXVEC, typename OIVEC, typename OPVEC>
+extern void csc_compact_cols(
+    double const * xs, int const * is, 
+    PVEC const & p, 
+    OPVEC const & out_p, 
+    size_t const & cols,
+    OXVEC & out_x, OIVEC & out_i,
+    int const & threads) {
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    size_t start, ostart, n;
+    for (; offset < end; ++offset) {
+        start = p[offset];
+        ostart = out_p[offset];
+        n = static_cast<size_t>(out_p[offset + 1]) - ostart;
+        for (size_t e = 0; e < n; ++e) {
+            out_x[ostart + e] = xs[start + e];
+            out_i[ostart + e] = is[start + e];
+        }
+    }
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once 
+
+#include <stddef.h>
+
+/*
+ * array log1p / expm1 with selectable accuracy.
+ *
+ *  MATH_STRICT:  libm log1p / expm1 per element.  bitwise identical to R.
+ *  MATH_FAST:    branch-free polynomial kernels, vectorized, with an AVX2 build selected at runtime
+ *                by CPU features.  max error 2 ulp for log1p, 3 ulp for expm1 (tested against long double).
+ *                FMA is not used, so all dispatch paths give the same results.
+ *                non-finite inputs and inputs outside the kernel's range fall back to libm.
+ *
+ * the mode is process wide.  set it before starting a computation, not during one.
+ */
+
+#define MATH_STRICT 0
+#define MATH_FAST 1
+
+extern int get_math_mode();
+// returns the previous mode.
+extern int set_math_mode(int const & mode);
+// name of the kernel selected for the current CPU:  "avx2" or "generic".
+extern char const * fast_math_target();
+
+// out may alias in.
+extern void vec_log1p(double const * in, size_t const & n, double * out);
+extern void vec_expm1(double const * in, size_t const & n, double * out);
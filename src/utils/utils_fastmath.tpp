@@ -0,0 +1,190 @@
+#pragma once
+
+#include "utils_fastmath.hpp"
+
+/*
+ * array log1p / expm1 with selectable accuracy.
+ *
+ */
+
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+
+static int _math_mode = MATH_STRICT;
+
+extern int get_math_mode() {
+    return _math_mode;
+}
+
+extern int set_math_mode(int const & mode) {
+    int old = _math_mode;
+    _math_mode = (mode == MATH_FAST) ? MATH_FAST : MATH_STRICT;
+    return old;
+}
+
+
+static inline double _as_double(uint64_t const & v) {
+    double d;
+    memcpy(&d, &v, sizeof(double));
+    return d;
+}
+static inline uint64_t _as_bits(double const & d) {
+    uint64_t v;
+    memcpy(&v, &d, sizeof(double));
+    return v;
+}
+
+static double const _ln2_hi = 6.93147180369123816490e-01;   // upper bits of ln2, k * _ln2_hi is exact.
+static double const _ln2_lo = 1.90821492927058770002e-10;
+
+// log1p for finite x > -1.  log(u) with u = 1 + x, plus the rounding error of 1 + x.
+// u = 2^k * m with m in [sqrt(1/2), sqrt(2)), log(m) = 2 atanh(s) with s = (m - 1) / (m + 1), |s| < 0.1716.
+static inline double _fast_log1p(double const & x) {
+    double u = 1.0 + x;
+    double c = (x - (u - 1.0)) / u;
+
+    // shift the exponent so the mantissa lands in [sqrt(1/2), sqrt(2)).
+    uint64_t bits = _as_bits(u) + (0x3ff0000000000000ULL - 0x3fe6a09e667f3bcdULL);
+    double e = _as_double(0x4330000000000000ULL | (bits >> 52)) - 4503599627370496.0;   // biased exponent as double, no int64 conversion.
+    double k = e - 1023.0;
+    double m = _as_double((bits & 0x000fffffffffffffULL) + 0x3fe6a09e667f3bcdULL);
+
+    double f = m - 1.0;
+    double hf = 0.5 * f * f;
+    double s = f / (2.0 + f);
+    double z = s * s;
+    // log(m) = 2s + s R(z),  R(z) = 2z/3 + 2z^2/5 + ...   with 2s = f - s f:  log(m) = f - (f^2/2 - s (f^2/2 + R)).
+    double R = z * (2.0/3.0 + z * (2.0/5.0 + z * (2.0/7.0 + z * (2.0/9.0 + z * (2.0/11.0 + 
+        z * (2.0/13.0 + z * (2.0/15.0 + z * (2.0/17.0 + z * (2.0/19.0)))))))));
+    double logm = f - (hf - s * (hf + R));
+    return k * _ln2_hi + (logm + (k * _ln2_lo + c));
+}
+
+// expm1 for x in [-700, 700].  x = k ln2 + r, |r| <= ln2 / 2.  expm1(x) = 2^k expm1(r) + (2^k - 1).
+static inline double _fast_expm1(double const & x) {
+    // round to nearest with the 1.5 * 2^52 shifter.  k is in the low bits of t, again without int64 conversion.
+    double t = x * 1.44269504088896338700e+00 + 6755399441055744.0;
+    double k = t - 6755399441055744.0;
+    double r = (x - k * _ln2_hi) - k * _ln2_lo;
+    double scale = _as_double((_as_bits(t) + 1023ULL) << 52);    // 2^k
+
+    // Taylor series of expm1(r) to r^14 / 14!, |r|^15 / 15! < 1e-19 for |r| <= ln2 / 2.
+    double p = r * (1.0/87178291200.0);                   // 1/14!
+    p = r * (1.0/6227020800.0 + p);                       // 1/13!
+    p = r * (1.0/479001600.0 + p);
+    p = r * (1.0/39916800.0 + p);
+    p = r * (1.0/3628800.0 + p);
+    p = r * (1.0/362880.0 + p);
+    p = r * (1.0/40320.0 + p);
+    p = r * (1.0/5040.0 + p);
+    p = r * (1.0/720.0 + p);
+    p = r * (1.0/120.0 + p);
+    p = r * (1.0/24.0 + p);
+    p = r * (1.0/6.0 + p);
+    p = r * r * (0.5 + p);                                // expm1(r) - r
+    return scale * (r + p) + (scale - 1.0);
+}
+
+
+// ------- array kernels.  the scalar pass afterwards patches inputs outside the fast kernels' range.
+
+static inline void _fast_log1p_loop(double const * in, size_t const & n, double * out) {
+#pragma omp simd
+    for (size_t e = 0; e < n; ++e) {
+        out[e] = _fast_log1p(in[e]);
+    }
+}
+static inline void _fast_expm1_loop(double const * in, size_t const & n, double * out) {
+#pragma omp simd
+    for (size_t e = 0; e < n; ++e) {
+        out[e] = _fast_expm1(in[e]);
+    }
+}
+
+static void _fast_log1p_generic(double const * in, size_t const & n, double * out) { _fast_log1p_loop(in, n, out); }
+static void _fast_expm1_generic(double const * in, size_t const & n, double * out) { _fast_expm1_loop(in, n, out); }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FASTDE_HAS_AVX2_DISPATCH
+// same source, compiled for AVX2 only.  no FMA, so results match the generic build.
+__attribute__((target("avx2")))
+static void _fast_log1p_avx2(double const * in, size_t const & n, double * out) { _fast_log1p_loop(in, n, out); }
+__attribute__((target("avx2")))
+static void _fast_expm1_avx2(double const * in, size_t const & n, double * out) { _fast_expm1_loop(in, n, out); }
+#endif
+
+typedef void (*_fast_math_kernel)(double const *, size_t const &, double *);
+
+struct _fast_math_dispatch {
+    _fast_math_kernel log1p_k;
+    _fast_math_kernel expm1_k;
+    char const * target;
+
+    _fast_math_dispatch() : log1p_k(_fast_log1p_generic), expm1_k(_fast_expm1_generic), target("generic") {
+#ifdef FASTDE_HAS_AVX2_DISPATCH
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            log1p_k = _fast_log1p_avx2;
+            expm1_k = _fast_expm1_avx2;
+            target = "avx2";
+        }
+#endif
+    }
+};
+
+// resolved once, at first use.
+static _fast_math_dispatch const & _get_fast_math_dispatch() {
+    static _fast_math_dispatch d;
+    return d;
+}
+
+extern char const * fast_math_target() {
+    return _get_fast_math_dispatch().target;
+}
+
+
+extern void vec_log1p(double const * in, size_t const & n, double * out) {
+    if (_math_mode == MATH_STRICT) {
+        for (size_t e = 0; e < n; ++e) {
+            out[e] = log1p(in[e]);
+        }
+        return;
+    }
+
+    // in may alias out, so the range check has to happen before the kernel overwrites in.
+    // inputs are almost always in range, so do the check once and patch only if needed.
+    bool in_range = true;
+    for (size_t e = 0; e < n; ++e) {
+        in_range &= ((in[e] > -1.0) && (in[e] <= 1.0e300));    // also false for NaN.
+    }
+    if (in_range) {
+        _get_fast_math_dispatch().log1p_k(in, n, out);
+    } else {
+        for (size_t e = 0; e < n; ++e) {
+            out[e] = ((in[e] > -1.0) && (in[e] <= 1.0e300)) ? _fast_log1p(in[e]) : log1p(in[e]);
+        }
+    }
+}
+
+extern void vec_expm1(double const * in, size_t const & n, double * out) {
+    if (_math_mode == MATH_STRICT) {
+        for (size_t e = 0; e < n; ++e) {
+            out[e] = expm1(in[e]);
+        }
+        return;
+    }
+
+    bool in_range = true;
+    for (size_t e = 0; e < n; ++e) {
+        in_range &= ((in[e] >= -700.0) && (in[e] <= 700.0));
+    }
+    if (in_range) {
+        _get_fast_math_dispatch().expm1_k(in, n, out);
+    } else {
+        for (size_t e = 0; e < n; ++e) {
+            out[e] = ((in[e] >= -700.0) && (in[e] <= 700.0)) ? _fast_expm1(in[e]) : expm1(in[e]);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include <hdf5.h>
+
+/*
+ * native HDF5 access for large sparse matrices (10X CellRanger, AnnData h5ad, loom).
+ *
+ * all HDF5 library calls are made by the calling thread.  bulk 1D datasets are located in the file
+ * (offset of a contiguous dataset, or address of each chunk), then read with pread and decoded by
+ * the OpenMP threads (inflate, unshuffle, byte order and type conversion) directly into the output array.
+ * chunks that cannot be decoded this way (other filters, unallocated chunks, user block) go through H5Dread.
+ *
+ * writing is the reverse:  bulk 1D datasets are chunked with shuffle and deflate filters, the OpenMP threads
+ * convert, shuffle and compress the chunks, and the calling thread stores them with H5Dwrite_chunk.
+ */
+
+// owns an HDF5 identifier and releases it with the matching close function.
+struct h5_id {
+    hid_t id;
+    herr_t (*closer)(hid_t);
+
+    h5_id(hid_t const & _id, herr_t (*_closer)(hid_t)) : id(_id), closer(_closer) {}
+    ~h5_id() { if (id >= 0) closer(id); }
+    h5_id(h5_id const & other) = delete;
+    h5_id & operator=(h5_id const & other) = delete;
+
+    operator hid_t() const { return id; }
+};
+
+// open an existing file.  throws std::runtime_error on failure.
+extern hid_t h5_open_file(std::string const & filename);
+
+// true if every component of the "/" separated path exists under loc.
+extern bool h5_exists(hid_t const & loc, std::string const & path);
+
+// names of the groups directly under path, in name order.
+extern std::vector<std::string> h5_list_groups(hid_t const & loc, std::string const & path);
+
+// true if path is a group (e.g. a sparse matrix in h5ad), false if it is a dataset.
+extern bool h5_is_group(hid_t const & loc, std::string const & path);
+
+// number of elements in a 1D dataset.
+extern size_t h5_length(hid_t const & loc, std::string const & path);
+
+// dimensions of a dataset.
+extern std::vector<size_t> h5_dims(hid_t const & loc, std::string const & path);
+
+// true if the object at path has the attribute.
+extern bool h5_attr_exists(hid_t const & loc, std::string const & path, std::string const & name);
+
+// scalar or 1D string attribute.
+extern std::vector<std::string> h5_read_attr_strings(hid_t const & loc, std::string const & path, std::string const & name);
+
+// scalar or 1D numeric attribute.
+extern std::vector<double> h5_read_attr_doubles(hid_t const & loc, std::string const & path, std::string const & name);
+
+// 1D fixed or variable length string dataset.
+extern std::vector<std::string> h5_read_strings(hid_t const & loc, std::string const & path);
+
+// read elements [start, start + count) of a 1D integer or float dataset into out, converting to OT.
+template <typename OT>
+extern void h5_read_1d(hid_t const & file, std::string const & path,
+    size_t const & start, size_t const & count, OT * out, int const & threads);
+
+// sparsify a 2D dense dataset (e.g. loom /matrix) into CSC, reading panels of whole rows or columns, in two passes.
+// cols_are_rows:  each HDF5 row becomes an output column (cells x genes dense h5ad X), otherwise 
+// each HDF5 column becomes an output column (genes x cells loom).
+// h5_count_dense_csc:  the shape, and p with ncol + 1 entries.
+template <typename PT>
+extern void h5_count_dense_csc(hid_t const & file, std::string const & path, bool const & cols_are_rows,
+    std::vector<PT> & p, size_t & nrow, size_t & ncol, int const & threads);
+// h5_read_dense_csc:  x and i, p[ncol] elements each, at the offsets p from h5_count_dense_csc.
+template <typename XT, typename PT>
+extern void h5_read_dense_csc(hid_t const & file, std::string const & path, bool const & cols_are_rows,
+    PT const * p, XT * x, int * i, int const & threads);
+
+// filtered reads of a CSC matrix stored as 1D data (x_path) and indices (i_path) datasets, given the indptr p
+// already read.  cols:  ascending column ids to read.  rowmap:  for each row, the output row id or -1 to drop it;
+// empty keeps all rows unchanged.  only the index ranges of the selected columns are read.
+
+// per selected column, the number of entries in kept rows and optionally (sums not NULL) the sum of their values.
+// without a row filter the counts come from p and, if sums is NULL, nothing is read.
+extern void h5_csc_column_stats(hid_t const & file, std::string const & x_path, std::string const & i_path,
+    long const * p, std::vector<size_t> const & cols, std::vector<int> const & rowmap,
+    size_t * counts, double * sums, int const & threads);
+
+// number of entries of each of the nrow rows in the selected columns.
+extern void h5_csc_row_counts(hid_t const & file, std::string const & i_path,
+    long const * p, std::vector<size_t> const & cols, size_t const & nrow,
+    size_t * counts, int const & threads);
+
+// read the selected columns into x and i.  offsets (cols.size() + 1 entries) are the output column pointers,
+// from the counts of h5_csc_column_stats with the same rowmap.
+extern void h5_read_csc_filtered(hid_t const & file, std::string const & x_path, std::string const & i_path,
+    long const * p, std::vector<size_t> const & cols, std::vector<int> const & rowmap,
+    size_t const * offsets, double * x, int * i, int const & threads);
+
+// create or truncate a file for writing.  throws std::runtime_error on failure.
+extern hid_t h5_create_file(std::string const & filename);
+
+// create a group, including any missing intermediate groups.
+extern hid_t h5_create_group(hid_t const & loc, std::string const & path);
+
+// 1D fixed length string dataset, deflated at level (0 for none) by the library.
+extern void h5_write_strings(hid_t const & loc, std::string const & path, std::vector<std::string> const & vals, int const & level);
+
+// 1D dataset of count elements, stored little endian as ST (double, int32_t, int64_t), in chunks of chunk elements.
+// level > 0:  shuffle and deflate filters, compressed by the threads and written as raw chunks.
+template <typename IT, typename ST>
+extern void h5_write_1d(hid_t const & loc, std::string const & path, IT const * in, size_t const & count,
+    size_t const & chunk, int const & level, int const & threads);
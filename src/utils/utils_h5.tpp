@@ -0,0 +1,909 @@
+#pragma once
+
+#include "utils_h5.hpp"
+
+/*
+ * native HDF5 access for large sparse matrices
+ *
+ */
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <omp.h>
+
+#include "utils_pipeline.hpp"
+
+
+hid_t h5_open_file(std::string const & filename) {
+    // errors are reported through the return codes, not printed.
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+    hid_t file = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    if (file < 0) throw std::runtime_error("unable to open HDF5 file " + filename);
+    return file;
+}
+
+bool h5_exists(hid_t const & loc, std::string const & path) {
+    // H5Lexists requires all intermediate components to exist, so check them one by one.
+    size_t pos = 0;
+    while (pos != std::string::npos) {
+        pos = path.find('/', pos + 1);
+        std::string prefix = path.substr(0, pos);
+        if (prefix.empty() || prefix == "/") continue;
+        if (H5Lexists(loc, prefix.c_str(), H5P_DEFAULT) <= 0) return false;
+    }
+    return true;
+}
+
+static herr_t _h5_group_names_cb(hid_t loc, char const * name, H5L_info_t const * /* info */, void * data) {
+    H5O_info_t oinfo;
+    if (H5Oget_info_by_name(loc, name, &oinfo, H5P_DEFAULT) >= 0 && oinfo.type == H5O_TYPE_GROUP)
+        static_cast<std::vector<std::string> *>(data)->push_back(name);
+    return 0;
+}
+
+std::vector<std::string> h5_list_groups(hid_t const & loc, std::string const & path) {
+    std::vector<std::string> names;
+    h5_id group(H5Gopen2(loc, path.c_str(), H5P_DEFAULT), H5Gclose);
+    if (group < 0) throw std::runtime_error("unable to open HDF5 group " + path);
+    H5Literate(group, H5_INDEX_NAME, H5_ITER_INC, NULL, _h5_group_names_cb, &names);
+    return names;
+}
+
+static hid_t _h5_open_1d(hid_t const & loc, std::string const & path, size_t & len) {
+    hid_t dset = H5Dopen2(loc, path.c_str(), H5P_DEFAULT);
+    if (dset < 0) throw std::runtime_error("unable to open HDF5 dataset " + path);
+    h5_id space(H5Dget_space(dset), H5Sclose);
+    int rank = H5Sget_simple_extent_ndims(space);
+    hsize_t dims[1] = {0};
+    if (rank != 1) {
+        H5Dclose(dset);
+        throw std::runtime_error("HDF5 dataset " + path + " is not one dimensional");
+    }
+    H5Sget_simple_extent_dims(space, dims, NULL);
+    len = dims[0];
+    return dset;
+}
+
+size_t h5_length(hid_t const & loc, std::string const & path) {
+    size_t len;
+    h5_id dset(_h5_open_1d(loc, path, len), H5Dclose);
+    return len;
+}
+
+bool h5_is_group(hid_t const & loc, std::string const & path) {
+    H5O_info_t oinfo;
+    if (H5Oget_info_by_name(loc, path.c_str(), &oinfo, H5P_DEFAULT) < 0) 
+        throw std::runtime_error("unable to find HDF5 object " + path);
+    return oinfo.type == H5O_TYPE_GROUP;
+}
+
+std::vector<size_t> h5_dims(hid_t const & loc, std::string const & path) {
+    h5_id dset(H5Dopen2(loc, path.c_str(), H5P_DEFAULT), H5Dclose);
+    if (dset < 0) throw std::runtime_error("unable to open HDF5 dataset " + path);
+    h5_id space(H5Dget_space(dset), H5Sclose);
+    int rank = H5Sget_simple_extent_ndims(space);
+    std::vector<hsize_t> dims(std::max(rank, 0));
+    H5Sget_simple_extent_dims(space, dims.data(), NULL);
+    return std::vector<size_t>(dims.begin(), dims.end());
+}
+
+bool h5_attr_exists(hid_t const & loc, std::string const & path, std::string const & name) {
+    return h5_exists(loc, path) && (H5Aexists_by_name(loc, path.c_str(), name.c_str(), H5P_DEFAULT) > 0);
+}
+
+// strings from a dataset or attribute of string type ftype with len elements.
+static std::vector<std::string> _h5_read_str(hid_t const & obj, bool const & is_attr, hid_t const & ftype, 
+    hid_t const & space, size_t const & len) {
+
+    std::vector<std::string> out;
+    out.reserve(len);
+    if (len == 0) return out;
+    herr_t status;
+
+    if (H5Tis_variable_str(ftype) > 0) {
+        h5_id mtype(H5Tcopy(H5T_C_S1), H5Tclose);
+        H5Tset_size(mtype, H5T_VARIABLE);
+        H5Tset_cset(mtype, H5Tget_cset(ftype));
+        std::vector<char *> buf(len);
+        status = is_attr ? H5Aread(obj, mtype, buf.data()) : H5Dread(obj, mtype, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf.data());
+        if (status < 0) throw std::runtime_error("unable to read HDF5 strings");
+        for (size_t k = 0; k < len; ++k) out.emplace_back(buf[k] == NULL ? "" : buf[k]);
+        H5Dvlen_reclaim(mtype, space, H5P_DEFAULT, buf.data());
+    } else {
+        // fixed length: read as null padded so that each string is at most size bytes, without terminator.
+        size_t size = H5Tget_size(ftype);
+        h5_id mtype(H5Tcopy(H5T_C_S1), H5Tclose);
+        H5Tset_size(mtype, size);
+        H5Tset_strpad(mtype, H5T_STR_NULLPAD);
+        H5Tset_cset(mtype, H5Tget_cset(ftype));
+        std::vector<char> buf(len * size);
+        status = is_attr ? H5Aread(obj, mtype, buf.data()) : H5Dread(obj, mtype, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf.data());
+        if (status < 0) throw std::runtime_error("unable to read HDF5 strings");
+        char const * s;
+        for (size_t k = 0; k < len; ++k) {
+            s = buf.data() + k * size;
+            out.emplace_back(s, strnlen(s, size));
+        }
+    }
+    return out;
+}
+
+std::vector<std::string> h5_read_strings(hid_t const & loc, std::string const & path) {
+    size_t len;
+    h5_id dset(_h5_open_1d(loc, path, len), H5Dclose);
+    h5_id ftype(H5Dget_type(dset), H5Tclose);
+    if (H5Tget_class(ftype) != H5T_STRING) throw std::runtime_error("HDF5 dataset " + path + " is not a string dataset");
+    h5_id space(H5Dget_space(dset), H5Sclose);
+    return _h5_read_str(dset, false, ftype, space, len);
+}
+
+static hid_t _h5_open_attr(hid_t const & loc, std::string const & path, std::string const & name, size_t & len) {
+    hid_t attr = H5Aopen_by_name(loc, path.c_str(), name.c_str(), H5P_DEFAULT, H5P_DEFAULT);
+    if (attr < 0) throw std::runtime_error("unable to open HDF5 attribute " + path + ":" + name);
+    h5_id space(H5Aget_space(attr), H5Sclose);
+    hssize_t n = H5Sget_simple_extent_npoints(space);
+    len = (n < 0) ? 0 : n;
+    return attr;
+}
+
+std::vector<std::string> h5_read_attr_strings(hid_t const & loc, std::string const & path, std::string const & name) {
+    size_t len;
+    h5_id attr(_h5_open_attr(loc, path, name, len), H5Aclose);
+    h5_id ftype(H5Aget_type(attr), H5Tclose);
+    if (H5Tget_class(ftype) != H5T_STRING) throw std::runtime_error("HDF5 attribute " + path + ":" + name + " is not a string");
+    h5_id space(H5Aget_space(attr), H5Sclose);
+    return _h5_read_str(attr, true, ftype, space, len);
+}
+
+std::vector<double> h5_read_attr_doubles(hid_t const & loc, std::string const & path, std::string const & name) {
+    size_t len;
+    h5_id attr(_h5_open_attr(loc, path, name, len), H5Aclose);
+    std::vector<double> out(len);
+    if ((len > 0) && (H5Aread(attr, H5T_NATIVE_DOUBLE, out.data()) < 0))
+        throw std::runtime_error("unable to read HDF5 attribute " + path + ":" + name);
+    return out;
+}
+
+
+// ----- bulk numeric read
+
+template <typename OT> static hid_t _h5_mem_type();
+template <> hid_t _h5_mem_type<double>() { return H5T_NATIVE_DOUBLE; }
+template <> hid_t _h5_mem_type<int>() { return H5T_NATIVE_INT; }
+template <> hid_t _h5_mem_type<long>() { return H5T_NATIVE_LONG; }
+
+// read [start, start+count) through the library.  HDF5 does the type conversion.
+template <typename OT>
+static void _h5_read_hyperslab(hid_t const & dset, size_t const & start, size_t const & count, OT * out) {
+    if (count == 0) return;
+    h5_id fspace(H5Dget_space(dset), H5Sclose);
+    hsize_t st[1] = {start}, cnt[1] = {count};
+    H5Sselect_hyperslab(fspace, H5S_SELECT_SET, st, NULL, cnt, NULL);
+    h5_id mspace(H5Screate_simple(1, cnt, NULL), H5Sclose);
+    if (H5Dread(dset, _h5_mem_type<OT>(), mspace, fspace, H5P_DEFAULT, out) < 0)
+        throw std::runtime_error("HDF5 read failed");
+}
+
+// on-disk element type, for the types decoded here.
+struct _h5_dtype {
+    bool is_float;
+    bool is_signed;
+    bool swap;
+    size_t size;
+};
+
+static bool _h5_get_dtype(hid_t const & dset, _h5_dtype & dt) {
+    h5_id ftype(H5Dget_type(dset), H5Tclose);
+    H5T_class_t cls = H5Tget_class(ftype);
+    dt.size = H5Tget_size(ftype);
+    H5T_order_t native = H5Tget_order(H5T_NATIVE_INT);
+    dt.swap = (H5Tget_order(ftype) != native);
+    if (cls == H5T_INTEGER) {
+        dt.is_float = false;
+        dt.is_signed = (H5Tget_sign(ftype) == H5T_SGN_2);
+        return (dt.size == 1) || (dt.size == 2) || (dt.size == 4) || (dt.size == 8);
+    } else if (cls == H5T_FLOAT) {
+        dt.is_float = true;
+        dt.is_signed = true;
+        return ((dt.size == 4) && (H5Tequal(ftype, H5T_IEEE_F32LE) > 0 || H5Tequal(ftype, H5T_IEEE_F32BE) > 0)) ||
+            ((dt.size == 8) && (H5Tequal(ftype, H5T_IEEE_F64LE) > 0 || H5Tequal(ftype, H5T_IEEE_F64BE) > 0));
+    }
+    return false;
+}
+
+template <typename ST, typename OT>
+static inline void _h5_convert(unsigned char const * src, size_t const & n, OT * out) {
+    ST v;
+    for (size_t k = 0; k < n; ++k) {
+        memcpy(&v, src + k * sizeof(ST), sizeof(ST));
+        out[k] = static_cast<OT>(v);
+    }
+}
+
+// n elements of type dt from src (byte swapped in place if needed) into out.
+template <typename OT>
+static void _h5_decode(unsigned char * src, size_t const & n, _h5_dtype const & dt, OT * out) {
+    if (dt.swap && dt.size > 1) {
+        for (unsigned char * e = src; e < src + n * dt.size; e += dt.size) std::reverse(e, e + dt.size);
+    }
+    if (dt.is_float) {
+        if (dt.size == 4) _h5_convert<float>(src, n, out);
+        else _h5_convert<double>(src, n, out);
+    } else if (dt.is_signed) {
+        switch (dt.size) {
+            case 1: _h5_convert<int8_t>(src, n, out); break;
+            case 2: _h5_convert<int16_t>(src, n, out); break;
+            case 4: _h5_convert<int32_t>(src, n, out); break;
+            default: _h5_convert<int64_t>(src, n, out); break;
+        }
+    } else {
+        switch (dt.size) {
+            case 1: _h5_convert<uint8_t>(src, n, out); break;
+            case 2: _h5_convert<uint16_t>(src, n, out); break;
+            case 4: _h5_convert<uint32_t>(src, n, out); break;
+            default: _h5_convert<uint64_t>(src, n, out); break;
+        }
+    }
+}
+
+static bool _h5_pread(int const & fd, unsigned char * buf, size_t const & bytes, size_t const & offset) {
+    size_t done = 0;
+    ssize_t got;
+    while (done < bytes) {
+        got = pread(fd, buf + done, bytes - done, offset + done);
+        if (got <= 0) return false;
+        done += got;
+    }
+    return true;
+}
+
+static void _h5_unshuffle(unsigned char const * in, size_t const & bytes, size_t const & size, unsigned char * out) {
+    size_t n = bytes / size;
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t b = 0; b < size; ++b) out[k * size + b] = in[b * n + k];
+    }
+    // trailing bytes are left unshuffled by the filter.
+    memcpy(out + n * size, in + n * size, bytes - n * size);
+}
+
+// the library's Fletcher-32:  big endian 16 bit words, the last odd byte as the high half of a word.
+static uint32_t _h5_fletcher32(unsigned char const * data, size_t const & bytes) {
+    uint32_t sum1 = 0, sum2 = 0;
+    size_t len = bytes / 2, tlen;
+    while (len > 0) {
+        // folded before the sums can overflow.
+        tlen = std::min(len, static_cast<size_t>(360));
+        len -= tlen;
+        for (; tlen > 0; --tlen, data += 2) {
+            sum1 += (static_cast<uint32_t>(data[0]) << 8) | data[1];
+            sum2 += sum1;
+        }
+        sum1 = (sum1 & 0xffff) + (sum1 >> 16);
+        sum2 = (sum2 & 0xffff) + (sum2 >> 16);
+    }
+    if (bytes & 1) {
+        sum1 += static_cast<uint32_t>(data[0]) << 8;
+        sum2 += sum1;
+        sum1 = (sum1 & 0xffff) + (sum1 >> 16);
+        sum2 = (sum2 & 0xffff) + (sum2 >> 16);
+    }
+    sum1 = (sum1 & 0xffff) + (sum1 >> 16);
+    sum2 = (sum2 & 0xffff) + (sum2 >> 16);
+    return (sum2 << 16) | sum1;
+}
+
+template <typename OT>
+extern void h5_read_1d(hid_t const & file, std::string const & path,
+    size_t const & start, size_t const & count, OT * out, int const & threads) {
+
+    size_t len;
+    h5_id dset(_h5_open_1d(file, path, len), H5Dclose);
+    if (start + count > len) throw std::runtime_error("read past the end of HDF5 dataset " + path);
+    if (count == 0) return;
+
+    _h5_dtype dt;
+    h5_id fcpl(H5Fget_create_plist(file), H5Pclose);
+    hsize_t userblock = 0;
+    H5Pget_userblock(fcpl, &userblock);
+    h5_id fapl(H5Fget_access_plist(file), H5Pclose);
+    if (!_h5_get_dtype(dset, dt) || (H5Pget_driver(fapl) != H5FD_SEC2)) {
+        _h5_read_hyperslab(dset, start, count, out);
+        return;
+    }
+
+    h5_id dcpl(H5Dget_create_plist(dset), H5Pclose);
+    H5D_layout_t layout = H5Pget_layout(dcpl);
+
+    // contiguous datasets have a single file offset.  chunked datasets: one per chunk, plus a filter pipeline.
+    size_t csize;
+    std::vector<haddr_t> addrs;
+    std::vector<hsize_t> sizes;
+    std::vector<unsigned> masks;
+    std::vector<H5Z_filter_t> filters;
+    size_t first, nchunks;
+    if (layout == H5D_CONTIGUOUS) {
+        haddr_t addr = H5Dget_offset(dset);
+        if (addr == HADDR_UNDEF) {
+            _h5_read_hyperslab(dset, start, count, out);
+            return;
+        }
+        // split into pieces so that the threads are balanced and the read buffers stay small.
+        csize = std::min(static_cast<size_t>(1) << 22, 
+            std::max(static_cast<size_t>(1) << 16, (count + 4 * threads - 1) / (4 * threads)));
+        first = start / csize;
+        nchunks = (start + count - 1) / csize + 1 - first;
+        addrs.resize(nchunks);
+        sizes.resize(nchunks);
+        masks.assign(nchunks, 0);
+        for (size_t c = 0; c < nchunks; ++c) {
+            addrs[c] = addr + (first + c) * csize * dt.size;
+            sizes[c] = std::min(csize, len - (first + c) * csize) * dt.size;
+        }
+    } else if (layout == H5D_CHUNKED && userblock == 0) {
+        hsize_t cdims[1];
+        H5Pget_chunk(dcpl, 1, cdims);
+        csize = cdims[0];
+        int nfilters = H5Pget_nfilters(dcpl);
+        unsigned flags, config;
+        size_t nelem;
+        unsigned cd[8];
+        char name[32];
+        bool supported = true;
+        for (int f = 0; f < nfilters; ++f) {
+            nelem = 8;
+            filters.push_back(H5Pget_filter2(dcpl, f, &flags, &nelem, cd, sizeof(name), name, &config));
+            supported &= (filters.back() == H5Z_FILTER_DEFLATE) || (filters.back() == H5Z_FILTER_SHUFFLE) ||
+                (filters.back() == H5Z_FILTER_FLETCHER32);
+        }
+        if (!supported) {
+            _h5_read_hyperslab(dset, start, count, out);
+            return;
+        }
+        first = start / csize;
+        nchunks = (start + count - 1) / csize + 1 - first;
+        addrs.resize(nchunks);
+        sizes.resize(nchunks);
+        masks.resize(nchunks);
+        hsize_t coord[1];
+        for (size_t c = 0; c < nchunks; ++c) {
+            coord[0] = (first + c) * csize;
+            if (H5Dget_chunk_info_by_coord(dset, coord, &(masks[c]), &(addrs[c]), &(sizes[c])) < 0) addrs[c] = HADDR_UNDEF;
+        }
+    } else {
+        _h5_read_hyperslab(dset, start, count, out);
+        return;
+    }
+
+    std::string filename(H5Fget_name(file, NULL, 0) + 1, '\0');
+    H5Fget_name(file, &(filename[0]), filename.size());
+    filename.pop_back();
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        _h5_read_hyperslab(dset, start, count, out);
+        return;
+    }
+
+    // chunks that could not be decoded here are read through the library afterwards.
+    std::vector<unsigned char> failed(nchunks, 0);
+    size_t cbytes = csize * dt.size;
+
+#pragma omp parallel num_threads(threads)
+{
+    std::vector<unsigned char> raw, tmp;
+    size_t bytes, cstart, lo, hi;
+    uLongf outlen;
+    bool ok;
+
+#pragma omp for schedule(dynamic, 1)
+    for (size_t c = 0; c < nchunks; ++c) {
+        if (addrs[c] == HADDR_UNDEF) { failed[c] = 1; continue; }
+
+        bytes = sizes[c];
+        raw.resize(bytes);
+        if (!_h5_pread(fd, raw.data(), bytes, addrs[c])) { failed[c] = 1; continue; }
+
+        // undo the filters in reverse pipeline order.  bit f of the mask set means filter f was skipped.
+        ok = true;
+        for (int f = static_cast<int>(filters.size()) - 1; (f >= 0) && ok; --f) {
+            if (masks[c] & (1u << f)) continue;
+            if (filters[f] == H5Z_FILTER_FLETCHER32) {
+                // little endian checksum after the data.  a mismatch (or an old byte swapped checksum)
+                // is left to the library.
+                if (bytes < 4) ok = false;
+                else {
+                    bytes -= 4;
+                    ok = (_h5_fletcher32(raw.data(), bytes) == (static_cast<uint32_t>(raw[bytes]) |
+                        (static_cast<uint32_t>(raw[bytes + 1]) << 8) | (static_cast<uint32_t>(raw[bytes + 2]) << 16) |
+                        (static_cast<uint32_t>(raw[bytes + 3]) << 24)));
+                }
+            } else if (filters[f] == H5Z_FILTER_DEFLATE) {
+                tmp.resize(cbytes);
+                outlen = cbytes;
+                ok = (uncompress(tmp.data(), &outlen, raw.data(), bytes) == Z_OK);
+                bytes = outlen;
+                raw.swap(tmp);
+            } else {  // shuffle
+                tmp.resize(bytes);
+                _h5_unshuffle(raw.data(), bytes, dt.size, tmp.data());
+                raw.swap(tmp);
+            }
+        }
+        if (!ok) { failed[c] = 1; continue; }
+
+        // elements of this chunk that fall in the requested range.
+        cstart = (first + c) * csize;
+        lo = std::max(cstart, start);
+        hi = std::min(cstart + csize, start + count);
+        if ((hi - cstart) * dt.size > bytes) { failed[c] = 1; continue; }
+        _h5_decode(raw.data() + (lo - cstart) * dt.size, hi - lo, dt, out + (lo - start));
+    }
+}
+    close(fd);
+
+    size_t cstart, lo, hi;
+    for (size_t c = 0; c < nchunks; ++c) {
+        if (!failed[c]) continue;
+        cstart = (first + c) * csize;
+        lo = std::max(cstart, start);
+        hi = std::min(cstart + csize, start + count);
+        _h5_read_hyperslab(dset, lo, hi - lo, out + (lo - start));
+    }
+}
+
+
+// panels of whole rows or columns of a 2D dense dataset, read as doubles.
+struct _h5_dense_panels {
+    h5_id dset;
+    h5_id fspace;
+    bool cols_are_rows;
+    size_t nrow;
+    size_t ncol;
+    size_t width;
+    std::vector<double> buf;
+    // element (row r, panel column j) of the last panel is at buf[r * rstride + j * cstride]
+    size_t rstride;
+    size_t cstride;
+
+    _h5_dense_panels(hid_t const & file, std::string const & path, bool const & _cols_are_rows) :
+        dset(H5Dopen2(file, path.c_str(), H5P_DEFAULT), H5Dclose), fspace(-1, H5Sclose), cols_are_rows(_cols_are_rows) {
+        if (dset < 0) throw std::runtime_error("unable to open HDF5 dataset " + path);
+        fspace.id = H5Dget_space(dset);
+        if (H5Sget_simple_extent_ndims(fspace) != 2) throw std::runtime_error("HDF5 dataset " + path + " is not two dimensional");
+        hsize_t dims[2];
+        H5Sget_simple_extent_dims(fspace, dims, NULL);
+        nrow = cols_are_rows ? dims[1] : dims[0];
+        ncol = cols_are_rows ? dims[0] : dims[1];
+
+        // output columns per panel:  a multiple of the chunk extent along that dimension, about 64MB of doubles.
+        size_t step = 1;
+        h5_id dcpl(H5Dget_create_plist(dset), H5Pclose);
+        if (H5Pget_layout(dcpl) == H5D_CHUNKED) {
+            hsize_t cdims[2];
+            H5Pget_chunk(dcpl, 2, cdims);
+            step = cdims[cols_are_rows ? 0 : 1];
+        }
+        width = std::max(step, (static_cast<size_t>(1) << 23) / std::max(nrow, static_cast<size_t>(1)) / step * step);
+        width = std::min(width, std::max(ncol, static_cast<size_t>(1)));
+        buf.resize(width * nrow);
+    }
+
+    // read output columns [c0, c0 + w) into buf.
+    void read(size_t const & c0, size_t const & w, std::string const & path) {
+        hsize_t st[2], cnt[2];
+        st[0] = cols_are_rows ? c0 : 0;     st[1] = cols_are_rows ? 0 : c0;
+        cnt[0] = cols_are_rows ? w : nrow;  cnt[1] = cols_are_rows ? nrow : w;
+        H5Sselect_hyperslab(fspace, H5S_SELECT_SET, st, NULL, cnt, NULL);
+        h5_id mspace(H5Screate_simple(2, cnt, NULL), H5Sclose);
+        if (H5Dread(dset, H5T_NATIVE_DOUBLE, mspace, fspace, H5P_DEFAULT, buf.data()) < 0)
+            throw std::runtime_error("unable to read HDF5 dataset " + path);
+        rstride = cols_are_rows ? 1 : w;
+        cstride = cols_are_rows ? nrow : 1;
+    }
+};
+
+template <typename PT>
+extern void h5_count_dense_csc(hid_t const & file, std::string const & path, bool const & cols_are_rows,
+    std::vector<PT> & p, size_t & nrow, size_t & ncol, int const & threads) {
+
+    _h5_dense_panels panels(file, path, cols_are_rows);
+    nrow = panels.nrow;
+    ncol = panels.ncol;
+    p.assign(ncol + 1, 0);
+
+    size_t w;
+    for (size_t c0 = 0; c0 < ncol; c0 += panels.width) {
+        w = std::min(panels.width, ncol - c0);
+        panels.read(c0, w, path);
+
+        // per column counts, summed after the panel.
+#pragma omp parallel for num_threads(threads) schedule(static)
+        for (size_t j = 0; j < w; ++j) {
+            double const * col = panels.buf.data() + j * panels.cstride;
+            size_t cnz = 0;
+            for (size_t r = 0; r < nrow; ++r) cnz += (col[r * panels.rstride] != 0);
+            p[c0 + j + 1] = cnz;
+        }
+        for (size_t j = 0; j < w; ++j) p[c0 + j + 1] += p[c0 + j];
+    }
+}
+
+template <typename XT, typename PT>
+extern void h5_read_dense_csc(hid_t const & file, std::string const & path, bool const & cols_are_rows,
+    PT const * p, XT * x, int * i, int const & threads) {
+
+    _h5_dense_panels panels(file, path, cols_are_rows);
+    size_t const nrow = panels.nrow;
+    size_t const ncol = panels.ncol;
+
+    size_t w;
+    for (size_t c0 = 0; c0 < ncol; c0 += panels.width) {
+        w = std::min(panels.width, ncol - c0);
+        panels.read(c0, w, path);
+
+        // fill at the column offsets.  a column that changed since counting is an error.
+        int bad = 0;
+#pragma omp parallel for num_threads(threads) schedule(static) reduction(|:bad)
+        for (size_t j = 0; j < w; ++j) {
+            double const * col = panels.buf.data() + j * panels.cstride;
+            size_t e = p[c0 + j], e1 = p[c0 + j + 1];
+            double v;
+            for (size_t r = 0; r < nrow; ++r) {
+                v = col[r * panels.rstride];
+                if (v == 0) continue;
+                if (e == e1) { bad = 1; break; }
+                x[e] = v;
+                i[e] = r;
+                ++e;
+            }
+            bad |= (e != e1);
+        }
+        if (bad) throw std::runtime_error("HDF5 dataset " + path + " changed while reading");
+    }
+}
+
+// ----- filtered read of a CSC matrix (10X data / indices / indptr)
+
+// selected columns are grouped into blocks, each read with one h5_read_1d call per dataset.  a block spans
+// unselected columns only across small gaps, so that scattered selections do not decode unselected data,
+// and it is limited to about 16M elements (a single column may exceed this).  [first, last) index into cols.
+struct _h5_col_block {
+    size_t first;
+    size_t last;
+};
+
+static std::vector<_h5_col_block> _h5_column_blocks(long const * p, std::vector<size_t> const & cols) {
+    size_t const max_elems = static_cast<size_t>(1) << 24;
+    size_t const max_gap = static_cast<size_t>(1) << 16;
+    std::vector<_h5_col_block> blocks;
+    size_t k = 0, b;
+    long start;
+    while (k < cols.size()) {
+        b = k;
+        start = p[cols[k]];
+        for (++k; k < cols.size(); ++k) {
+            if (static_cast<size_t>(p[cols[k]] - p[cols[k - 1] + 1]) > max_gap) break;
+            if (static_cast<size_t>(p[cols[k] + 1] - start) > max_elems) break;
+        }
+        blocks.push_back({b, k});
+    }
+    return blocks;
+}
+
+// blocks read ahead by a background thread (HDF5 is only called from that thread meanwhile).  one is enough
+// to overlap reading with the per column work, and keeps memory at two blocks.
+#define H5_PREFETCH 1
+
+// buffers for one block, recycled by the read-ahead pipeline.
+struct _h5_csc_buf {
+    std::vector<int> i;
+    std::vector<double> x;
+};
+
+void h5_csc_column_stats(hid_t const & file, std::string const & x_path, std::string const & i_path,
+    long const * p, std::vector<size_t> const & cols, std::vector<int> const & rowmap,
+    size_t * counts, double * sums, int const & threads) {
+
+    size_t const ncols = cols.size();
+    if (rowmap.empty()) {
+        for (size_t k = 0; k < ncols; ++k) counts[k] = p[cols[k] + 1] - p[cols[k]];
+        if (sums == NULL) return;
+    }
+
+    // the next block is read and decoded while the current one is counted.
+    std::vector<_h5_col_block> const blocks = _h5_column_blocks(p, cols);
+    prefetch_pipeline<_h5_csc_buf>(blocks.size(), H5_PREFETCH,
+        [&](size_t const & b, _h5_csc_buf & buf) {
+            size_t bstart = p[cols[blocks[b].first]];
+            size_t bend = p[cols[blocks[b].last - 1] + 1];
+            if (!rowmap.empty()) {
+                buf.i.resize(bend - bstart);
+                h5_read_1d(file, i_path, bstart, bend - bstart, buf.i.data(), threads);
+            }
+            if (sums != NULL) {
+                buf.x.resize(bend - bstart);
+                h5_read_1d(file, x_path, bstart, bend - bstart, buf.x.data(), threads);
+            }
+        },
+        [&](size_t const & b, _h5_csc_buf & buf) {
+            _h5_col_block const & blk = blocks[b];
+            size_t bstart = p[cols[blk.first]];
+            std::vector<int> const & ibuf = buf.i;
+            std::vector<double> const & xbuf = buf.x;
+
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+            for (size_t k = blk.first; k < blk.last; ++k) {
+                size_t lo = p[cols[k]] - bstart, hi = p[cols[k] + 1] - bstart;
+                size_t cnt = 0;
+                double sum = 0;
+                int r;
+                for (size_t e = lo; e < hi; ++e) {
+                    if (!rowmap.empty()) {
+                        r = ibuf[e];
+                        if ((r < 0) || (static_cast<size_t>(r) >= rowmap.size()) || (rowmap[r] < 0)) continue;
+                    }
+                    ++cnt;
+                    if (sums != NULL) sum += xbuf[e];
+                }
+                if (!rowmap.empty()) counts[k] = cnt;
+                if (sums != NULL) sums[k] = sum;
+            }
+        });
+}
+
+void h5_csc_row_counts(hid_t const & file, std::string const & i_path,
+    long const * p, std::vector<size_t> const & cols, size_t const & nrow,
+    size_t * counts, int const & threads) {
+
+    std::vector<std::vector<size_t>> local(threads, std::vector<size_t>(nrow, 0));
+    std::vector<_h5_col_block> const blocks = _h5_column_blocks(p, cols);
+    prefetch_pipeline<_h5_csc_buf>(blocks.size(), H5_PREFETCH,
+        [&](size_t const & b, _h5_csc_buf & buf) {
+            size_t bstart = p[cols[blocks[b].first]];
+            size_t bend = p[cols[blocks[b].last - 1] + 1];
+            buf.i.resize(bend - bstart);
+            h5_read_1d(file, i_path, bstart, bend - bstart, buf.i.data(), threads);
+        },
+        [&](size_t const & b, _h5_csc_buf & buf) {
+            _h5_col_block const & blk = blocks[b];
+            long bstart = p[cols[blk.first]];
+            std::vector<int> const & ibuf = buf.i;
+
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+            for (size_t k = blk.first; k < blk.last; ++k) {
+                std::vector<size_t> & cnt = local[omp_get_thread_num()];
+                int r;
+                for (long e = p[cols[k]] - bstart; e < p[cols[k] + 1] - bstart; ++e) {
+                    r = ibuf[e];
+                    if ((r >= 0) && (static_cast<size_t>(r) < nrow)) ++cnt[r];
+                }
+            }
+        });
+
+#pragma omp parallel for num_threads(threads)
+    for (size_t r = 0; r < nrow; ++r) {
+        size_t c = 0;
+        for (int t = 0; t < threads; ++t) c += local[t][r];
+        counts[r] = c;
+    }
+}
+
+void h5_read_csc_filtered(hid_t const & file, std::string const & x_path, std::string const & i_path,
+    long const * p, std::vector<size_t> const & cols, std::vector<int> const & rowmap,
+    size_t const * offsets, double * x, int * i, int const & threads) {
+
+    std::vector<_h5_col_block> const blocks = _h5_column_blocks(p, cols);
+    // without a row filter, a block of adjacent columns is read straight into the output.
+    auto direct = [&](size_t const & b) {
+        return rowmap.empty() && (static_cast<size_t>(p[cols[blocks[b].last - 1] + 1] - p[cols[blocks[b].first]]) ==
+            offsets[blocks[b].last] - offsets[blocks[b].first]);
+    };
+    bool bad = false;
+    // the next block is read and decoded while the current one is filtered into the output.
+    prefetch_pipeline<_h5_csc_buf>(blocks.size(), H5_PREFETCH,
+        [&](size_t const & b, _h5_csc_buf & buf) {
+            size_t bstart = p[cols[blocks[b].first]];
+            size_t bend = p[cols[blocks[b].last - 1] + 1];
+            size_t o = offsets[blocks[b].first];
+            if (direct(b)) {
+                h5_read_1d(file, i_path, bstart, bend - bstart, i + o, threads);
+                h5_read_1d(file, x_path, bstart, bend - bstart, x + o, threads);
+                return;
+            }
+            buf.i.resize(bend - bstart);
+            buf.x.resize(bend - bstart);
+            h5_read_1d(file, i_path, bstart, bend - bstart, buf.i.data(), threads);
+            h5_read_1d(file, x_path, bstart, bend - bstart, buf.x.data(), threads);
+        },
+        [&](size_t const & b, _h5_csc_buf & buf) {
+            if (direct(b)) return;
+            _h5_col_block const & blk = blocks[b];
+            size_t bstart = p[cols[blk.first]];
+            std::vector<int> const & ibuf = buf.i;
+            std::vector<double> const & xbuf = buf.x;
+
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64) reduction(||:bad)
+            for (size_t k = blk.first; k < blk.last; ++k) {
+                size_t lo = p[cols[k]] - bstart, hi = p[cols[k] + 1] - bstart;
+                size_t o = offsets[k];
+                int r;
+                for (size_t e = lo; e < hi; ++e) {
+                    r = ibuf[e];
+                    if (!rowmap.empty()) {
+                        if ((r < 0) || (static_cast<size_t>(r) >= rowmap.size()) || (rowmap[r] < 0)) continue;
+                        r = rowmap[r];
+                    }
+                    if (o >= offsets[k + 1]) { bad = true; break; }
+                    x[o] = xbuf[e];
+                    i[o] = r;
+                    ++o;
+                }
+                bad |= (o != offsets[k + 1]);
+            }
+        });
+    if (bad) throw std::runtime_error("column counts changed while reading " + i_path);
+}
+
+
+// ----- write
+
+hid_t h5_create_file(std::string const & filename) {
+    H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+    hid_t file = H5Fcreate(filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    if (file < 0) throw std::runtime_error("unable to create HDF5 file " + filename);
+    return file;
+}
+
+hid_t h5_create_group(hid_t const & loc, std::string const & path) {
+    h5_id lcpl(H5Pcreate(H5P_LINK_CREATE), H5Pclose);
+    H5Pset_create_intermediate_group(lcpl, 1);
+    hid_t group = H5Gcreate2(loc, path.c_str(), lcpl, H5P_DEFAULT, H5P_DEFAULT);
+    if (group < 0) throw std::runtime_error("unable to create HDF5 group " + path);
+    return group;
+}
+
+// chunked, extendible 1D dataset creation properties with shuffle and deflate (as written by h5py for CellRanger).
+static hid_t _h5_chunked_dcpl(size_t const & chunk, int const & level) {
+    hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+    hsize_t cdims[1] = {chunk};
+    H5Pset_chunk(dcpl, 1, cdims);
+    if (level > 0) {
+        H5Pset_shuffle(dcpl);
+        H5Pset_deflate(dcpl, level);
+    }
+    return dcpl;
+}
+
+static hid_t _h5_create_1d(hid_t const & loc, std::string const & path, hid_t const & ftype, 
+    size_t const & count, size_t const & chunk, int const & level) {
+    hsize_t dims[1] = {count}, maxdims[1] = {H5S_UNLIMITED};
+    h5_id space(H5Screate_simple(1, dims, maxdims), H5Sclose);
+    h5_id dcpl(_h5_chunked_dcpl(chunk, level), H5Pclose);
+    hid_t dset = H5Dcreate2(loc, path.c_str(), ftype, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+    if (dset < 0) throw std::runtime_error("unable to create HDF5 dataset " + path);
+    return dset;
+}
+
+void h5_write_strings(hid_t const & loc, std::string const & path, std::vector<std::string> const & vals, int const & level) {
+    // fixed length, null padded (numpy "S"), as CellRanger writes them.
+    size_t size = 1;
+    for (auto const & v : vals) size = std::max(size, v.size());
+    h5_id ftype(H5Tcopy(H5T_C_S1), H5Tclose);
+    H5Tset_size(ftype, size);
+    H5Tset_strpad(ftype, H5T_STR_NULLPAD);
+
+    size_t chunk = std::max(static_cast<size_t>(1), std::min(vals.size(), (static_cast<size_t>(1) << 20) / size));
+    h5_id dset(_h5_create_1d(loc, path, ftype, vals.size(), chunk, level), H5Dclose);
+    if (vals.empty()) return;
+
+    std::vector<char> buf(vals.size() * size, 0);
+    for (size_t k = 0; k < vals.size(); ++k) memcpy(buf.data() + k * size, vals[k].data(), vals[k].size());
+    if (H5Dwrite(dset, ftype, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf.data()) < 0)
+        throw std::runtime_error("unable to write HDF5 dataset " + path);
+}
+
+template <typename ST> static hid_t _h5_file_type();
+template <> hid_t _h5_file_type<double>() { return H5T_IEEE_F64LE; }
+template <> hid_t _h5_file_type<int32_t>() { return H5T_STD_I32LE; }
+template <> hid_t _h5_file_type<int64_t>() { return H5T_STD_I64LE; }
+
+static void _h5_shuffle(unsigned char const * in, size_t const & bytes, size_t const & size, unsigned char * out) {
+    size_t n = bytes / size;
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t b = 0; b < size; ++b) out[b * n + k] = in[k * size + b];
+    }
+    memcpy(out + n * size, in + n * size, bytes - n * size);
+}
+
+template <typename IT, typename ST>
+extern void h5_write_1d(hid_t const & loc, std::string const & path, IT const * in, size_t const & count,
+    size_t const & chunk, int const & level, int const & threads) {
+
+    size_t csize = std::max(static_cast<size_t>(1), std::min(chunk, count));
+    h5_id dset(_h5_create_1d(loc, path, _h5_file_type<ST>(), count, csize, level), H5Dclose);
+    if (count == 0) return;
+
+    if (level <= 0) {
+        // no filters:  the library writes it as is, from the input if it is already ST,
+        // else converted one chunk at a time into a hyperslab.
+        if (std::is_same<IT, ST>::value) {
+            if (H5Dwrite(dset, _h5_mem_type<IT>(), H5S_ALL, H5S_ALL, H5P_DEFAULT, in) < 0)
+                throw std::runtime_error("unable to write HDF5 dataset " + path);
+            return;
+        }
+        h5_id mtype(H5Tcopy(_h5_file_type<ST>()), H5Tclose);
+        H5Tset_order(mtype, H5Tget_order(H5T_NATIVE_INT));
+        h5_id fspace(H5Dget_space(dset), H5Sclose);
+        std::vector<ST> buf(csize);
+        hsize_t st[1], cnt[1];
+        for (size_t cstart = 0; cstart < count; cstart += csize) {
+            cnt[0] = std::min(csize, count - cstart);
+            st[0] = cstart;
+#pragma omp parallel for num_threads(threads) schedule(static)
+            for (size_t k = 0; k < cnt[0]; ++k) buf[k] = static_cast<ST>(in[cstart + k]);
+            H5Sselect_hyperslab(fspace, H5S_SELECT_SET, st, NULL, cnt, NULL);
+            h5_id mspace(H5Screate_simple(1, cnt, NULL), H5Sclose);
+            if (H5Dwrite(dset, mtype, mspace, fspace, H5P_DEFAULT, buf.data()) < 0)
+                throw std::runtime_error("unable to write HDF5 dataset " + path);
+        }
+        return;
+    }
+
+    // chunks are converted, shuffled and deflated by the threads in batches, then written
+    // in order by the calling thread with direct chunk writes.  the last chunk is zero padded to full size.
+    size_t const nchunks = (count + csize - 1) / csize;
+    size_t const batch = 8 * threads;
+    size_t const cbytes = csize * sizeof(ST);
+    bool const swap = (H5Tget_order(H5T_NATIVE_INT) != H5T_ORDER_LE);
+    uLong const bound = compressBound(cbytes);
+    std::vector<std::vector<unsigned char>> packed(batch);
+    std::vector<uLongf> packed_size(batch);
+    int bad = 0;
+
+    for (size_t b0 = 0; b0 < nchunks; b0 += batch) {
+        size_t b1 = std::min(nchunks, b0 + batch);
+
+#pragma omp parallel num_threads(threads)
+{
+        std::vector<ST> vals(csize);
+        std::vector<unsigned char> shuffled(cbytes);
+        size_t cstart, n, k;
+#pragma omp for schedule(dynamic, 1)
+        for (size_t c = b0; c < b1; ++c) {
+            cstart = c * csize;
+            n = std::min(csize, count - cstart);
+            for (k = 0; k < n; ++k) vals[k] = static_cast<ST>(in[cstart + k]);
+            for (; k < csize; ++k) vals[k] = 0;
+            unsigned char * bytes = reinterpret_cast<unsigned char *>(vals.data());
+            if (swap) {
+                for (unsigned char * e = bytes; e < bytes + cbytes; e += sizeof(ST)) std::reverse(e, e + sizeof(ST));
+            }
+            _h5_shuffle(bytes, cbytes, sizeof(ST), shuffled.data());
+
+            std::vector<unsigned char> & out = packed[c - b0];
+            out.resize(bound);
+            packed_size[c - b0] = bound;
+            if (compress2(out.data(), &(packed_size[c - b0]), shuffled.data(), cbytes, level) != Z_OK) {
+#pragma omp atomic write
+                bad = 1;
+            }
+        }
+}
+        if (bad) throw std::runtime_error("unable to compress HDF5 dataset " + path);
+
+        hsize_t offset[1];
+        for (size_t c = b0; c < b1; ++c) {
+            offset[0] = c * csize;
+            if (H5Dwrite_chunk(dset, H5P_DEFAULT, 0, offset, packed_size[c - b0], packed[c - b0].data()) < 0)
+                throw std::runtime_error("unable to write HDF5 dataset " + path);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once 
+
+#include <stddef.h>
+
+/*
+ * variable feature selection (Seurat vst) for R dgCMatrix / dgCMatrix64, features (genes) in rows.
+ */
+
+// one pass over CSC.  per row mean and variance (n - 1 denominator), zeros included.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_mean_var(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double * means, double * vars,
+    int const & threads);
+
+// one pass over CSC.  per row sum(min(vmax, (x - mean) / sd)^2) / (n - 1), zeros included.
+// same as Seurat SparseRowVarStd:  zero entries are not clipped, rows with sd == 0 get 0.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_clipped_std_var(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * means, double const * sds, double const & vmax,
+    double * out,
+    int const & threads);
+
+// local regression of y on x, evaluated at each x.  tricube weights over the nearest ceil(span * n) points,
+// local polynomial of the given degree (0, 1, or 2).  equivalent to loess(surface = "direct", family = "gaussian").
+extern void loess_fit_direct(
+    double const * x, double const * y, size_t const & n,
+    double const & span, int const & degree,
+    double * fitted,
+    int const & threads);
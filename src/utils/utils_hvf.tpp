@@ -0,0 +1,235 @@
+#pragma once
+
+#include "utils_hvf.hpp"
+
+/*
+ * variable feature selection (Seurat vst) for R dgCMatrix / dgCMatrix64
+ *
+ */
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <omp.h>
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_mean_var(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double * means, double * vars,
+    int const & threads) {
+
+    // per thread row sums and sums of squares, so the CSC matrix is read once.
+    std::vector<std::vector<double>> sums(threads);
+    std::vector<std::vector<double>> sqsums(threads);
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    sums[tid].resize(rows, 0);
+    sqsums[tid].resize(rows, 0);
+    double * s = sums[tid].data();
+    double * sq = sqsums[tid].data();
+
+    size_t start = p[offset], end2 = p[end];
+    double val;
+    for (size_t e = start; e < end2; ++e) {
+        val = x[e];
+        s[i[e]] += val;
+        sq[i[e]] += val * val;
+    }
+
+#pragma omp barrier
+
+    // reduce, partitioned by row.
+    block = rows / threads;
+    rem = rows - threads * block;
+    offset = tid * block + (tid > rem ? rem : tid);
+    end = nid * block + (nid > rem ? rem : nid);
+
+    double sum, sqsum, mean, var;
+    for (size_t r = offset; r < end; ++r) {
+        sum = 0;
+        sqsum = 0;
+        for (int t = 0; t < threads; ++t) {
+            sum += sums[t][r];
+            sqsum += sqsums[t][r];
+        }
+        mean = sum / static_cast<double>(cols);
+        var = (sqsum - mean * sum) / static_cast<double>(cols - 1);
+        means[r] = mean;
+        vars[r] = (var > 0) ? var : 0.0;
+    }
+}
+
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_clipped_std_var(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * means, double const * sds, double const & vmax,
+    double * out,
+    int const & threads) {
+
+    // per thread sums of clipped squares and nonzero counts.
+    std::vector<std::vector<double>> sums(threads);
+    std::vector<std::vector<size_t>> counts(threads);
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    sums[tid].resize(rows, 0);
+    counts[tid].resize(rows, 0);
+    double * s = sums[tid].data();
+    size_t * c = counts[tid].data();
+
+    size_t start = p[offset], end2 = p[end];
+    double sd, z;
+    for (size_t e = start; e < end2; ++e) {
+        sd = sds[i[e]];
+        if (sd == 0) continue;
+        z = std::min(vmax, (x[e] - means[i[e]]) / sd);
+        s[i[e]] += z * z;
+        ++c[i[e]];
+    }
+
+#pragma omp barrier
+
+    // reduce, partitioned by row, and add the zero entries.
+    block = rows / threads;
+    rem = rows - threads * block;
+    offset = tid * block + (tid > rem ? rem : tid);
+    end = nid * block + (nid > rem ? rem : nid);
+
+    double sum, z0;
+    size_t nz;
+    for (size_t r = offset; r < end; ++r) {
+        if (sds[r] == 0) {
+            out[r] = 0;
+            continue;
+        }
+        sum = 0;
+        nz = 0;
+        for (int t = 0; t < threads; ++t) {
+            sum += sums[t][r];
+            nz += counts[t][r];
+        }
+        z0 = means[r] / sds[r];
+        sum += z0 * z0 * static_cast<double>(cols - nz);
+        out[r] = sum / static_cast<double>(cols - 1);
+    }
+}
+
+}
+
+
+// weighted least squares at one target.  neighbors are sorted x in [lo, lo + q), distances are scaled by h.
+// returns the fitted value, falling back to a lower degree when the local design is singular.
+static double _loess_local_fit(
+    double const * xs, double const * ys, size_t const & lo, size_t const & q,
+    double const & x0, double const & h, int degree) {
+
+    // moments of the centered, scaled predictor u = (x - x0) / h.
+    double m[5] = {0, 0, 0, 0, 0};
+    double b[3] = {0, 0, 0};
+    double u, u2, w, d;
+    for (size_t e = lo; e < lo + q; ++e) {
+        u = (h > 0) ? (xs[e] - x0) / h : 0.0;
+        d = fabs(u);
+        if (d >= 1.0) continue;
+        d = 1.0 - d * d * d;
+        w = d * d * d;
+        u2 = u * u;
+        m[0] += w;         m[1] += w * u;       m[2] += w * u2;
+        m[3] += w * u2 * u;  m[4] += w * u2 * u2;
+        b[0] += w * ys[e];  b[1] += w * u * ys[e];  b[2] += w * u2 * ys[e];
+    }
+    if (m[0] <= 0) return NAN;
+
+    // the intercept is the fitted value at x0.  solve by Cramer's rule, relative tolerance for singularity.
+    double const eps = 1e-10;
+    if (degree >= 2) {
+        double det = m[0] * (m[2] * m[4] - m[3] * m[3]) - m[1] * (m[1] * m[4] - m[3] * m[2]) + m[2] * (m[1] * m[3] - m[2] * m[2]);
+        if (fabs(det) > eps * m[0] * m[2] * m[4]) {
+            double det0 = b[0] * (m[2] * m[4] - m[3] * m[3]) - m[1] * (b[1] * m[4] - m[3] * b[2]) + m[2] * (b[1] * m[3] - m[2] * b[2]);
+            return det0 / det;
+        }
+    }
+    if (degree >= 1) {
+        double det = m[0] * m[2] - m[1] * m[1];
+        if (fabs(det) > eps * m[0] * m[2]) {
+            return (b[0] * m[2] - m[1] * b[1]) / det;
+        }
+    }
+    return b[0] / m[0];
+}
+
+
+extern void loess_fit_direct(
+    double const * x, double const * y, size_t const & n,
+    double const & span, int const & degree,
+    double * fitted,
+    int const & threads) {
+
+    if (n == 0) return;
+
+    // sort by x so the nearest neighbors of a point are a contiguous window.
+    std::vector<size_t> order(n);
+    for (size_t e = 0; e < n; ++e) order[e] = e;
+    std::stable_sort(order.begin(), order.end(), [x](size_t const & a, size_t const & b){ return x[a] < x[b]; });
+    std::vector<double> xs(n), ys(n);
+    for (size_t e = 0; e < n; ++e) {
+        xs[e] = x[order[e]];
+        ys[e] = y[order[e]];
+    }
+
+    size_t q = static_cast<size_t>(floor(static_cast<double>(n) * span));
+    if (q > n) q = n;
+    if (q < static_cast<size_t>(degree + 1)) q = std::min(n, static_cast<size_t>(degree + 1));
+    // for span > 1, R enlarges the bandwidth beyond the farthest point.
+    double const h_scale = (span > 1.0) ? span : 1.0;
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = n / threads;
+    int rem = n - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    // the window only moves right as the target moves right, so each thread slides it from its own start.
+    size_t lo = (offset > q / 2) ? offset - q / 2 : 0;
+    if (lo + q > n) lo = n - q;
+    double x0, h;
+    for (; offset < end; ++offset) {
+        x0 = xs[offset];
+        while ((lo + q < n) && (xs[lo + q] - x0 < x0 - xs[lo])) ++lo;
+        while ((lo > 0) && (x0 - xs[lo - 1] < xs[lo + q - 1] - x0)) --lo;
+
+        h = std::max(x0 - xs[lo], xs[lo + q - 1] - x0) * h_scale;
+        fitted[order[offset]] = _loess_local_fit(xs.data(), ys.data(), lo, q, x0, h, degree);
+    }
+}
+
+}
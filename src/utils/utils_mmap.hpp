@@ -0,0 +1,228 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+
+/*
+ * fastde native sparse matrix file, opened with mmap.
+ *
+ * layout (native byte order, checked on open):  a 128 byte header, then sections aligned to 64 bytes
+ *   x         double[nnz], or a compact value type (float32, uint16 or uint32 counts)
+ *   i         int32[nnz], or delta coded (see SPMAT_IDX_VARINT)
+ *   p         int64[ncol + 1]
+ *   tx, ti, tp   the transpose (CSR of the matrix), same types, tp has nrow + 1 entries (optional)
+ *   rownames  nrow '\0' terminated strings (optional)
+ *   colnames  ncol '\0' terminated strings (optional)
+ * the file is mapped private and read only by the kernels, so x, i and p are used without copying and
+ * opening costs the header check and a pass over the pointers (ncol + nrow entries).  the pass over every
+ * index, which reads the whole file, is opt-in (SPMAT_CHECK_ALL).
+ * when the transpose is stored, a kernel that needs the other orientation reads it from the file instead of
+ * transposing.  otherwise it is built on first use and kept with the mapping (see spmat_transposed).
+ * compact values halve or quarter the size of x, so of the file, the page cache and the block cache.  they are
+ * widened to double one block of features at a time, never for the whole matrix (see spmat_feature_blocks).
+ * coded indices are decoded the same way, per block, or per feature in the transposes.
+ */
+
+#define SPMAT_MAGIC "FASTDESP"
+#define SPMAT_VERSION 1
+#define SPMAT_BYTE_ORDER 0x01020304u
+#define SPMAT_ALIGN 64
+
+// value types of x and tx.  the type is kept in bits 16-23 of the header version, so files of doubles are
+// unchanged and older readers reject compact files.
+#define SPMAT_F64 0
+#define SPMAT_F32 1
+#define SPMAT_U16 2
+#define SPMAT_U32 3
+#define SPMAT_VALUE_SHIFT 16
+
+// coding of i and ti, in bits 24-31 of the header version.  varint:  an int64 skip table with the byte offset of
+// each feature (nfeatures + 1 entries), then per feature the first index and the gaps to the next, as LEB128
+// varints.  gaps within sorted single cell data mostly fit in one or two bytes instead of four.
+#define SPMAT_IDX_I32 0
+#define SPMAT_IDX_VARINT 1
+#define SPMAT_INDEX_SHIFT 24
+
+// what spmat_open checks beyond the header and the section bounds.
+#define SPMAT_CHECK_HEADER 0
+#define SPMAT_CHECK_POINTERS 1      // p and tp:  O(ncol + nrow), the default
+#define SPMAT_CHECK_ALL 2           // and every index, i and ti:  O(nnz)
+
+// bytes per value, 0 for an unknown type.
+extern size_t spmat_value_bytes(int const & value_type);
+
+struct spmat_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t nrow;
+    uint64_t ncol;
+    uint64_t nnz;
+    uint64_t x_offset;
+    uint64_t i_offset;
+    uint64_t p_offset;
+    uint64_t rownames_offset;
+    uint64_t rownames_bytes;
+    uint64_t colnames_offset;
+    uint64_t colnames_bytes;
+    uint64_t file_bytes;
+    uint64_t tx_offset;   // 0 if the transpose is not stored.  version 1 files wrote 0 here.
+    uint64_t ti_offset;
+    uint64_t tp_offset;
+};
+static_assert(sizeof(spmat_header) == 128, "spmat_header must be 128 bytes");
+
+class spmat_block_cache;
+
+// a mapped file.  the arrays point into the mapping and stay valid until the object is destroyed.
+// x and tx hold value_type elements;  use spmat_values to read them as doubles.
+// with coded indices, i (or ti) is NULL and iskip, icode (or tiskip, ticode) point to the skip table and the
+// codes;  use spmat_indices to read them as ints.
+struct spmat_mmap {
+    void * base;
+    size_t bytes;
+    spmat_header header;
+    int value_type;
+    int index_type;
+    void * x;
+    int * i;
+    long * p;
+    long * iskip;
+    unsigned char * icode;
+    // transpose, into the mapping if stored, else into the lazy_* vectors once built (with plain indices).
+    // NULL until available.
+    void * tx;
+    int * ti;
+    long * tp;
+    long * tiskip;
+    unsigned char * ticode;
+    std::vector<unsigned char> lazy_tx;
+    std::vector<int> lazy_ti;
+    std::vector<long> lazy_tp;
+    // SPMAT_CHECK_* level the file passed at open, here or in the session that published the handle.
+    int checked;
+    // out-of-core mode when cache_budget > 0:  kernels read feature blocks through caches[features_as_rows],
+    // up to prefetch blocks ahead of the one being computed on.
+    std::string filename;
+    size_t cache_budget;
+    size_t cache_block_bytes;
+    size_t prefetch;
+    std::shared_ptr<spmat_block_cache> caches[2];
+
+    spmat_mmap() : base(NULL), bytes(0), value_type(SPMAT_F64), index_type(SPMAT_IDX_I32), x(NULL), i(NULL), p(NULL),
+        iskip(NULL), icode(NULL), tx(NULL), ti(NULL), tp(NULL), tiskip(NULL), ticode(NULL), checked(SPMAT_CHECK_HEADER), cache_budget(0), cache_block_bytes(0), prefetch(0) {}
+    ~spmat_mmap();
+    spmat_mmap(spmat_mmap const & other) = delete;
+    spmat_mmap & operator=(spmat_mmap const & other) = delete;
+};
+
+// map a file written by spmat_write.  throws std::runtime_error if the file is missing, truncated,
+// not a fastde sparse matrix in this byte order, or, up to the check level (SPMAT_CHECK_*), its pointers or
+// indices are inconsistent.  the arrays are checked once, with threads, so that no kernel reads outside them.
+extern spmat_mmap * spmat_open(std::string const & filename, int const & check, int const & threads);
+
+// row (or column) names stored in the file.  empty if none were written.
+extern std::vector<std::string> spmat_names(spmat_mmap const & mat, bool const & rows);
+
+// make tx, ti, tp available:  no-op if the file stores the transpose or it was already built,
+// otherwise transpose once into memory owned by mat.
+extern void spmat_transposed(spmat_mmap & mat, int const & threads);
+
+// values [offset, offset + count) of x (or of tx if transposed, which must be available) as doubles.
+extern void spmat_values(spmat_mmap const & mat, bool const & transposed, size_t const & offset, size_t const & count,
+    double * out, int const & threads);
+
+// row indices of features [first, first + count) of the matrix (or of the transpose), p[first + count] - p[first]
+// entries, decoded if coded.
+extern void spmat_indices(spmat_mmap const & mat, bool const & transposed, size_t const & first, size_t const & count,
+    int * out, int const & threads);
+
+// row indices of elements [offset, offset + count), single threaded.  coded indices are decoded from the start
+// of each feature the range touches, so bulk reads should use spmat_indices.
+extern void spmat_indices_at(spmat_mmap const & mat, bool const & transposed, size_t const & offset, size_t const & count,
+    int * out);
+
+// the transpose with values as doubles:  tx and ti have nnz entries, tp has nrow + 1.  copied if available,
+// otherwise transposed from the mapped arrays without keeping it.
+extern void spmat_transpose_to(spmat_mmap const & mat, double * tx, int * ti, long * tp, int const & threads);
+
+// write a CSC matrix.  p has ncol + 1 entries.  names may be empty.  the data sections are copied by the threads
+// into a mapping of a temporary file, which is renamed to filename when complete.  if transposed, the transpose is
+// computed into the file as well.  x is stored as value_type;  throws std::invalid_argument if a value does not
+// fit (uint16 / uint32 take non-negative integers only).  float32 rounds.  i (and ti) are stored as index_type;
+// coding requires increasing indices within each column, and with the transpose it is computed in memory first.
+// throws std::runtime_error "not enough space ..." if the file system cannot hold the file.
+template <typename PT>
+extern void spmat_write(std::string const & filename,
+    double const * x, int const * i, PT const * p, size_t const & nrow, size_t const & ncol,
+    std::vector<std::string> const & rownames, std::vector<std::string> const & colnames,
+    int const & value_type, int const & index_type, bool const & transposed, int const & threads);
+
+
+// ----- out-of-core access by feature blocks
+
+// consecutive features [first, first + count) of a stored matrix, as columns.  p is local, p[0] == 0.
+// x holds the values as stored (the file's value type).  coded indices are kept coded in ci, with a local
+// skip table (skip[0] == 0), and i is empty.
+struct spmat_block {
+    size_t first;
+    size_t count;
+    std::vector<unsigned char> x;
+    std::vector<int> i;
+    std::vector<unsigned char> ci;
+    std::vector<long> skip;
+    std::vector<long> p;
+
+    size_t bytes() const { return x.size() + i.size() * sizeof(int) + ci.size() + (skip.size() + p.size()) * sizeof(long); }
+};
+
+// reads feature blocks of a spmat file with pread and keeps the least recently used ones out once the
+// total exceeds the budget (blocks still in use are kept by their users).  an evicted block that nobody uses
+// is recycled for the next read.  features are the columns of x, i, p, or the rows when features_as_rows,
+// read from the stored transpose.  blocks span about block_bytes of x and i as stored.  not thread safe.
+class spmat_block_cache {
+  public:
+    spmat_block_cache(spmat_mmap const & mat, bool const & features_as_rows, size_t const & budget, size_t const & block_bytes);
+    ~spmat_block_cache();
+    spmat_block_cache(spmat_block_cache const & other) = delete;
+    spmat_block_cache & operator=(spmat_block_cache const & other) = delete;
+
+    size_t nblocks() const { return bounds.size() - 1; }
+    std::shared_ptr<spmat_block const> get(size_t const & b, int const & threads);
+
+    size_t hits;
+    size_t misses;
+
+  protected:
+    int fd;
+    size_t value_bytes;
+    uint64_t x_offset;
+    uint64_t i_offset;     // of the codes, if coded
+    long const * p;        // into the mapping, nfeatures + 1 entries
+    long const * skip;     // into the mapping if coded, else NULL
+    std::vector<size_t> bounds;   // block b is features [bounds[b], bounds[b+1])
+    size_t budget;
+    size_t used;
+    std::list<size_t> lru;        // most recent first
+    std::unordered_map<size_t, std::pair<std::shared_ptr<spmat_block>, std::list<size_t>::iterator>> blocks;
+};
+
+// switch the matrix to out-of-core mode with the given memory budget (0 turns it off), dropping cached blocks.
+// prefetch blocks are read ahead by a background thread while the kernels run (0 reads and computes in turn).
+extern void spmat_set_cache(spmat_mmap & mat, size_t const & budget, size_t const & block_bytes, size_t const & prefetch);
+
+// call f(x, i, p, first, count) for consecutive blocks of features, in order.  x, i, p hold the features
+// [first, first + count) as columns, samples as rows, and p[0] == 0.  in memory (no budget) this is one call
+// on the mapped arrays, or the transpose for features_as_rows;  out of core, one call per cached block, with
+// the next blocks read in the background, and features_as_rows requires the transpose to be stored in the file.
+// compact values are widened to doubles and coded indices decoded per block, so in memory they are also
+// processed in blocks.
+// x must not be modified.  f runs on the calling thread.
+typedef std::function<void(double * x, int * i, long * p, size_t const & first, size_t const & count)> spmat_block_fn;
+extern void spmat_feature_blocks(spmat_mmap & mat, bool const & features_as_rows, int const & threads, spmat_block_fn const & f);
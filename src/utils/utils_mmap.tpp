@@ -0,0 +1,917 @@
+#pragma once
+
+#include "utils_mmap.hpp"
+
+/*
+ * fastde native sparse matrix file
+ *
+ */
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <cmath>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <omp.h>
+
+#include "utils_sparsemat.hpp"
+#include "utils_pipeline.hpp"
+
+
+spmat_mmap::~spmat_mmap() {
+    if (base != NULL) munmap(base, bytes);
+}
+
+static inline uint64_t _spmat_align(uint64_t const & offset) {
+    return (offset + SPMAT_ALIGN - 1) / SPMAT_ALIGN * SPMAT_ALIGN;
+}
+
+// section [offset, offset + bytes) is inside the file.
+static inline bool _spmat_inside(uint64_t const & offset, uint64_t const & bytes, uint64_t const & file_bytes) {
+    return (offset <= file_bytes) && (bytes <= file_bytes - offset);
+}
+
+size_t spmat_value_bytes(int const & value_type) {
+    switch (value_type) {
+        case SPMAT_F64: return sizeof(double);
+        case SPMAT_F32: return sizeof(float);
+        case SPMAT_U16: return sizeof(uint16_t);
+        case SPMAT_U32: return sizeof(uint32_t);
+        default: return 0;
+    }
+}
+
+// ----- value types
+
+// single threaded without a parallel region, for short element-wise reads.
+template <typename VT>
+static void _spmat_widen_t(VT const * in, size_t const & count, double * out, int const & threads) {
+#pragma omp parallel for num_threads(threads) schedule(static) if(threads > 1)
+    for (size_t k = 0; k < count; ++k) out[k] = static_cast<double>(in[k]);
+}
+
+// count values of value_type at in, as doubles.
+static void _spmat_widen(void const * in, int const & value_type, size_t const & count, double * out, int const & threads) {
+    switch (value_type) {
+        case SPMAT_F32: _spmat_widen_t(static_cast<float const *>(in), count, out, threads); break;
+        case SPMAT_U16: _spmat_widen_t(static_cast<uint16_t const *>(in), count, out, threads); break;
+        case SPMAT_U32: _spmat_widen_t(static_cast<uint32_t const *>(in), count, out, threads); break;
+        default: _spmat_widen_t(static_cast<double const *>(in), count, out, threads); break;
+    }
+}
+
+// false if an integer type is asked to hold a negative, fractional or too large value.
+template <typename VT>
+static bool _spmat_narrow_t(double const * in, size_t const & count, VT * out, int const & threads) {
+    bool ok = true;
+    bool const is_int = std::numeric_limits<VT>::is_integer;
+    double const vmax = static_cast<double>(std::numeric_limits<VT>::max());
+#pragma omp parallel for num_threads(threads) schedule(static) reduction(&&:ok)
+    for (size_t k = 0; k < count; ++k) {
+        if (is_int && !((in[k] >= 0) && (in[k] <= vmax) && (in[k] == std::floor(in[k])))) {
+            ok = false;
+            out[k] = 0;
+        } else out[k] = static_cast<VT>(in[k]);
+    }
+    return ok;
+}
+
+static bool _spmat_narrow(double const * in, size_t const & count, int const & value_type, void * out, int const & threads) {
+    switch (value_type) {
+        case SPMAT_F32: return _spmat_narrow_t(in, count, static_cast<float *>(out), threads);
+        case SPMAT_U16: return _spmat_narrow_t(in, count, static_cast<uint16_t *>(out), threads);
+        case SPMAT_U32: return _spmat_narrow_t(in, count, static_cast<uint32_t *>(out), threads);
+        default: return _spmat_narrow_t(in, count, static_cast<double *>(out), threads);
+    }
+}
+
+// ----- index coding
+
+static inline size_t _spmat_varint_bytes(uint32_t v) {
+    size_t n = 1;
+    for (; v >= 0x80; v >>= 7) ++n;
+    return n;
+}
+
+static inline unsigned char * _spmat_put_varint(uint32_t v, unsigned char * out) {
+    for (; v >= 0x80; v >>= 7) *(out++) = static_cast<unsigned char>(v | 0x80);
+    *(out++) = static_cast<unsigned char>(v);
+    return out;
+}
+
+static inline unsigned char const * _spmat_get_varint(unsigned char const * in, uint32_t & v) {
+    v = *(in++);
+    if (v & 0x80) {
+        // multi byte gap
+        uint32_t b;
+        int shift = 7;
+        v &= 0x7f;
+        do {
+            b = *(in++);
+            v |= (b & 0x7f) << shift;
+            shift += 7;
+        } while (b & 0x80);
+    }
+    return in;
+}
+
+// count indices of one feature, from its codes.
+static inline void _spmat_decode(unsigned char const * in, size_t const & count, int * out) {
+    uint32_t idx = 0;
+    uint32_t v;
+    for (size_t k = 0; k < count; ++k) {
+        in = _spmat_get_varint(in, v);
+        idx += v;
+        out[k] = static_cast<int>(idx);
+    }
+}
+
+// skip table for i:  skip[f] is the byte offset of feature f, skip[n] the total.  false if the indices of a
+// feature are negative or not increasing.
+static bool _spmat_code_skip(int const * i, long const * p, size_t const & n, long * skip, int const & threads) {
+    bool ok = true;
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64) reduction(&&:ok)
+    for (size_t f = 0; f < n; ++f) {
+        long bytes = 0;
+        int prev = 0;
+        for (long e = p[f]; e < p[f + 1]; ++e) {
+            if ((i[e] < prev) || ((e > p[f]) && (i[e] == prev))) ok = false;
+            bytes += _spmat_varint_bytes(static_cast<uint32_t>(i[e] - prev));
+            prev = i[e];
+        }
+        skip[f + 1] = bytes;
+    }
+    skip[0] = 0;
+    for (size_t f = 0; f < n; ++f) skip[f + 1] += skip[f];
+    return ok;
+}
+
+static void _spmat_encode(int const * i, long const * p, size_t const & n, long const * skip, unsigned char * out, int const & threads) {
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+    for (size_t f = 0; f < n; ++f) {
+        unsigned char * o = out + skip[f];
+        int prev = 0;
+        for (long e = p[f]; e < p[f + 1]; ++e) {
+            o = _spmat_put_varint(static_cast<uint32_t>(i[e] - prev), o);
+            prev = i[e];
+        }
+    }
+}
+
+// indices of features [first, first + count) into out, which starts at feature first.
+static void _spmat_decode_features(long const * skip, unsigned char const * code, long const * p,
+    size_t const & first, size_t const & count, int * out, int const & threads) {
+    long const start = p[first];
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+    for (size_t f = first; f < first + count; ++f)
+        _spmat_decode(code + skip[f], p[f + 1] - p[f], out + (p[f] - start));
+}
+
+// transpose by counting:  each thread takes a range of columns, counts its entries per row, then places them at
+// its own offsets within each row, so the column indices come out increasing within each row.  the indices are
+// plain (i) or coded (i NULL, skip and code), decoded one column at a time.  uses threads * nrow longs.
+template <typename VT>
+static void _spmat_transpose_count(VT const * x, int const * i, long const * skip, unsigned char const * code, long const * p,
+    size_t const & nrow, size_t const & ncol, VT * tx, int * ti, long * tp, int const & threads) {
+
+    std::vector<long> pos(static_cast<size_t>(threads) * nrow, 0);
+
+#pragma omp parallel num_threads(threads)
+{
+    int tid = omp_get_thread_num();
+    size_t block = ncol / threads;
+    size_t rem = ncol - threads * block;
+    size_t offset = tid * block + (static_cast<size_t>(tid) > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (static_cast<size_t>(nid) > rem ? rem : nid);
+
+    long * cnt = pos.data() + tid * nrow;
+    std::vector<int> buf;
+    int const * rows;
+    long n;
+    for (size_t c = offset; c < end; ++c) {
+        n = p[c + 1] - p[c];
+        if (i != NULL) rows = i + p[c];
+        else {
+            buf.resize(n);
+            _spmat_decode(code + skip[c], n, buf.data());
+            rows = buf.data();
+        }
+        for (long k = 0; k < n; ++k) ++cnt[rows[k]];
+    }
+#pragma omp barrier
+#pragma omp single
+    {
+        // row offsets, and each thread's start within each row.
+        long total = 0, t;
+        for (size_t r = 0; r < nrow; ++r) {
+            tp[r] = total;
+            for (int h = 0; h < threads; ++h) {
+                t = pos[h * nrow + r];
+                pos[h * nrow + r] = total;
+                total += t;
+            }
+        }
+        tp[nrow] = total;
+    }
+    long e;
+    for (size_t c = offset; c < end; ++c) {
+        n = p[c + 1] - p[c];
+        if (i != NULL) rows = i + p[c];
+        else {
+            buf.resize(n);
+            _spmat_decode(code + skip[c], n, buf.data());
+            rows = buf.data();
+        }
+        for (long k = 0; k < n; ++k) {
+            e = cnt[rows[k]]++;
+            tx[e] = x[p[c] + k];
+            ti[e] = static_cast<int>(c);
+        }
+    }
+}
+}
+
+template <typename VT>
+static void _spmat_transpose_t(void const * x, int const * i, long const * skip, unsigned char const * code, long const * p,
+    size_t const & nnz, int const & nrow, int const & ncol, void * tx, int * ti, long * tp, int const & threads, bool const & ordered) {
+    if ((i != NULL) && !ordered)
+        _sp_transpose_par(static_cast<VT const *>(x), i, p, nnz, nrow, ncol, static_cast<VT *>(tx), ti, tp, threads);
+    else
+        _spmat_transpose_count(static_cast<VT const *>(x), i, skip, code, p, nrow, ncol, static_cast<VT *>(tx), ti, tp, threads);
+}
+
+// transpose keeping the value type.  indices plain (i), or coded (i NULL).  ordered:  the column indices must be
+// increasing within each row, e.g. to code them.
+static void _spmat_transpose(int const & value_type, void const * x, int const * i, long const * skip, unsigned char const * code,
+    long const * p, size_t const & nnz, int const & nrow, int const & ncol, void * tx, int * ti, long * tp, int const & threads,
+    bool const & ordered = false) {
+    switch (value_type) {
+        case SPMAT_F32: _spmat_transpose_t<float>(x, i, skip, code, p, nnz, nrow, ncol, tx, ti, tp, threads, ordered); break;
+        case SPMAT_U16: _spmat_transpose_t<uint16_t>(x, i, skip, code, p, nnz, nrow, ncol, tx, ti, tp, threads, ordered); break;
+        case SPMAT_U32: _spmat_transpose_t<uint32_t>(x, i, skip, code, p, nnz, nrow, ncol, tx, ti, tp, threads, ordered); break;
+        default: _spmat_transpose_t<double>(x, i, skip, code, p, nnz, nrow, ncol, tx, ti, tp, threads, ordered); break;
+    }
+}
+
+// the index section at offset is inside the file:  nnz ints, or a skip table and the codes it spans.
+static bool _spmat_index_inside(unsigned char const * b, int const & index_type, uint64_t const & offset,
+    uint64_t const & nfeatures, uint64_t const & nnz, uint64_t const & file_bytes) {
+    if (index_type == SPMAT_IDX_I32) return (nnz <= file_bytes / sizeof(int)) && _spmat_inside(offset, nnz * sizeof(int), file_bytes);
+    uint64_t const table = (nfeatures + 1) * sizeof(long);
+    if (!_spmat_inside(offset, table, file_bytes)) return false;
+    long const * skip = reinterpret_cast<long const *>(b + offset);
+    // every index takes at least one byte.
+    return (skip[0] == 0) && (skip[nfeatures] >= 0) && (static_cast<uint64_t>(skip[nfeatures]) >= nnz) &&
+        _spmat_inside(offset + table, skip[nfeatures], file_bytes);
+}
+
+// pointers of nfeatures features start at 0, do not decrease and end at nnz.
+static bool _spmat_check_pointers(long const * p, size_t const & nfeatures, uint64_t const & nnz, int const & threads) {
+    if ((p[0] != 0) || (static_cast<uint64_t>(p[nfeatures]) != nnz)) return false;
+    bool ok = true;
+#pragma omp parallel for num_threads(threads) schedule(static) reduction(&&:ok)
+    for (size_t f = 0; f < nfeatures; ++f) {
+        if (p[f + 1] < p[f]) ok = false;
+    }
+    return ok;
+}
+
+// plain indices are in [0, n).
+static bool _spmat_check_indices(int const * i, uint64_t const & nnz, size_t const & n, int const & threads) {
+    bool ok = true;
+#pragma omp parallel for num_threads(threads) schedule(static) reduction(&&:ok)
+    for (uint64_t e = 0; e < nnz; ++e) {
+        if ((i[e] < 0) || (static_cast<size_t>(i[e]) >= n)) ok = false;
+    }
+    return ok;
+}
+
+// coded indices:  the skip table does not decrease, and the codes of each feature decode within its own bytes
+// to its count of increasing indices.  0 if so and all are in [0, n), 1 if the codes are inconsistent, 2 if an
+// index is out of range.
+static int _spmat_check_codes(long const * skip, unsigned char const * code, long const * p, size_t const & nfeatures,
+    size_t const & n, int const & threads) {
+    int bad = 0;
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64) reduction(max:bad)
+    for (size_t f = 0; f < nfeatures; ++f) {
+        if (skip[f + 1] < skip[f]) {
+            bad = std::max(bad, 1);
+            continue;
+        }
+        unsigned char const * in = code + skip[f];
+        unsigned char const * const end = code + skip[f + 1];
+        uint64_t idx = 0;
+        for (long e = p[f]; e < p[f + 1]; ++e) {
+            // at most 5 bytes for 32 bits.
+            uint64_t v = 0;
+            int shift = 0;
+            unsigned char c = 0x80;
+            while ((c & 0x80) && (in < end) && (shift < 35)) {
+                c = *(in++);
+                v |= static_cast<uint64_t>(c & 0x7f) << shift;
+                shift += 7;
+            }
+            if ((c & 0x80) || ((e > p[f]) && (v == 0))) {
+                bad = std::max(bad, 1);
+                break;
+            }
+            idx += v;
+            if (idx >= n) {
+                bad = std::max(bad, 2);
+                break;
+            }
+        }
+        if ((bad == 0) && (in != end)) bad = 1;
+    }
+    return bad;
+}
+
+spmat_mmap * spmat_open(std::string const & filename, int const & check, int const & threads) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("unable to open " + filename);
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (static_cast<size_t>(st.st_size) < sizeof(spmat_header))) {
+        close(fd);
+        throw std::runtime_error(filename + " is not a fastde sparse matrix file");
+    }
+
+    // private, so that a kernel that writes to its input can never modify the file.  pages are shared until written.
+    void * base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) throw std::runtime_error("unable to map " + filename);
+
+    spmat_mmap * mat = new spmat_mmap();
+    mat->base = base;
+    mat->bytes = st.st_size;
+    mat->filename = filename;
+    memcpy(&(mat->header), base, sizeof(spmat_header));
+    spmat_header const & h = mat->header;
+
+    mat->value_type = (h.version >> SPMAT_VALUE_SHIFT) & 0xff;
+    mat->index_type = (h.version >> SPMAT_INDEX_SHIFT) & 0xff;
+    size_t const vb = spmat_value_bytes(mat->value_type);
+    int const it = mat->index_type;
+    unsigned char * b = static_cast<unsigned char *>(base);
+
+    std::string err;
+    if (memcmp(h.magic, SPMAT_MAGIC, 8) != 0) err = " is not a fastde sparse matrix file";
+    else if (h.byte_order != SPMAT_BYTE_ORDER) err = " was written with a different byte order";
+    else if (((h.version & 0xffff) != SPMAT_VERSION) || (it > SPMAT_IDX_VARINT) || (vb == 0)) err = " has an unsupported version";
+    // dimensions are used as int, and bound the section sizes below so that they cannot overflow.
+    else if ((h.nrow > static_cast<uint64_t>(std::numeric_limits<int>::max())) ||
+        (h.ncol > static_cast<uint64_t>(std::numeric_limits<int>::max()))) err = " has dimensions beyond the integer range";
+    else if ((h.file_bytes != mat->bytes) || (h.nnz > h.file_bytes / vb) ||
+        !_spmat_inside(h.x_offset, h.nnz * vb, h.file_bytes) ||
+        !_spmat_index_inside(b, it, h.i_offset, h.ncol, h.nnz, h.file_bytes) ||
+        !_spmat_inside(h.p_offset, (h.ncol + 1) * sizeof(long), h.file_bytes) ||
+        !_spmat_inside(h.rownames_offset, h.rownames_bytes, h.file_bytes) ||
+        !_spmat_inside(h.colnames_offset, h.colnames_bytes, h.file_bytes) ||
+        (h.x_offset % SPMAT_ALIGN) || (h.i_offset % SPMAT_ALIGN) || (h.p_offset % SPMAT_ALIGN)) err = " is truncated or corrupt";
+    else if ((h.tp_offset != 0) && (
+        !_spmat_inside(h.tx_offset, h.nnz * vb, h.file_bytes) ||
+        !_spmat_index_inside(b, it, h.ti_offset, h.nrow, h.nnz, h.file_bytes) ||
+        !_spmat_inside(h.tp_offset, (h.nrow + 1) * sizeof(long), h.file_bytes) ||
+        (h.tx_offset % SPMAT_ALIGN) || (h.ti_offset % SPMAT_ALIGN) || (h.tp_offset % SPMAT_ALIGN))) err = " is truncated or corrupt";
+    if (err.empty()) {
+        mat->x = b + h.x_offset;
+        if (it == SPMAT_IDX_I32) mat->i = reinterpret_cast<int *>(b + h.i_offset);
+        else {
+            mat->iskip = reinterpret_cast<long *>(b + h.i_offset);
+            mat->icode = b + h.i_offset + (h.ncol + 1) * sizeof(long);
+        }
+        mat->p = reinterpret_cast<long *>(b + h.p_offset);
+        if (h.tp_offset != 0) {
+            mat->tx = b + h.tx_offset;
+            if (it == SPMAT_IDX_I32) mat->ti = reinterpret_cast<int *>(b + h.ti_offset);
+            else {
+                mat->tiskip = reinterpret_cast<long *>(b + h.ti_offset);
+                mat->ticode = b + h.ti_offset + (h.nrow + 1) * sizeof(long);
+            }
+            mat->tp = reinterpret_cast<long *>(b + h.tp_offset);
+        }
+        // the arrays once, so that no kernel reads outside them.  the indices only on request.
+        int ci = 0, cti = 0;
+        if (check < SPMAT_CHECK_POINTERS) {}
+        else if (!_spmat_check_pointers(mat->p, h.ncol, h.nnz, threads)) err = " has inconsistent column pointers";
+        else if ((mat->tp != NULL) && !_spmat_check_pointers(mat->tp, h.nrow, h.nnz, threads)) err = " has inconsistent row pointers";
+        else if (check < SPMAT_CHECK_ALL) {}
+        else if ((mat->i != NULL) && !_spmat_check_indices(mat->i, h.nnz, h.nrow, threads)) err = " has a row index out of range";
+        else if ((mat->ti != NULL) && !_spmat_check_indices(mat->ti, h.nnz, h.ncol, threads)) err = " has a column index out of range";
+        else if ((mat->iskip != NULL) && ((ci = _spmat_check_codes(mat->iskip, mat->icode, mat->p, h.ncol, h.nrow, threads)) != 0))
+            err = (ci == 1) ? " has inconsistent coded row indices" : " has a row index out of range";
+        else if ((mat->tiskip != NULL) && ((cti = _spmat_check_codes(mat->tiskip, mat->ticode, mat->tp, h.nrow, h.ncol, threads)) != 0))
+            err = (cti == 1) ? " has inconsistent coded column indices" : " has a column index out of range";
+    }
+    if (!err.empty()) {
+        delete mat;
+        throw std::runtime_error(filename + err);
+    }
+    mat->checked = check;
+    return mat;
+}
+
+void spmat_transposed(spmat_mmap & mat, int const & threads) {
+    if (mat.tp != NULL) return;
+
+    size_t const nnz = mat.header.nnz;
+    mat.lazy_tx.resize(nnz * spmat_value_bytes(mat.value_type));
+    mat.lazy_ti.resize(nnz);
+    mat.lazy_tp.resize(mat.header.nrow + 1);
+    _spmat_transpose(mat.value_type, mat.x, mat.i, mat.iskip, mat.icode, mat.p,
+        nnz, static_cast<int>(mat.header.nrow), static_cast<int>(mat.header.ncol),
+        mat.lazy_tx.data(), mat.lazy_ti.data(), mat.lazy_tp.data(), threads);
+    mat.tx = mat.lazy_tx.data();
+    mat.ti = mat.lazy_ti.data();
+    mat.tp = mat.lazy_tp.data();
+}
+
+void spmat_values(spmat_mmap const & mat, bool const & transposed, size_t const & offset, size_t const & count,
+    double * out, int const & threads) {
+    unsigned char const * x = static_cast<unsigned char const *>(transposed ? mat.tx : mat.x);
+    if (x == NULL) throw std::runtime_error("the transpose of " + mat.filename + " is not available");
+    _spmat_widen(x + offset * spmat_value_bytes(mat.value_type), mat.value_type, count, out, threads);
+}
+
+void spmat_indices(spmat_mmap const & mat, bool const & transposed, size_t const & first, size_t const & count,
+    int * out, int const & threads) {
+    long const * p = transposed ? mat.tp : mat.p;
+    int const * i = transposed ? mat.ti : mat.i;
+    if (p == NULL) throw std::runtime_error("the transpose of " + mat.filename + " is not available");
+    if (i == NULL) {
+        _spmat_decode_features(transposed ? mat.tiskip : mat.iskip, transposed ? mat.ticode : mat.icode, p, first, count, out, threads);
+        return;
+    }
+    long const start = p[first];
+    size_t const n = p[first + count] - start;
+#pragma omp parallel num_threads(threads)
+{
+    int tid = omp_get_thread_num();
+    size_t block = n / threads;
+    size_t rem = n - threads * block;
+    size_t offset = tid * block + (static_cast<size_t>(tid) > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (static_cast<size_t>(nid) > rem ? rem : nid);
+
+    memcpy(out + offset, i + start + offset, (end - offset) * sizeof(int));
+}
+}
+
+void spmat_indices_at(spmat_mmap const & mat, bool const & transposed, size_t const & offset, size_t const & count, int * out) {
+    long const * p = transposed ? mat.tp : mat.p;
+    int const * i = transposed ? mat.ti : mat.i;
+    if (p == NULL) throw std::runtime_error("the transpose of " + mat.filename + " is not available");
+    if (i != NULL) {
+        memcpy(out, i + offset, count * sizeof(int));
+        return;
+    }
+    if (count == 0) return;
+
+    // from the feature holding offset, decoding each feature from its start.
+    long const * skip = transposed ? mat.tiskip : mat.iskip;
+    unsigned char const * code = transposed ? mat.ticode : mat.icode;
+    size_t nfeatures = transposed ? mat.header.nrow : mat.header.ncol;
+    size_t f = std::upper_bound(p, p + nfeatures + 1, static_cast<long>(offset)) - p - 1;
+    long e = offset;
+    long const end = offset + count;
+    unsigned char const * in;
+    uint32_t idx, v;
+    for (; e < end; ++f) {
+        in = code + skip[f];
+        idx = 0;
+        for (long k = p[f]; k < e; ++k) {
+            in = _spmat_get_varint(in, v);
+            idx += v;
+        }
+        for (; (e < p[f + 1]) && (e < end); ++e) {
+            in = _spmat_get_varint(in, v);
+            idx += v;
+            out[e - offset] = static_cast<int>(idx);
+        }
+    }
+}
+
+void spmat_transpose_to(spmat_mmap const & mat, double * tx, int * ti, long * tp, int const & threads) {
+    size_t const nnz = mat.header.nnz;
+    int const nrow = mat.header.nrow;
+    int const ncol = mat.header.ncol;
+    if (mat.tp != NULL) {
+        spmat_values(mat, true, 0, nnz, tx, threads);
+        spmat_indices(mat, true, 0, nrow, ti, threads);
+        std::copy(mat.tp, mat.tp + nrow + 1, tp);
+    } else if (mat.value_type == SPMAT_F64) {
+        _spmat_transpose(mat.value_type, mat.x, mat.i, mat.iskip, mat.icode, mat.p, nnz, nrow, ncol, tx, ti, tp, threads);
+    } else {
+        // permute the compact values, then widen.
+        std::vector<unsigned char> ctx(nnz * spmat_value_bytes(mat.value_type));
+        _spmat_transpose(mat.value_type, mat.x, mat.i, mat.iskip, mat.icode, mat.p, nnz, nrow, ncol, ctx.data(), ti, tp, threads);
+        _spmat_widen(ctx.data(), mat.value_type, nnz, tx, threads);
+    }
+}
+
+std::vector<std::string> spmat_names(spmat_mmap const & mat, bool const & rows) {
+    uint64_t offset = rows ? mat.header.rownames_offset : mat.header.colnames_offset;
+    uint64_t bytes = rows ? mat.header.rownames_bytes : mat.header.colnames_bytes;
+    size_t n = rows ? mat.header.nrow : mat.header.ncol;
+    std::vector<std::string> names;
+    if (bytes == 0) return names;
+
+    names.reserve(n);
+    char const * s = static_cast<char const *>(mat.base) + offset;
+    char const * end = s + bytes;
+    char const * z;
+    while ((s < end) && (names.size() < n)) {
+        z = static_cast<char const *>(memchr(s, 0, end - s));
+        if (z == NULL) z = end;
+        names.emplace_back(s, z - s);
+        s = z + 1;
+    }
+    if (names.size() != n) throw std::runtime_error("fastde sparse matrix file has a corrupt name section");
+    return names;
+}
+
+static uint64_t _spmat_names_bytes(std::vector<std::string> const & names) {
+    uint64_t bytes = 0;
+    for (auto const & n : names) bytes += n.size() + 1;
+    return bytes;
+}
+
+static void _spmat_names_copy(std::vector<std::string> const & names, char * out) {
+    for (auto const & n : names) {
+        memcpy(out, n.data(), n.size());
+        out += n.size();
+        *out = 0;
+        ++out;
+    }
+}
+
+template <typename PT>
+extern void spmat_write(std::string const & filename,
+    double const * x, int const * i, PT const * p, size_t const & nrow, size_t const & ncol,
+    std::vector<std::string> const & rownames, std::vector<std::string> const & colnames,
+    int const & value_type, int const & index_type, bool const & transposed, int const & threads) {
+
+    if ((!rownames.empty() && rownames.size() != nrow) || (!colnames.empty() && colnames.size() != ncol))
+        throw std::runtime_error("number of names does not match the matrix dimensions");
+    size_t const vb = spmat_value_bytes(value_type);
+    if (vb == 0) throw std::invalid_argument("unknown value type for a fastde sparse matrix file");
+    if ((index_type != SPMAT_IDX_I32) && (index_type != SPMAT_IDX_VARINT))
+        throw std::invalid_argument("unknown index coding for a fastde sparse matrix file");
+    bool const coded = (index_type == SPMAT_IDX_VARINT);
+    std::string const narrow_err("values must be non-negative integers within range for an integer value type");
+
+    size_t const nnz = static_cast<size_t>(p[ncol]);
+
+    // the coded sizes decide the layout, so with coded indices the transpose is computed before the file.
+    std::vector<long> lp, iskip, tiskip, ttp;
+    std::vector<int> tti;
+    std::vector<unsigned char> ttx;
+    if (coded) {
+        lp.assign(p, p + ncol + 1);
+        iskip.resize(ncol + 1);
+        if (!_spmat_code_skip(i, lp.data(), ncol, iskip.data(), threads))
+            throw std::invalid_argument("row indices must be increasing within each column to be coded");
+        if (transposed) {
+            std::vector<unsigned char> cx(nnz * vb);
+            if (!_spmat_narrow(x, nnz, value_type, cx.data(), threads)) throw std::invalid_argument(narrow_err);
+            ttx.resize(nnz * vb);
+            tti.resize(nnz);
+            ttp.resize(nrow + 1);
+            _spmat_transpose(value_type, cx.data(), i, NULL, NULL, lp.data(), nnz, static_cast<int>(nrow), static_cast<int>(ncol),
+                ttx.data(), tti.data(), ttp.data(), threads, true);
+            tiskip.resize(nrow + 1);
+            _spmat_code_skip(tti.data(), ttp.data(), nrow, tiskip.data(), threads);
+        }
+    }
+
+    spmat_header h;
+    memset(&h, 0, sizeof(spmat_header));
+    memcpy(h.magic, SPMAT_MAGIC, 8);
+    h.version = SPMAT_VERSION | (static_cast<uint32_t>(value_type) << SPMAT_VALUE_SHIFT) |
+        (static_cast<uint32_t>(index_type) << SPMAT_INDEX_SHIFT);
+    h.byte_order = SPMAT_BYTE_ORDER;
+    h.nrow = nrow;
+    h.ncol = ncol;
+    h.nnz = nnz;
+    h.x_offset = _spmat_align(sizeof(spmat_header));
+    h.i_offset = _spmat_align(h.x_offset + nnz * vb);
+    h.p_offset = _spmat_align(h.i_offset + (coded ? (ncol + 1) * sizeof(long) + iskip[ncol] : nnz * sizeof(int)));
+    uint64_t end_offset = h.p_offset + (ncol + 1) * sizeof(long);
+    if (transposed) {
+        h.tx_offset = _spmat_align(end_offset);
+        h.ti_offset = _spmat_align(h.tx_offset + nnz * vb);
+        h.tp_offset = _spmat_align(h.ti_offset + (coded ? (nrow + 1) * sizeof(long) + tiskip[nrow] : nnz * sizeof(int)));
+        end_offset = h.tp_offset + (nrow + 1) * sizeof(long);
+    }
+    h.rownames_offset = _spmat_align(end_offset);
+    h.rownames_bytes = _spmat_names_bytes(rownames);
+    h.colnames_offset = h.rownames_offset + h.rownames_bytes;
+    h.colnames_bytes = _spmat_names_bytes(colnames);
+    h.file_bytes = h.colnames_offset + h.colnames_bytes;
+
+    std::string tmpname = filename + ".tmp";
+    int fd = open(tmpname.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("unable to create " + tmpname);
+    // the blocks are reserved up front:  writing through the mapping into a full file system (e.g. a small
+    // /dev/shm) raises SIGBUS instead of an error.  file systems without fallocate are only resized.
+    int aerr = posix_fallocate(fd, 0, h.file_bytes);
+    if ((aerr == ENOSPC) || (aerr == EFBIG)) {
+        close(fd);
+        unlink(tmpname.c_str());
+        throw std::runtime_error("not enough space to write " + tmpname);
+    }
+    if ((aerr != 0) && (ftruncate(fd, h.file_bytes) != 0)) {
+        close(fd);
+        unlink(tmpname.c_str());
+        throw std::runtime_error("unable to allocate " + tmpname);
+    }
+    void * base = mmap(NULL, h.file_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        unlink(tmpname.c_str());
+        throw std::runtime_error("unable to map " + tmpname);
+    }
+    unsigned char * b = static_cast<unsigned char *>(base);
+    void * ox = b + h.x_offset;
+    int * oi = reinterpret_cast<int *>(b + h.i_offset);
+    long * op = reinterpret_cast<long *>(b + h.p_offset);
+
+    if (!_spmat_narrow(x, nnz, value_type, ox, threads)) {
+        munmap(base, h.file_bytes);
+        close(fd);
+        unlink(tmpname.c_str());
+        throw std::invalid_argument(narrow_err);
+    }
+
+#pragma omp parallel num_threads(threads)
+{
+    int tid = omp_get_thread_num();
+    size_t block = nnz / threads;
+    size_t rem = nnz - threads * block;
+    size_t offset = tid * block + (static_cast<size_t>(tid) > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (static_cast<size_t>(nid) > rem ? rem : nid);
+
+    if (!coded) memcpy(oi + offset, i + offset, (end - offset) * sizeof(int));
+
+    block = (ncol + 1) / threads;
+    rem = (ncol + 1) - threads * block;
+    offset = tid * block + (static_cast<size_t>(tid) > rem ? rem : tid);
+    end = nid * block + (static_cast<size_t>(nid) > rem ? rem : nid);
+    for (; offset < end; ++offset) op[offset] = static_cast<long>(p[offset]);
+}
+    if (coded) {
+        memcpy(oi, iskip.data(), (ncol + 1) * sizeof(long));
+        _spmat_encode(i, op, ncol, iskip.data(), b + h.i_offset + (ncol + 1) * sizeof(long), threads);
+        if (transposed) {
+            memcpy(b + h.tx_offset, ttx.data(), nnz * vb);
+            memcpy(b + h.ti_offset, tiskip.data(), (nrow + 1) * sizeof(long));
+            _spmat_encode(tti.data(), ttp.data(), nrow, tiskip.data(), b + h.ti_offset + (nrow + 1) * sizeof(long), threads);
+            memcpy(b + h.tp_offset, ttp.data(), (nrow + 1) * sizeof(long));
+        }
+    } else if (transposed)
+        // from the copy just written, so that p is already int64.
+        _spmat_transpose(value_type, ox, oi, NULL, NULL, op,
+            nnz, static_cast<int>(nrow), static_cast<int>(ncol),
+            b + h.tx_offset, reinterpret_cast<int *>(b + h.ti_offset),
+            reinterpret_cast<long *>(b + h.tp_offset), threads);
+    _spmat_names_copy(rownames, reinterpret_cast<char *>(b + h.rownames_offset));
+    _spmat_names_copy(colnames, reinterpret_cast<char *>(b + h.colnames_offset));
+    // header last, so an interrupted write never looks like a valid file.
+    memcpy(b, &h, sizeof(spmat_header));
+
+    bool ok = (msync(base, h.file_bytes, MS_SYNC) == 0);
+    munmap(base, h.file_bytes);
+    ok &= (close(fd) == 0);
+    if (!ok || (rename(tmpname.c_str(), filename.c_str()) != 0)) {
+        unlink(tmpname.c_str());
+        throw std::runtime_error("unable to write " + filename);
+    }
+}
+
+
+// ----- out-of-core access by feature blocks
+
+// read bytes at offset, split among the threads.
+static bool _spmat_pread(int const & fd, void * out, size_t const & bytes, uint64_t const & offset, int const & threads) {
+    size_t const piece = static_cast<size_t>(1) << 22;
+    size_t npieces = (bytes + piece - 1) / piece;
+    bool ok = true;
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 1) reduction(&&:ok)
+    for (size_t k = 0; k < npieces; ++k) {
+        unsigned char * o = static_cast<unsigned char *>(out) + k * piece;
+        size_t todo = std::min(piece, bytes - k * piece);
+        uint64_t off = offset + k * piece;
+        ssize_t got;
+        while (todo > 0) {
+            got = pread(fd, o, todo, off);
+            if (got <= 0) { ok = false; break; }
+            o += got;
+            off += got;
+            todo -= got;
+        }
+    }
+    return ok;
+}
+
+// greedy blocks of features [bounds[b], bounds[b+1]) with about target elements, at least one feature each.
+static std::vector<size_t> _spmat_block_bounds(long const * p, size_t const & nfeatures, size_t const & target) {
+    std::vector<size_t> bounds(1, 0);
+    size_t t = std::max(target, static_cast<size_t>(1));
+    for (size_t f = 1; f <= nfeatures; ++f) {
+        if ((f == nfeatures) || (static_cast<size_t>(p[f + 1] - p[bounds.back()]) > t)) bounds.push_back(f);
+    }
+    if (nfeatures == 0) bounds.push_back(0);
+    return bounds;
+}
+
+spmat_block_cache::spmat_block_cache(spmat_mmap const & mat, bool const & features_as_rows, 
+    size_t const & _budget, size_t const & block_bytes) : hits(0), misses(0), skip(NULL), budget(_budget), used(0) {
+
+    spmat_header const & h = mat.header;
+    if (features_as_rows && (h.tp_offset == 0)) 
+        throw std::runtime_error("out-of-core access with features as rows needs the transpose stored in " + mat.filename);
+    value_bytes = spmat_value_bytes(mat.value_type);
+    x_offset = features_as_rows ? h.tx_offset : h.x_offset;
+    i_offset = features_as_rows ? h.ti_offset : h.i_offset;
+    p = reinterpret_cast<long const *>(static_cast<unsigned char const *>(mat.base) + (features_as_rows ? h.tp_offset : h.p_offset));
+    size_t nfeatures = features_as_rows ? h.nrow : h.ncol;
+
+    // blocks of about block_bytes as stored, with the average code length for coded indices.
+    size_t index_bytes = sizeof(int);
+    if (mat.index_type != SPMAT_IDX_I32) {
+        skip = features_as_rows ? mat.tiskip : mat.iskip;
+        i_offset += (nfeatures + 1) * sizeof(long);
+        index_bytes = (h.nnz == 0) ? 1 : (skip[nfeatures] + h.nnz - 1) / h.nnz;
+    }
+    bounds = _spmat_block_bounds(p, nfeatures, block_bytes / (value_bytes + index_bytes));
+
+    fd = open(mat.filename.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("unable to open " + mat.filename);
+}
+
+spmat_block_cache::~spmat_block_cache() {
+    if (fd >= 0) close(fd);
+}
+
+std::shared_ptr<spmat_block const> spmat_block_cache::get(size_t const & b, int const & threads) {
+    auto it = blocks.find(b);
+    if (it != blocks.end()) {
+        ++hits;
+        lru.splice(lru.begin(), lru, it->second.second);
+        return it->second.first;
+    }
+    ++misses;
+
+    size_t first = bounds[b];
+    size_t count = bounds[b + 1] - first;
+    long start = p[first];
+    size_t nnz = p[bounds[b + 1]] - start;
+    // drop least recently used blocks to make room, before allocating.  one that is not in use elsewhere
+    // (e.g. queued by spmat_feature_blocks) is recycled, so its buffers are reused.
+    std::shared_ptr<spmat_block> blk;
+    size_t ibytes = (skip == NULL) ? nnz * sizeof(int) : skip[bounds[b + 1]] - skip[first];
+    size_t need = nnz * value_bytes + ibytes + (count + 1) * sizeof(long) * (skip == NULL ? 1 : 2);
+    while (!lru.empty() && (used + need > budget)) {
+        auto victim = blocks.find(lru.back());
+        used -= victim->second.first->bytes();
+        if (!blk && (victim->second.first.use_count() == 1)) {
+            std::atomic_thread_fence(std::memory_order_acquire);   // the last user's release happened before.
+            blk = victim->second.first;
+        }
+        blocks.erase(victim);
+        lru.pop_back();
+    }
+    if (!blk) blk = std::make_shared<spmat_block>();
+    blk->first = first;
+    blk->count = count;
+    blk->p.resize(count + 1);
+    for (size_t f = 0; f <= count; ++f) blk->p[f] = p[first + f] - start;
+    blk->x.resize(nnz * value_bytes);
+    bool ok = _spmat_pread(fd, blk->x.data(), nnz * value_bytes, x_offset + start * value_bytes, threads);
+    if (skip == NULL) {
+        blk->i.resize(nnz);
+        blk->ci.clear();
+        blk->skip.clear();
+        ok = ok && _spmat_pread(fd, blk->i.data(), ibytes, i_offset + start * sizeof(int), threads);
+    } else {
+        blk->i.clear();
+        blk->ci.resize(ibytes);
+        blk->skip.resize(count + 1);
+        for (size_t f = 0; f <= count; ++f) blk->skip[f] = skip[first + f] - skip[first];
+        ok = ok && _spmat_pread(fd, blk->ci.data(), ibytes, i_offset + skip[first], threads);
+    }
+    if (!ok) throw std::runtime_error("unable to read a block of the sparse matrix file");
+
+    lru.push_front(b);
+    blocks[b] = std::make_pair(blk, lru.begin());
+    used += blk->bytes();
+    return blk;
+}
+
+void spmat_set_cache(spmat_mmap & mat, size_t const & budget, size_t const & block_bytes, size_t const & prefetch) {
+    mat.cache_budget = budget;
+    mat.cache_block_bytes = block_bytes;
+    mat.prefetch = prefetch;
+    mat.caches[0].reset();
+    mat.caches[1].reset();
+}
+
+// in memory, compact values are widened (and coded indices decoded) in blocks of about this many bytes of doubles
+// (unless a cache block size is set).
+#define SPMAT_WIDEN_BYTES (static_cast<size_t>(1) << 26)
+
+// a cached block on its way to the kernel, with its values widened to doubles unless they are stored as doubles,
+// and its indices decoded if coded.
+struct _spmat_wide_block {
+    std::shared_ptr<spmat_block const> blk;
+    std::vector<double> x;
+    std::vector<int> i;
+};
+
+void spmat_feature_blocks(spmat_mmap & mat, bool const & features_as_rows, int const & threads, spmat_block_fn const & f) {
+    int const vt = mat.value_type;
+    if (mat.cache_budget == 0) {
+        if (features_as_rows) spmat_transposed(mat, threads);
+        void * x = features_as_rows ? mat.tx : mat.x;
+        int * i = features_as_rows ? mat.ti : mat.i;
+        long * p = features_as_rows ? mat.tp : mat.p;
+        long const * skip = features_as_rows ? mat.tiskip : mat.iskip;
+        unsigned char const * code = features_as_rows ? mat.ticode : mat.icode;
+        size_t nfeatures = features_as_rows ? mat.header.nrow : mat.header.ncol;
+        if ((vt == SPMAT_F64) && (i != NULL)) {
+            f(static_cast<double *>(x), i, p, 0, nfeatures);
+            return;
+        }
+
+        // compact values or coded indices:  one block at a time, the rest straight from the mapping.
+        std::vector<size_t> bounds = _spmat_block_bounds(p, nfeatures,
+            (mat.cache_block_bytes > 0 ? mat.cache_block_bytes : SPMAT_WIDEN_BYTES) / sizeof(double));
+        std::vector<double> wide;
+        std::vector<int> idx;
+        std::vector<long> lp;
+        size_t const vb = spmat_value_bytes(vt);
+        double * bx;
+        int * bi;
+        for (size_t b = 0; b + 1 < bounds.size(); ++b) {
+            size_t first = bounds[b];
+            size_t count = bounds[b + 1] - first;
+            long start = p[first];
+            size_t nnz = p[bounds[b + 1]] - start;
+            if (vt == SPMAT_F64) bx = static_cast<double *>(x) + start;
+            else {
+                wide.resize(nnz);
+                _spmat_widen(static_cast<unsigned char const *>(x) + start * vb, vt, nnz, wide.data(), threads);
+                bx = wide.data();
+            }
+            if (i != NULL) bi = i + start;
+            else {
+                idx.resize(nnz);
+                _spmat_decode_features(skip, code, p, first, count, idx.data(), threads);
+                bi = idx.data();
+            }
+            lp.resize(count + 1);
+            for (size_t k = 0; k <= count; ++k) lp[k] = p[first + k] - start;
+            f(bx, bi, lp.data(), first, count);
+        }
+        return;
+    }
+
+    std::shared_ptr<spmat_block_cache> & cache = mat.caches[features_as_rows ? 1 : 0];
+    if (!cache) cache = std::make_shared<spmat_block_cache>(mat, features_as_rows, mat.cache_budget, mat.cache_block_bytes);
+    // only the reader thread uses the cache.  a few threads keep enough reads in flight, the rest compute.
+    // compact values are widened and coded indices decoded by the reader as well, into the recycled pipeline buffers.
+    spmat_block_cache * c = cache.get();
+    int io_threads = std::min(threads, 4);
+    bool const coded = (mat.index_type != SPMAT_IDX_I32);
+    prefetch_pipeline<_spmat_wide_block>(c->nblocks(), mat.prefetch,
+        [c, io_threads, vt, coded](size_t const & b, _spmat_wide_block & w) {
+            w.blk = c->get(b, io_threads);
+            spmat_block const & blk = *(w.blk);
+            size_t nnz = blk.p.back();
+            if (coded) {
+                w.i.resize(nnz);
+                _spmat_decode_features(blk.skip.data(), blk.ci.data(), blk.p.data(), 0, blk.count, w.i.data(), io_threads);
+            }
+            if (vt == SPMAT_F64) return;
+            w.x.resize(nnz);
+            _spmat_widen(blk.x.data(), vt, nnz, w.x.data(), io_threads);
+        },
+        [&f, vt, coded](size_t const & b, _spmat_wide_block & w) {
+            double * x = (vt == SPMAT_F64) ? reinterpret_cast<double *>(const_cast<unsigned char *>(w.blk->x.data())) : w.x.data();
+            int * i = coded ? w.i.data() : const_cast<int *>(w.blk->i.data());
+            f(x, i, const_cast<long *>(w.blk->p.data()), w.blk->first, w.blk->count);
+            w.blk.reset();
+        });
+}
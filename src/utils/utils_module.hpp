@@ -0,0 +1,38 @@
+#pragma once 
+
+#include <stddef.h>
+#include <cstdint>
+#include <vector>
+
+/*
+ * module scores (Seurat AddModuleScore) for R dgCMatrix / dgCMatrix64, features (genes) in rows.
+ *
+ * modules are given as flattened 0-based row ids, module m is ids[offsets[m] .. offsets[m + 1]).
+ */
+
+// rows are ranked by mean (ties by row id) and split into nbin bins of equal size.
+// for each gene of module m, ctrl genes are drawn without replacement from its bin, using the random stream (seed, m).
+// the union per module is its control set, returned in the same flattened form.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_module_controls(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    int const * module_ids, int const * module_offsets, size_t const & nmodules,
+    int const & nbin, int const & ctrl, uint64_t const & seed,
+    std::vector<int> & ctrl_ids, std::vector<int> & ctrl_offsets,
+    int const & threads);
+
+// one sweep over the columns:  score = mean over module genes - mean over control genes, per cell and module.
+// scores is cols x nmodules, column major.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_module_scores(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    int const * module_ids, int const * module_offsets, size_t const & nmodules,
+    int const * ctrl_ids, int const * ctrl_offsets,
+    double * scores,
+    int const & threads);
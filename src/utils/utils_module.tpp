@@ -0,0 +1,191 @@
+#pragma once
+
+#include "utils_module.hpp"
+#include "utils_random.hpp"
+
+/*
+ * module scores (Seurat AddModuleScore) for R dgCMatrix / dgCMatrix64
+ *
+ */
+
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_module_controls(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    int const * module_ids, int const * module_offsets, size_t const & nmodules,
+    int const & nbin, int const & ctrl, uint64_t const & seed,
+    std::vector<int> & ctrl_ids, std::vector<int> & ctrl_offsets,
+    int const & threads) {
+
+    // ---- row sums, per thread accumulators.
+    std::vector<std::vector<double>> partials(threads);
+    std::vector<double> sums(rows, 0);
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    partials[tid].resize(rows, 0);
+    double * s = partials[tid].data();
+    size_t start = p[offset], end2 = p[end];
+    for (size_t e = start; e < end2; ++e) {
+        s[i[e]] += x[e];
+    }
+
+#pragma omp barrier
+
+    block = rows / threads;
+    rem = rows - threads * block;
+    offset = tid * block + (tid > rem ? rem : tid);
+    end = nid * block + (nid > rem ? rem : nid);
+    for (size_t r = offset; r < end; ++r) {
+        for (int t = 0; t < threads; ++t) {
+            sums[r] += partials[t][r];
+        }
+    }
+}
+    partials.clear();
+
+    // ---- bins of equal size by mean rank.  sums rank the same as means.
+    std::vector<int> order(rows);
+    for (size_t r = 0; r < rows; ++r) order[r] = r;
+    std::stable_sort(order.begin(), order.end(), [&sums](int const & a, int const & b){ return sums[a] < sums[b]; });
+    std::vector<int> bin_of(rows);
+    std::vector<int> bin_offsets(nbin + 1, 0);
+    for (size_t r = 0; r < rows; ++r) {
+        bin_of[order[r]] = static_cast<int>(r * nbin / rows);
+        ++bin_offsets[bin_of[order[r]] + 1];
+    }
+    for (int b = 0; b < nbin; ++b) bin_offsets[b + 1] += bin_offsets[b];
+    // order is now the bin members, bin b is order[bin_offsets[b] .. bin_offsets[b + 1]).
+
+    // ---- control sets.  one stream per module, so the result does not depend on threads.
+    std::vector<std::vector<int>> ctrls(nmodules);
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = nmodules / threads;
+    int rem = nmodules - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    std::vector<int> pool;
+    std::vector<char> used(rows);
+    for (; offset < end; ++offset) {
+        splitmix64_stream rng(seed, offset);
+        std::fill(used.begin(), used.end(), 0);
+        std::vector<int> & cs = ctrls[offset];
+
+        for (int e = module_offsets[offset]; e < module_offsets[offset + 1]; ++e) {
+            int b = bin_of[module_ids[e]];
+            pool.assign(order.begin() + bin_offsets[b], order.begin() + bin_offsets[b + 1]);
+            size_t n = pool.size();
+            size_t k = std::min(n, static_cast<size_t>(ctrl));
+            // partial Fisher-Yates.
+            for (size_t j = 0; j < k; ++j) {
+                std::swap(pool[j], pool[j + rng.below(n - j)]);
+                if (!used[pool[j]]) {
+                    used[pool[j]] = 1;
+                    cs.push_back(pool[j]);
+                }
+            }
+        }
+        std::sort(cs.begin(), cs.end());
+    }
+}
+
+    ctrl_offsets.assign(nmodules + 1, 0);
+    for (size_t m = 0; m < nmodules; ++m) {
+        ctrl_offsets[m + 1] = ctrl_offsets[m] + ctrls[m].size();
+    }
+    ctrl_ids.resize(ctrl_offsets[nmodules]);
+    for (size_t m = 0; m < nmodules; ++m) {
+        std::copy(ctrls[m].begin(), ctrls[m].end(), ctrl_ids.begin() + ctrl_offsets[m]);
+    }
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_module_scores(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    int const * module_ids, int const * module_offsets, size_t const & nmodules,
+    int const * ctrl_ids, int const * ctrl_offsets,
+    double * scores,
+    int const & threads) {
+
+    // per row list of weighted targets:  +1/|module| into module m, -1/|ctrl| from the same score.
+    // a row in both a module and its control set gets both entries.
+    std::vector<size_t> row_offsets(rows + 1, 0);
+    for (size_t m = 0; m < nmodules; ++m) {
+        for (int e = module_offsets[m]; e < module_offsets[m + 1]; ++e) ++row_offsets[module_ids[e] + 1];
+        for (int e = ctrl_offsets[m]; e < ctrl_offsets[m + 1]; ++e) ++row_offsets[ctrl_ids[e] + 1];
+    }
+    for (size_t r = 0; r < rows; ++r) row_offsets[r + 1] += row_offsets[r];
+    std::vector<int> targets(row_offsets[rows]);
+    std::vector<double> weights(row_offsets[rows]);
+    {
+        std::vector<size_t> pos(row_offsets.begin(), row_offsets.end() - 1);
+        double w;
+        for (size_t m = 0; m < nmodules; ++m) {
+            w = 1.0 / static_cast<double>(module_offsets[m + 1] - module_offsets[m]);
+            for (int e = module_offsets[m]; e < module_offsets[m + 1]; ++e) {
+                targets[pos[module_ids[e]]] = m;
+                weights[pos[module_ids[e]]++] = w;
+            }
+            if (ctrl_offsets[m + 1] == ctrl_offsets[m]) continue;
+            w = -1.0 / static_cast<double>(ctrl_offsets[m + 1] - ctrl_offsets[m]);
+            for (int e = ctrl_offsets[m]; e < ctrl_offsets[m + 1]; ++e) {
+                targets[pos[ctrl_ids[e]]] = m;
+                weights[pos[ctrl_ids[e]]++] = w;
+            }
+        }
+    }
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    std::vector<double> acc(nmodules);
+    size_t start, end2, r;
+    double val;
+    for (; offset < end; ++offset) {
+        std::fill(acc.begin(), acc.end(), 0);
+        start = p[offset];
+        end2 = p[offset + 1];
+        for (size_t e = start; e < end2; ++e) {
+            r = i[e];
+            val = x[e];
+            for (size_t t = row_offsets[r]; t < row_offsets[r + 1]; ++t) {
+                acc[targets[t]] += weights[t] * val;
+            }
+        }
+        for (size_t m = 0; m < nmodules; ++m) {
+            scores[m * cols + offset] = acc[m];
+        }
+    }
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+#include <zlib.h>
+
+/*
+ * Matrix Market coordinate files (CellRanger matrix.mtx / matrix.mtx.gz) read directly into CSC.
+ *
+ * the file is inflated in large blocks by the calling thread.  each block is split at line boundaries
+ * and parsed by the OpenMP threads straight into the output x and i arrays, at the entry offsets given
+ * by a per-thread line count.  column pointers come from a column count;  entries that are not in
+ * column order are scattered, and columns with unsorted rows are sorted, in parallel.
+ */
+
+struct mtx_header {
+    size_t nrow;
+    size_t ncol;
+    size_t nnz;
+    bool pattern;   // no values in the file, all 1.
+};
+
+// open a plain or gzip compressed file and parse the banner and size line.
+// throws std::runtime_error for unsupported (array, complex, symmetric) or malformed files.
+extern gzFile mtx_open(std::string const & filename, mtx_header & header);
+
+// read the entries of an opened file into CSC.  x and i have header.nnz elements, p has header.ncol + 1.
+// repeated (row, column) entries are summed, as Matrix::readMM does:  returns the number of entries left,
+// at the start of x and i.
+template <typename XT, typename PT>
+extern size_t mtx_read_csc(gzFile file, mtx_header const & header,
+    XT * x, int * i, PT * p, int const & threads);
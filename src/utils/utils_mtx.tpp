@@ -0,0 +1,306 @@
+#pragma once
+
+#include "utils_mtx.hpp"
+
+/*
+ * Matrix Market coordinate reader
+ *
+ */
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include <memory>
+
+#include <zlib.h>
+#include <omp.h>
+
+
+gzFile mtx_open(std::string const & filename, mtx_header & header) {
+    gzFile file = gzopen(filename.c_str(), "rb");
+    if (file == NULL) throw std::runtime_error("unable to open " + filename);
+    gzbuffer(file, 1 << 20);
+
+    char line[4096];
+    if (gzgets(file, line, sizeof(line)) == NULL) {
+        gzclose(file);
+        throw std::runtime_error(filename + " is empty");
+    }
+    std::string banner(line);
+    std::transform(banner.begin(), banner.end(), banner.begin(), ::tolower);
+    if ((banner.compare(0, 14, "%%matrixmarket") != 0) || (banner.find("coordinate") == std::string::npos)) {
+        gzclose(file);
+        throw std::runtime_error(filename + " is not a Matrix Market coordinate file");
+    }
+    if ((banner.find("complex") != std::string::npos) || (banner.find("general") == std::string::npos)) {
+        gzclose(file);
+        throw std::runtime_error(filename + ":  only real, integer, or pattern general matrices are supported");
+    }
+    header.pattern = (banner.find("pattern") != std::string::npos);
+
+    // comments, then the size line.  lines longer than the buffer come back in pieces.
+    bool line_start = (strchr(line, '\n') != NULL);
+    char const * s;
+    while (gzgets(file, line, sizeof(line)) != NULL) {
+        bool comment = !line_start;
+        line_start = (strchr(line, '\n') != NULL);
+        if (comment || (line[0] == '%')) continue;
+        for (s = line; (*s == ' ') || (*s == '\t'); ++s);
+        if ((*s == '\n') || (*s == '\r') || (*s == 0)) continue;
+        unsigned long long r, c, n;
+        if (sscanf(s, "%llu %llu %llu", &r, &c, &n) != 3) break;
+        header.nrow = r;
+        header.ncol = c;
+        header.nnz = n;
+        return file;
+    }
+    gzclose(file);
+    throw std::runtime_error(filename + " has no size line");
+}
+
+static inline void _mtx_skip_space(char const * & s) {
+    while ((*s == ' ') || (*s == '\t')) ++s;
+}
+
+// unsigned integer at s.  false if there is no digit.
+static inline bool _mtx_parse_index(char const * & s, size_t & v) {
+    _mtx_skip_space(s);
+    if ((*s < '0') || (*s > '9')) return false;
+    v = 0;
+    for (; (*s >= '0') && (*s <= '9'); ++s) v = v * 10 + (*s - '0');
+    return true;
+}
+
+// integers (the common case for counts) are parsed directly, anything else through strtod.
+static inline bool _mtx_parse_value(char const * & s, double & v) {
+    _mtx_skip_space(s);
+    char const * st = s;
+    bool neg = (*s == '-');
+    if ((*s == '-') || (*s == '+')) ++s;
+    unsigned long long iv = 0;
+    char const * digits = s;
+    for (; (*s >= '0') && (*s <= '9'); ++s) iv = iv * 10 + (*s - '0');
+    if ((s > digits) && (s - digits < 19) && (*s != '.') && (*s != 'e') && (*s != 'E')) {
+        v = neg ? -static_cast<double>(iv) : static_cast<double>(iv);
+        return true;
+    }
+    char * e;
+    v = strtod(st, &e);
+    s = e;
+    return e != st;
+}
+
+// first character after the line containing pos-1, i.e. pos if pos is at a line start.
+static inline size_t _mtx_line_start(char const * buf, size_t const & pos, size_t const & end) {
+    if (pos == 0) return 0;
+    char const * nl = static_cast<char const *>(memchr(buf + pos - 1, '\n', end - pos + 1));
+    return (nl == NULL) ? end : (nl - buf + 1);
+}
+
+// true if the line at s has an entry (not blank or a comment)
+static inline bool _mtx_is_entry(char const * s) {
+    _mtx_skip_space(s);
+    return (*s != '\n') && (*s != '\r') && (*s != '%') && (*s != 0);
+}
+
+
+template <typename XT, typename PT>
+extern size_t mtx_read_csc(gzFile file, mtx_header const & header,
+    XT * x, int * i, PT * p, int const & threads) {
+
+    size_t const nnz = header.nnz;
+    size_t const ncol = header.ncol;
+    std::vector<int> cols(nnz);
+
+    // text block, not zero initialized.
+    size_t const block = static_cast<size_t>(1) << 24;
+    std::unique_ptr<char[]> text(new char[block + 1]);
+    char * buf = text.get();
+    std::vector<size_t> bounds(threads + 1);
+    std::vector<size_t> counts(threads + 1);
+    size_t carry = 0, len, end, k = 0;
+    int got;
+    bool eof = false;
+    int bad = 0;
+
+    while (!eof) {
+        got = gzread(file, buf + carry, block - carry);
+        if (got < 0) throw std::runtime_error("error decompressing Matrix Market file");
+        len = carry + got;
+        buf[len] = 0;
+        eof = (got == 0) || gzeof(file);
+        if (eof) end = len;
+        else {
+            // up to the last complete line.
+            for (end = len; (end > 0) && (buf[end - 1] != '\n'); --end);
+            if (end == 0) throw std::runtime_error("Matrix Market line longer than the read buffer");
+        }
+
+        for (int t = 0; t <= threads; ++t) bounds[t] = _mtx_line_start(buf, end * t / threads, end);
+        bounds[threads] = end;
+
+#pragma omp parallel num_threads(threads)
+{
+        int tid = omp_get_thread_num();
+        char const * s;
+        char const * stop = buf + bounds[tid + 1];
+        char const * nl;
+        size_t cnt = 0;
+        for (s = buf + bounds[tid]; s < stop; s = nl + 1) {
+            nl = static_cast<char const *>(memchr(s, '\n', stop - s));
+            if (nl == NULL) nl = stop;
+            cnt += _mtx_is_entry(s);
+        }
+        counts[tid + 1] = cnt;
+#pragma omp barrier
+#pragma omp single
+{
+        counts[0] = k;
+        for (int t = 0; t < threads; ++t) counts[t + 1] += counts[t];
+}
+        size_t e = counts[tid];
+        size_t r, c;
+        double v = 1.0;
+        bool ok = (counts[threads] <= nnz);
+        for (s = buf + bounds[tid]; ok && (s < stop); s = nl + 1) {
+            nl = static_cast<char const *>(memchr(s, '\n', stop - s));
+            if (nl == NULL) nl = stop;
+            if (!_mtx_is_entry(s)) continue;
+            ok = _mtx_parse_index(s, r) && _mtx_parse_index(s, c) && (header.pattern || _mtx_parse_value(s, v)) &&
+                (r >= 1) && (r <= header.nrow) && (c >= 1) && (c <= ncol);
+            if (!ok) break;
+            x[e] = v;
+            i[e] = r - 1;
+            cols[e] = c - 1;
+            ++e;
+        }
+        if (!ok) {
+#pragma omp atomic write
+            bad = 1;
+        }
+}
+        if (bad) {
+            if (counts[threads] > nnz) throw std::runtime_error("Matrix Market file has more entries than its size line");
+            throw std::runtime_error("malformed or out of range Matrix Market entry");
+        }
+        k = counts[threads];
+        carry = len - end;
+        memmove(buf, buf + end, carry);
+    }
+    if (k != nnz) throw std::runtime_error("Matrix Market file has fewer entries than its size line");
+
+    // CellRanger writes entries in column order.  check, and check the row order within columns.
+    int col_sorted = 1, row_sorted = 1;
+#pragma omp parallel num_threads(threads) reduction(&& : col_sorted, row_sorted)
+{
+    int tid = omp_get_thread_num();
+    size_t block = nnz / threads;
+    size_t rem = nnz - threads * block;
+    size_t offset = tid * block + (static_cast<size_t>(tid) > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (static_cast<size_t>(nid) > rem ? rem : nid);
+
+    for (size_t e = (offset == 0 ? 1 : offset); e < end; ++e) {
+        if (cols[e] < cols[e - 1]) col_sorted = 0;
+        else if ((cols[e] == cols[e - 1]) && (i[e] <= i[e - 1])) row_sorted = 0;
+    }
+}
+
+    if (col_sorted) {
+        // column pointers by binary search, partitioned by column.
+#pragma omp parallel num_threads(threads)
+{
+        int tid = omp_get_thread_num();
+        size_t block = (ncol + 1) / threads;
+        size_t rem = (ncol + 1) - threads * block;
+        size_t offset = tid * block + (static_cast<size_t>(tid) > rem ? rem : tid);
+        int nid = tid + 1;
+        size_t end = nid * block + (static_cast<size_t>(nid) > rem ? rem : nid);
+
+        for (size_t c = offset; c < end; ++c)
+            p[c] = std::lower_bound(cols.begin(), cols.end(), static_cast<int>(c)) - cols.begin();
+}
+    } else {
+        // counting sort:  column counts, then scatter through per column cursors.
+        std::vector<size_t> cursor(ncol + 1, 0);
+#pragma omp parallel for num_threads(threads)
+        for (size_t e = 0; e < nnz; ++e) {
+#pragma omp atomic
+            ++cursor[cols[e] + 1];
+        }
+        for (size_t c = 0; c < ncol; ++c) cursor[c + 1] += cursor[c];
+        for (size_t c = 0; c <= ncol; ++c) p[c] = cursor[c];
+
+        std::vector<XT> x2(nnz);
+        std::vector<int> i2(nnz);
+#pragma omp parallel for num_threads(threads)
+        for (size_t e = 0; e < nnz; ++e) {
+            size_t pos;
+#pragma omp atomic capture
+            pos = cursor[cols[e]]++;
+            x2[pos] = x[e];
+            i2[pos] = i[e];
+        }
+        std::copy(x2.begin(), x2.end(), x);
+        std::copy(i2.begin(), i2.end(), i);
+        // the scatter order within a column is arbitrary.
+        row_sorted = 0;
+    }
+    std::vector<int>().swap(cols);
+
+    if (row_sorted) return nnz;
+
+    // sort each column by row, summing repeated rows.  kept:  entries left in each column.
+    std::vector<size_t> kept(ncol);
+    int repeated = 0;
+#pragma omp parallel num_threads(threads) reduction(|| : repeated)
+{
+    std::vector<std::pair<int, XT>> entries;
+    size_t start, stop, w;
+#pragma omp for schedule(dynamic, 64)
+    for (size_t c = 0; c < ncol; ++c) {
+        start = p[c];
+        stop = p[c + 1];
+        kept[c] = stop - start;
+        bool sorted = true;
+        for (size_t e = start + 1; sorted && (e < stop); ++e) sorted = (i[e - 1] < i[e]);
+        if (sorted) continue;
+        entries.clear();
+        for (size_t e = start; e < stop; ++e) entries.emplace_back(i[e], x[e]);
+        std::stable_sort(entries.begin(), entries.end(),
+            [](std::pair<int, XT> const & a, std::pair<int, XT> const & b) { return a.first < b.first; });
+        w = start;
+        for (size_t e = start; e < stop; ++e) {
+            if ((w > start) && (i[w - 1] == entries[e - start].first)) {
+                x[w - 1] += entries[e - start].second;
+                continue;
+            }
+            i[w] = entries[e - start].first;
+            x[w] = entries[e - start].second;
+            ++w;
+        }
+        kept[c] = w - start;
+        if (w < stop) repeated = 1;
+    }
+}
+    if (!repeated) return nnz;
+
+    // close the gaps, in column order since columns only move down.
+    size_t w = 0, start;
+    for (size_t c = 0; c < ncol; ++c) {
+        start = p[c];
+        if ((w != start) && (kept[c] > 0)) {
+            memmove(x + w, x + start, kept[c] * sizeof(XT));
+            memmove(i + w, i + start, kept[c] * sizeof(int));
+        }
+        p[c] = w;
+        w += kept[c];
+    }
+    p[ncol] = w;
+    return w;
+}
@@ -0,0 +1,137 @@
+#pragma once 
+
+#include <stddef.h>
+
+/*
+ * in-place normalization for R dgCMatrix / dgCMatrix64
+ *
+ * x is overwritten with the normalized values.  i and p are only read, so
+ * the caller can reuse them for the output matrix without copying.
+ * PVEC/IVEC can be any random access container (cpp11::r_vector, std::vector, pointer)
+ */
+
+// log1p(x / colsum * scale_factor), per column.
+template <typename XT, typename PVEC>
+extern void csc_log_normalize_inplace(
+    XT * x, 
+    PVEC const & p, 
+    size_t const & cols, 
+    double const & scale_factor, 
+    int const & threads);
+
+// x / colsum * scale_factor, per column.
+template <typename XT, typename PVEC>
+extern void csc_relative_count_inplace(
+    XT * x, 
+    PVEC const & p, 
+    size_t const & cols, 
+    double const & scale_factor, 
+    int const & threads);
+
+// centered log ratio, geometric mean computed per column (margin = 2).
+template <typename XT, typename IVEC, typename PVEC>
+extern void csc_clr_cols_inplace(
+    XT * x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols, 
+    int const & threads);
+
+// centered log ratio, geometric mean computed per row (margin = 1).  one read of x for the row log sums, 
+// then one streaming pass to out.  out may be x.
+template <typename XT, typename IVEC, typename PVEC>
+extern void csc_clr_rows(
+    XT const * x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols, 
+    XT * out,
+    int const & threads);
+
+// centered log ratio, geometric mean computed per row (margin = 1).
+template <typename XT, typename IVEC, typename PVEC>
+extern void csc_clr_rows_inplace(
+    XT * x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols, 
+    int const & threads);
+
+
+// on-the-fly normalization of a DE kernel's private working copy of raw counts.
+// rows of the working copy are samples (cells), so the per-sample total is looked up by row id.
+// method uses the sp_normalize codes:  0 = LogNormalize, 2 = RC.  other values leave x unchanged.
+template <typename XT, typename IT, typename SVEC>
+extern void csc_normalize_by_row_inplace(
+    XT * x, 
+    IT const * i, 
+    size_t const & nelem, 
+    int const & method, 
+    double const & scale_factor, 
+    SVEC const & row_sums, 
+    int const & threads);
+
+
+/*
+ * analytic Pearson residuals, features (genes) in rows, raw counts.  never materialized.
+ *   mu = cell_total[c] * gene_frac[r],  residual = (x - mu) / sqrt(mu + mu^2 / theta),  clipped to [-clip, clip].
+ * zero entries use the closed form with x = 0, so only the two parameter vectors are stored.
+ */
+
+// one pass over CSC.  row (gene) and column (cell) totals.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_col_sums(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols, 
+    double * row_sums, double * col_sums,
+    int const & threads);
+
+// dense residual sub-matrix, column major.  row_ids and col_ids are 0-based.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_pearson_to_dense(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows,
+    double const * gene_frac, double const * cell_totals, double const & theta, double const & clip,
+    int const * row_ids, size_t const & nrow_out,
+    int const * col_ids, size_t const & ncol_out,
+    double * out,
+    int const & threads);
+
+// R * B.  B is cols x k, row-major.  output is rows x k, column major.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_pearson_prod(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * gene_frac, double const * cell_totals, double const & theta, double const & clip,
+    double const * B, size_t const & k,
+    double * out,
+    int const & threads);
+
+// R^T * U.  U is rows x k, row-major.  output is cols x k, column major.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_pearson_tprod(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * gene_frac, double const * cell_totals, double const & theta, double const & clip,
+    double const * U, size_t const & k,
+    double * out,
+    int const & threads);
+
+// per row residual mean and variance (n denominator), for variable feature selection.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_pearson_row_var(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * gene_frac, double const * cell_totals, double const & theta, double const & clip,
+    double * means, double * vars,
+    int const & threads);
@@ -0,0 +1,604 @@
+#pragma once
+
+#include "utils_normalize.hpp"
+#include "utils_fastmath.hpp"
+
+/*
+ * in-place normalization for R dgCMatrix / dgCMatrix64
+ *
+ */
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <omp.h>
+
+
+// log1p(x / colsum * scale_factor), per column.
+template <typename XT, typename PVEC>
+extern void csc_log_normalize_inplace(
+    XT * x, 
+    PVEC const & p, 
+    size_t const & cols, 
+    double const & scale_factor, 
+    int const & threads) {
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    size_t start, end2;
+    double sum;
+    for (; offset < end; ++offset) {
+        start = p[offset];
+        end2 = p[offset + 1];
+
+        // column sum first, then overwrite.  the column is small enough to stay in cache.
+        sum = 0;
+        for (size_t e = start; e < end2; ++e) {
+            sum += x[e];
+        }
+        if (sum == 0) continue;   // all zero (or cancelling) column.  leave as is, same as log1p(0).
+
+        // same operation order as Seurat so results are bitwise identical (in MATH_STRICT mode).
+        for (size_t e = start; e < end2; ++e) {
+            x[e] = x[e] / sum * scale_factor;
+        }
+        vec_log1p(x + start, end2 - start, x + start);
+    }
+}
+
+}
+
+// x / colsum * scale_factor, per column.
+template <typename XT, typename PVEC>
+extern void csc_relative_count_inplace(
+    XT * x, 
+    PVEC const & p, 
+    size_t const & cols, 
+    double const & scale_factor, 
+    int const & threads) {
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    size_t start, end2;
+    double sum;
+    for (; offset < end; ++offset) {
+        start = p[offset];
+        end2 = p[offset + 1];
+
+        sum = 0;
+        for (size_t e = start; e < end2; ++e) {
+            sum += x[e];
+        }
+        if (sum == 0) continue;
+
+        for (size_t e = start; e < end2; ++e) {
+            x[e] = x[e] / sum * scale_factor;
+        }
+    }
+}
+
+}
+
+// centered log ratio, geometric mean computed per column (margin = 2).
+// matches Seurat:  log1p(x / exp(sum(log1p(x[x > 0])) / length(x)))
+template <typename XT, typename IVEC, typename PVEC>
+extern void csc_clr_cols_inplace(
+    XT * x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols, 
+    int const & threads) {
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    size_t start, end2;
+    double sum;
+    for (; offset < end; ++offset) {
+        start = p[offset];
+        end2 = p[offset + 1];
+
+        sum = 0;
+        for (size_t e = start; e < end2; ++e) {
+            if (x[e] > 0) sum += log1p(x[e]);
+        }
+        // zeros contribute log1p(0) = 0 to the sum, but count in the length.
+        sum = exp(sum / static_cast<double>(rows));
+        for (size_t e = start; e < end2; ++e) {
+            x[e] = x[e] / sum;
+        }
+        vec_log1p(x + start, end2 - start, x + start);
+    }
+}
+
+}
+
+// centered log ratio, geometric mean computed per row (margin = 1).
+// row log sums need a scatter over all of x, so accumulate per thread in one read of x and i, then reduce.
+// the second pass streams x to out.  out may be x.
+template <typename XT, typename IVEC, typename PVEC>
+extern void csc_clr_rows(
+    XT const * x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols, 
+    XT * out,
+    int const & threads) {
+
+    size_t nzcount = p[cols];
+
+    std::vector<std::vector<double>> sums(threads);
+    std::vector<double> gmeans(rows, 0);
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = nzcount / threads;
+    int rem = nzcount - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    // pass 1:  per thread log sums, partitioned by element.  
+    // log1p goes through a small buffer so the vectorized kernel can be used.
+    sums[tid] = std::vector<double>(rows, 0);
+    double * lsum = sums[tid].data();
+    double buf[512];
+    size_t n;
+    for (size_t e = offset; e < end; e += 512) {
+        n = std::min(static_cast<size_t>(512), end - e);
+        vec_log1p(x + e, n, buf);
+        for (size_t j = 0; j < n; ++j) {
+            if (x[e + j] > 0) lsum[i[e + j]] += buf[j];
+        }
+    }
+
+#pragma omp barrier
+
+    // reduce, partitioned by row.
+    size_t rblock = rows / threads;
+    int rrem = rows - threads * rblock;
+    size_t roffset = tid * rblock + (tid > rrem ? rrem : tid);
+    size_t rend = nid * rblock + (nid > rrem ? rrem : nid);
+
+    double sum;
+    for (size_t r = roffset; r < rend; ++r) {
+        sum = 0;
+        for (int t = 0; t < threads; ++t) {
+            sum += sums[t][r];
+        }
+        gmeans[r] = exp(sum / static_cast<double>(cols));
+    }
+
+#pragma omp barrier
+
+    // pass 2:  rewrite, same element partition.
+    for (size_t e = offset; e < end; ++e) {
+        out[e] = x[e] / gmeans[i[e]];
+    }
+    vec_log1p(out + offset, end - offset, out + offset);
+}
+
+}
+
+template <typename XT, typename IVEC, typename PVEC>
+extern void csc_clr_rows_inplace(
+    XT * x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols, 
+    int const & threads) {
+    csc_clr_rows(x, i, p, rows, cols, x, threads);
+}
+
+
+// on-the-fly normalization of a DE kernel's private working copy of raw counts.
+// streaming pass, partitioned by element.
+template <typename XT, typename IT, typename SVEC>
+extern void csc_normalize_by_row_inplace(
+    XT * x, 
+    IT const * i, 
+    size_t const & nelem, 
+    int const & method, 
+    double const & scale_factor, 
+    SVEC const & row_sums, 
+    int const & threads) {
+
+    if ((method != 0) && (method != 2)) return;
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = nelem / threads;
+    int rem = nelem - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    // same operation order as csc_log_normalize_inplace / csc_relative_count_inplace.
+    if (method == 0) {
+        for (size_t e = offset; e < end; ++e) {
+            x[e] = x[e] / row_sums[i[e]] * scale_factor;
+        }
+        vec_log1p(x + offset, end - offset, x + offset);
+    } else {
+        for (; offset < end; ++offset) {
+            x[offset] = x[offset] / row_sums[i[offset]] * scale_factor;
+        }
+    }
+}
+
+}
+
+
+// ------- analytic Pearson residuals
+
+static inline double _pearson_residual(double const & v, double const & mu, double const & inv_theta, double const & clip) {
+    if (mu <= 0) return 0;   // gene or cell without counts.
+    double r = (v - mu) / sqrt(mu + mu * mu * inv_theta);
+    return (r > clip) ? clip : ((r < -clip) ? -clip : r);
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_col_sums(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols, 
+    double * row_sums, double * col_sums,
+    int const & threads) {
+
+    std::vector<std::vector<double>> partials(threads);
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    partials[tid].resize(rows, 0);
+    double * rs = partials[tid].data();
+
+    size_t start, end2;
+    double sum, val;
+    for (; offset < end; ++offset) {
+        start = p[offset];
+        end2 = p[offset + 1];
+        sum = 0;
+        for (size_t e = start; e < end2; ++e) {
+            val = x[e];
+            sum += val;
+            rs[i[e]] += val;
+        }
+        col_sums[offset] = sum;
+    }
+
+#pragma omp barrier
+
+    block = rows / threads;
+    rem = rows - threads * block;
+    offset = tid * block + (tid > rem ? rem : tid);
+    end = nid * block + (nid > rem ? rem : nid);
+
+    for (size_t r = offset; r < end; ++r) {
+        sum = 0;
+        for (int t = 0; t < threads; ++t) {
+            sum += partials[t][r];
+        }
+        row_sums[r] = sum;
+    }
+}
+
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_pearson_to_dense(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows,
+    double const * gene_frac, double const * cell_totals, double const & theta, double const & clip,
+    int const * row_ids, size_t const & nrow_out,
+    int const * col_ids, size_t const & ncol_out,
+    double * out,
+    int const & threads) {
+
+    // input row to output rows, CSR style:  rowmap[rowp[r], rowp[r+1]).  a row may be selected more than once.
+    std::vector<long> rowp(rows + 1, 0);
+    for (size_t r = 0; r < nrow_out; ++r) {
+        ++rowp[row_ids[r] + 1];
+    }
+    for (size_t r = 0; r < rows; ++r) rowp[r + 1] += rowp[r];
+    std::vector<long> rowmap(nrow_out);
+    {
+        std::vector<long> pos(rowp.begin(), rowp.end() - 1);
+        for (size_t r = 0; r < nrow_out; ++r) {
+            rowmap[pos[row_ids[r]]++] = r;
+        }
+    }
+    double const inv_theta = 1.0 / theta;
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = ncol_out / threads;
+    int rem = ncol_out - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    size_t start, end2;
+    double * o;
+    double n, v;
+    for (; offset < end; ++offset) {
+        o = out + offset * nrow_out;
+        n = cell_totals[col_ids[offset]];
+        for (size_t rr = 0; rr < nrow_out; ++rr) {
+            o[rr] = _pearson_residual(0.0, n * gene_frac[row_ids[rr]], inv_theta, clip);
+        }
+
+        start = p[col_ids[offset]];
+        end2 = p[col_ids[offset] + 1];
+        for (size_t e = start; e < end2; ++e) {
+            if (rowp[i[e]] == rowp[i[e] + 1]) continue;
+            v = _pearson_residual(x[e], n * gene_frac[i[e]], inv_theta, clip);
+            for (long k = rowp[i[e]]; k < rowp[i[e] + 1]; ++k) o[rowmap[k]] = v;
+        }
+    }
+}
+
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_pearson_prod(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * gene_frac, double const * cell_totals, double const & theta, double const & clip,
+    double const * B, size_t const & k,
+    double * out,
+    int const & threads) {
+
+    // R B = R0 B + (R - R0) B, where R0 is the residual of a zero count.  
+    // the correction is sparse and scatters into rows, so use per thread row-major accumulators.
+    // R0 is dense, and is computed per row block over all columns.
+    std::vector<std::vector<double>> partials(threads);
+    double const inv_theta = 1.0 / theta;
+    size_t const tile = 32;
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    partials[tid].resize(rows * k, 0);
+    double * acc = partials[tid].data();
+
+    size_t start, end2;
+    double d, n, mu;
+    double const * b;
+    double * a;
+    for (; offset < end; ++offset) {
+        b = B + offset * k;
+        n = cell_totals[offset];
+        start = p[offset];
+        end2 = p[offset + 1];
+        for (size_t e = start; e < end2; ++e) {
+            mu = n * gene_frac[i[e]];
+            d = _pearson_residual(x[e], mu, inv_theta, clip) - _pearson_residual(0.0, mu, inv_theta, clip);
+            a = acc + i[e] * k;
+            for (size_t j = 0; j < k; ++j) {
+                a[j] += d * b[j];
+            }
+        }
+    }
+
+#pragma omp barrier
+
+    // partitioned by row:  reduce, add the dense zero term, and transpose to column major.
+    block = rows / threads;
+    rem = rows - threads * block;
+    offset = tid * block + (tid > rem ? rem : tid);
+    end = nid * block + (nid > rem ? rem : nid);
+
+    // a tile of rows at a time, so each row of B is read once per tile.
+    std::vector<double> tacc(tile * k);
+    double r0[tile];
+    size_t tend, nr;
+    for (size_t r = offset; r < end; r += tile) {
+        tend = std::min(r + tile, end);
+        nr = tend - r;
+        std::fill(tacc.begin(), tacc.end(), 0);
+        for (size_t c = 0; c < cols; ++c) {
+            b = B + c * k;
+            n = cell_totals[c];
+            for (size_t rr = 0; rr < nr; ++rr) {
+                r0[rr] = _pearson_residual(0.0, n * gene_frac[r + rr], inv_theta, clip);
+            }
+            for (size_t rr = 0; rr < nr; ++rr) {
+                a = tacc.data() + rr * k;
+                for (size_t j = 0; j < k; ++j) {
+                    a[j] += r0[rr] * b[j];
+                }
+            }
+        }
+
+        for (size_t rr = 0; rr < nr; ++rr) {
+            for (size_t j = 0; j < k; ++j) {
+                d = tacc[rr * k + j];
+                for (int t = 0; t < threads; ++t) {
+                    d += partials[t][(r + rr) * k + j];
+                }
+                out[j * rows + r + rr] = d;
+            }
+        }
+    }
+}
+
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_pearson_tprod(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * gene_frac, double const * cell_totals, double const & theta, double const & clip,
+    double const * U, size_t const & k,
+    double * out,
+    int const & threads) {
+
+    double const inv_theta = 1.0 / theta;
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    std::vector<double> acc(k);
+    size_t start, end2;
+    double d, n, mu;
+    double const * u;
+    for (; offset < end; ++offset) {
+        std::fill(acc.begin(), acc.end(), 0);
+        n = cell_totals[offset];
+
+        // dense zero term.  U is small enough to stay in cache.
+        for (size_t r = 0; r < rows; ++r) {
+            d = _pearson_residual(0.0, n * gene_frac[r], inv_theta, clip);
+            u = U + r * k;
+            for (size_t j = 0; j < k; ++j) {
+                acc[j] += d * u[j];
+            }
+        }
+
+        start = p[offset];
+        end2 = p[offset + 1];
+        for (size_t e = start; e < end2; ++e) {
+            mu = n * gene_frac[i[e]];
+            d = _pearson_residual(x[e], mu, inv_theta, clip) - _pearson_residual(0.0, mu, inv_theta, clip);
+            u = U + i[e] * k;
+            for (size_t j = 0; j < k; ++j) {
+                acc[j] += d * u[j];
+            }
+        }
+
+        for (size_t j = 0; j < k; ++j) {
+            out[j * cols + offset] = acc[j];
+        }
+    }
+}
+
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_pearson_row_var(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * gene_frac, double const * cell_totals, double const & theta, double const & clip,
+    double * means, double * vars,
+    int const & threads) {
+
+    // same split as csc_pearson_prod:  sparse corrections of sum and sum of squares, then the dense zero term per row.
+    std::vector<std::vector<double>> sums(threads);
+    std::vector<std::vector<double>> sqsums(threads);
+    double const inv_theta = 1.0 / theta;
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    sums[tid].resize(rows, 0);
+    sqsums[tid].resize(rows, 0);
+    double * s = sums[tid].data();
+    double * sq = sqsums[tid].data();
+
+    size_t start, end2;
+    double n, mu, r, r0;
+    for (; offset < end; ++offset) {
+        n = cell_totals[offset];
+        start = p[offset];
+        end2 = p[offset + 1];
+        for (size_t e = start; e < end2; ++e) {
+            mu = n * gene_frac[i[e]];
+            r = _pearson_residual(x[e], mu, inv_theta, clip);
+            r0 = _pearson_residual(0.0, mu, inv_theta, clip);
+            s[i[e]] += r - r0;
+            sq[i[e]] += r * r - r0 * r0;
+        }
+    }
+
+#pragma omp barrier
+
+    block = rows / threads;
+    rem = rows - threads * block;
+    offset = tid * block + (tid > rem ? rem : tid);
+    end = nid * block + (nid > rem ? rem : nid);
+
+    double sum, sqsum, mean, var, f;
+    for (size_t row = offset; row < end; ++row) {
+        sum = 0;
+        sqsum = 0;
+        for (int t = 0; t < threads; ++t) {
+            sum += sums[t][row];
+            sqsum += sqsums[t][row];
+        }
+        f = gene_frac[row];
+        for (size_t c = 0; c < cols; ++c) {
+            r0 = _pearson_residual(0.0, cell_totals[c] * f, inv_theta, clip);
+            sum += r0;
+            sqsum += r0 * r0;
+        }
+        mean = sum / static_cast<double>(cols);
+        var = sqsum / static_cast<double>(cols) - mean * mean;
+        means[row] = mean;
+        vars[row] = (var > 0) ? var : 0.0;
+    }
+}
+
+}
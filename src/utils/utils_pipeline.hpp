@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <exception>
+#include <condition_variable>
+
+/*
+ * read-ahead pipeline:  a reader thread produces the next items (file reads, decoding) while the calling thread
+ * computes on the current one, typically with OpenMP.  memory is bounded by a fixed pool of recycled buffers.
+ */
+
+// blocking FIFO with a fixed capacity.  after close(), push fails and pop drains what is left.
+template <typename T>
+class bounded_queue {
+  public:
+    explicit bounded_queue(size_t const & _capacity) : capacity(_capacity == 0 ? 1 : _capacity), closed(false) {}
+
+    bool push(T && v) {
+        std::unique_lock<std::mutex> lock(m);
+        not_full.wait(lock, [this]{ return closed || (q.size() < capacity); });
+        if (closed) return false;
+        q.push_back(std::move(v));
+        not_empty.notify_one();
+        return true;
+    }
+    bool pop(T & v) {
+        std::unique_lock<std::mutex> lock(m);
+        not_empty.wait(lock, [this]{ return closed || !q.empty(); });
+        if (q.empty()) return false;
+        v = std::move(q.front());
+        q.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+    void close() {
+        std::lock_guard<std::mutex> lock(m);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+  protected:
+    std::mutex m;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<T> q;
+    size_t capacity;
+    bool closed;
+};
+
+// items 0..n-1 in order:  produce(k, buf) runs on a reader thread, consume(k, buf) on the calling thread.
+// up to depth items are read ahead, into depth + 1 buffers of type B that are handed back after consume, so
+// vectors in B keep their capacity and memory does not grow with n.  depth 0 runs both on the calling thread.
+// produce must not call R.  an exception on either side stops the other and is rethrown here.
+template <typename B, typename P, typename C>
+void prefetch_pipeline(size_t const & n, size_t const & depth, P produce, C consume) {
+    if ((depth == 0) || (n < 2)) {
+        B buf;
+        for (size_t k = 0; k < n; ++k) {
+            produce(k, buf);
+            consume(k, buf);
+        }
+        return;
+    }
+
+    typedef std::pair<size_t, B> item_t;
+    bounded_queue<item_t> full(depth);
+    bounded_queue<item_t> empty(depth + 1);
+    for (size_t d = 0; d <= depth; ++d) empty.push(item_t(0, B()));
+
+    std::exception_ptr err;
+    std::thread reader([&]() {
+        item_t item;
+        try {
+            for (size_t k = 0; k < n; ++k) {
+                if (!empty.pop(item)) break;
+                item.first = k;
+                produce(k, item.second);
+                if (!full.push(std::move(item))) break;
+            }
+        } catch (...) {
+            err = std::current_exception();
+        }
+        full.close();
+    });
+
+    item_t item;
+    try {
+        while (full.pop(item)) {
+            consume(item.first, item.second);
+            empty.push(std::move(item));
+        }
+    } catch (...) {
+        empty.close();
+        full.close();
+        reader.join();
+        throw;
+    }
+    reader.join();
+    if (err) std::rethrow_exception(err);
+}
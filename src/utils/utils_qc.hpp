@@ -0,0 +1,20 @@
+#pragma once 
+
+#include <stddef.h>
+
+/*
+ * per cell QC metrics for R dgCMatrix / dgCMatrix64, cells in columns.
+ */
+
+// one sweep over the columns.  per column total, number of positive entries, and per feature set totals.
+// set_masks has one entry per row, bit s set if the row is in feature set s (nsets <= 31).
+// set_sums is cols x nsets, column major.
+template <typename XVEC, typename IVEC, typename PVEC, typename MVEC>
+extern void csc_col_qc(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & cols,
+    MVEC const & set_masks, size_t const & nsets,
+    double * totals, int * nfeatures, double * set_sums,
+    int const & threads);
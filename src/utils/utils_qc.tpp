@@ -0,0 +1,67 @@
+#pragma once
+
+#include "utils_qc.hpp"
+
+/*
+ * per cell QC metrics for R dgCMatrix / dgCMatrix64
+ *
+ */
+
+#include <vector>
+#include <algorithm>
+
+#include <omp.h>
+
+
+template <typename XVEC, typename IVEC, typename PVEC, typename MVEC>
+extern void csc_col_qc(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & cols,
+    MVEC const & set_masks, size_t const & nsets,
+    double * totals, int * nfeatures, double * set_sums,
+    int const & threads) {
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    std::vector<double> sums(nsets);
+    size_t start, end2;
+    double total, val;
+    int nfeat;
+    unsigned int mask;
+    for (; offset < end; ++offset) {
+        start = p[offset];
+        end2 = p[offset + 1];
+
+        total = 0;
+        nfeat = 0;
+        std::fill(sums.begin(), sums.end(), 0);
+        for (size_t e = start; e < end2; ++e) {
+            val = x[e];
+            total += val;
+            nfeat += (val > 0);
+            // most rows are in no set.
+            mask = static_cast<unsigned int>(set_masks[i[e]]);
+            while (mask) {
+                sums[__builtin_ctz(mask)] += val;
+                mask &= mask - 1;
+            }
+        }
+
+        totals[offset] = total;
+        nfeatures[offset] = nfeat;
+        for (size_t s = 0; s < nsets; ++s) {
+            set_sums[s * cols + offset] = sums[s];
+        }
+    }
+}
+
+}
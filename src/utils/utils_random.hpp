@@ -0,0 +1,32 @@
+#pragma once 
+
+#include <cstdint>
+
+/*
+ * small portable random streams.  unlike the std distributions, results are the same on every platform.
+ */
+
+// splitmix64.  small state, so one stream per column (or per task) is cheap.
+// (seed, stream) pairs give independent, reproducible sequences regardless of thread assignment.
+struct splitmix64_stream {
+    uint64_t s;
+
+    splitmix64_stream(uint64_t const & seed, uint64_t const & stream) : s(seed) {
+        s = next() ^ ((stream + 1) * 0xD1B54A32D192ED03ULL);
+        next();
+    }
+    inline uint64_t next() {
+        uint64_t z = (s += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    // [0, 1)
+    inline double uniform() {
+        return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+    // [0, n)
+    inline uint64_t below(uint64_t const & n) {
+        return static_cast<uint64_t>(uniform() * static_cast<double>(n));
+    }
+};
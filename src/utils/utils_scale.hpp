@@ -0,0 +1,62 @@
+#pragma once 
+
+#include <stddef.h>
+
+/*
+ * implicit ScaleData for R dgCMatrix / dgCMatrix64, features (genes) in rows.
+ *
+ * the scaled value of an entry is z = (min(x, clip_max[r]) - center[r]) / scale[r].
+ * all zero entries of a row share one value, offset[r] = z(0).  so the scaled matrix is
+ *      Z = offset * 1^T + D
+ * where D is sparse, with the same pattern as x and values z - offset[r].
+ * consumers never need the dense Z.
+ */
+
+// one pass over CSC.  computes, per row, the center (mean or 0), the scale (sd around center or 1),
+// the clip bound in input units (center + scale_max * scale), and the zero entry offset.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_scale_stats(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    bool const & center, bool const & scale, double const & scale_max,
+    double * centers, double * scales, double * clip_max, double * offsets,
+    int const & threads);
+
+// dense scaled sub-matrix, column major.  row_ids and col_ids are 0-based and select the output rows and columns.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_scaled_to_dense(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows,
+    double const * centers, double const * scales, double const * clip_max, double const * offsets,
+    int const * row_ids, size_t const & nrow_out,
+    int const * col_ids, size_t const & ncol_out,
+    double * out,
+    int const & threads);
+
+// Z * B.  B is cols x k, row-major.  output is rows x k, column major.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_scaled_prod(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * centers, double const * scales, double const * clip_max, double const * offsets,
+    double const * B, size_t const & k,
+    double * out,
+    int const & threads);
+
+// Z^T * U.  U is rows x k, row-major.  output is cols x k, column major.
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_scaled_tprod(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * centers, double const * scales, double const * clip_max, double const * offsets,
+    double const * U, size_t const & k,
+    double * out,
+    int const & threads);
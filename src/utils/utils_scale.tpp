@@ -0,0 +1,289 @@
+#pragma once
+
+#include "utils_scale.hpp"
+
+/*
+ * implicit ScaleData for R dgCMatrix / dgCMatrix64
+ *
+ */
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <omp.h>
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_scale_stats(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    bool const & center, bool const & scale, double const & scale_max,
+    double * centers, double * scales, double * clip_max, double * offsets,
+    int const & threads) {
+
+    // per thread row sums and sums of squares, so the CSC matrix is read once.
+    std::vector<std::vector<double>> sums(threads);
+    std::vector<std::vector<double>> sqsums(threads);
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    sums[tid].resize(rows, 0);
+    sqsums[tid].resize(rows, 0);
+    double * s = sums[tid].data();
+    double * sq = sqsums[tid].data();
+
+    size_t start = p[offset], end2 = p[end];
+    double val;
+    // each column's rows are visited once, the column boundaries do not matter.
+    for (size_t e = start; e < end2; ++e) {
+        val = x[e];
+        s[i[e]] += val;
+        sq[i[e]] += val * val;
+    }
+
+#pragma omp barrier
+
+    // reduce, partitioned by row.
+    block = rows / threads;
+    rem = rows - threads * block;
+    offset = tid * block + (tid > rem ? rem : tid);
+    end = nid * block + (nid > rem ? rem : nid);
+
+    double sum, sqsum, c, sd, var;
+    for (size_t r = offset; r < end; ++r) {
+        sum = 0;
+        sqsum = 0;
+        for (int t = 0; t < threads; ++t) {
+            sum += sums[t][r];
+            sqsum += sqsums[t][r];
+        }
+
+        // same as Seurat FastRowScale:  sd is taken around the center (root mean square if not centering), n - 1 denominator.
+        c = center ? sum / static_cast<double>(cols) : 0.0;
+        if (scale) {
+            var = (sqsum - 2.0 * c * sum + static_cast<double>(cols) * c * c) / static_cast<double>(cols - 1);
+            sd = (var > 0) ? sqrt(var) : 0.0;
+        } else {
+            sd = 1.0;
+        }
+
+        centers[r] = c;
+        scales[r] = sd;
+        if (sd > 0) {
+            clip_max[r] = c + scale_max * sd;
+            offsets[r] = (std::min(0.0, clip_max[r]) - c) / sd;
+        } else {
+            // constant row.  every entry scales to 0.
+            clip_max[r] = c;
+            offsets[r] = 0;
+        }
+    }
+}
+
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_scaled_to_dense(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows,
+    double const * centers, double const * scales, double const * clip_max, double const * offsets,
+    int const * row_ids, size_t const & nrow_out,
+    int const * col_ids, size_t const & ncol_out,
+    double * out,
+    int const & threads) {
+
+    // input row to output rows, CSR style:  rowmap[rowp[r], rowp[r+1]).  a row may be selected more than once.
+    std::vector<long> rowp(rows + 1, 0);
+    for (size_t r = 0; r < nrow_out; ++r) {
+        ++rowp[row_ids[r] + 1];
+    }
+    for (size_t r = 0; r < rows; ++r) rowp[r + 1] += rowp[r];
+    std::vector<long> rowmap(nrow_out);
+    {
+        std::vector<long> pos(rowp.begin(), rowp.end() - 1);
+        for (size_t r = 0; r < nrow_out; ++r) {
+            rowmap[pos[row_ids[r]]++] = r;
+        }
+    }
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = ncol_out / threads;
+    int rem = ncol_out - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    size_t start, end2;
+    double * o;
+    double sd, v;
+    for (; offset < end; ++offset) {
+        o = out + offset * nrow_out;
+        for (size_t rr = 0; rr < nrow_out; ++rr) {
+            o[rr] = offsets[row_ids[rr]];
+        }
+
+        start = p[col_ids[offset]];
+        end2 = p[col_ids[offset] + 1];
+        for (size_t e = start; e < end2; ++e) {
+            if (rowp[i[e]] == rowp[i[e] + 1]) continue;
+            sd = scales[i[e]];
+            v = (sd > 0) ? (std::min(static_cast<double>(x[e]), clip_max[i[e]]) - centers[i[e]]) / sd : 0.0;
+            for (long k = rowp[i[e]]; k < rowp[i[e] + 1]; ++k) o[rowmap[k]] = v;
+        }
+    }
+}
+
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_scaled_prod(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * centers, double const * scales, double const * clip_max, double const * offsets,
+    double const * B, size_t const & k,
+    double * out,
+    int const & threads) {
+
+    // Z B = offset (1^T B) + D B.  D B scatters into rows, so use per thread row-major accumulators.
+    std::vector<std::vector<double>> partials(threads);
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    partials[tid].resize(rows * k, 0);
+    double * acc = partials[tid].data();
+    // column sums of B over this thread's columns, for the offset term.
+    std::vector<double> colsum(k, 0);
+
+    size_t start, end2;
+    double d, sd;
+    double const * b;
+    double * a;
+    for (; offset < end; ++offset) {
+        b = B + offset * k;
+        for (size_t j = 0; j < k; ++j) colsum[j] += b[j];
+
+        start = p[offset];
+        end2 = p[offset + 1];
+        for (size_t e = start; e < end2; ++e) {
+            sd = scales[i[e]];
+            if (sd <= 0) continue;
+            d = (std::min(static_cast<double>(x[e]), clip_max[i[e]]) - centers[i[e]]) / sd - offsets[i[e]];
+            a = acc + i[e] * k;
+            for (size_t j = 0; j < k; ++j) {
+                a[j] += d * b[j];
+            }
+        }
+    }
+    
+    // each thread folds its own column sums of B into the rows' offset term.
+    for (size_t r = 0; r < rows; ++r) {
+        a = acc + r * k;
+        for (size_t j = 0; j < k; ++j) {
+            a[j] += offsets[r] * colsum[j];
+        }
+    }
+
+#pragma omp barrier
+
+    // reduce, partitioned by row, and transpose to column major.
+    block = rows / threads;
+    rem = rows - threads * block;
+    offset = tid * block + (tid > rem ? rem : tid);
+    end = nid * block + (nid > rem ? rem : nid);
+
+    double v;
+    for (size_t r = offset; r < end; ++r) {
+        for (size_t j = 0; j < k; ++j) {
+            v = 0;
+            for (int t = 0; t < threads; ++t) {
+                v += partials[t][r * k + j];
+            }
+            out[j * rows + r] = v;
+        }
+    }
+}
+
+}
+
+
+template <typename XVEC, typename IVEC, typename PVEC>
+extern void csc_row_scaled_tprod(
+    XVEC const & x, 
+    IVEC const & i, 
+    PVEC const & p, 
+    size_t const & rows, size_t const & cols,
+    double const * centers, double const * scales, double const * clip_max, double const * offsets,
+    double const * U, size_t const & k,
+    double * out,
+    int const & threads) {
+
+    // Z^T U = 1 (offset^T U) + D^T U.  the first term is the same for every column.
+    std::vector<double> base(k, 0);
+    double const * u;
+    for (size_t r = 0; r < rows; ++r) {
+        u = U + r * k;
+        for (size_t j = 0; j < k; ++j) {
+            base[j] += offsets[r] * u[j];
+        }
+    }
+
+#pragma omp parallel num_threads(threads)
+{   
+    int tid = omp_get_thread_num();
+    size_t block = cols / threads;
+    int rem = cols - threads * block;
+    size_t offset = tid * block + (tid > rem ? rem : tid);
+    int nid = tid + 1;
+    size_t end = nid * block + (nid > rem ? rem : nid);
+
+    std::vector<double> acc(k);
+    size_t start, end2;
+    double d, sd;
+    double const * uu;
+    for (; offset < end; ++offset) {
+        std::copy(base.begin(), base.end(), acc.begin());
+
+        start = p[offset];
+        end2 = p[offset + 1];
+        for (size_t e = start; e < end2; ++e) {
+            sd = scales[i[e]];
+            if (sd <= 0) continue;
+            d = (std::min(static_cast<double>(x[e]), clip_max[i[e]]) - centers[i[e]]) / sd - offsets[i[e]];
+            uu = U + i[e] * k;
+            for (size_t j = 0; j < k; ++j) {
+                acc[j] += d * uu[j];
+            }
+        }
+
+        for (size_t j = 0; j < k; ++j) {
+            out[j * cols + offset] = acc[j];
+        }
+    }
+}
+
+}
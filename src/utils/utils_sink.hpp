@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <utility>
+
+/*
+ * streaming sink for feature x cluster result tables, so that large DE results go to disk block by block
+ * instead of into an R data frame.
+ *
+ * TSV with a header line, then one line per (feature, cluster) in the order of the data frames from
+ * export_*_to_r_dataframe:  cluster, gene, then the value columns.  the lines of a block are formatted by
+ * the OpenMP threads into per-thread buffers and written in order.  if the filename ends in .gz, each thread
+ * also deflates its buffer into a gzip member;  concatenated members are a valid gzip file (gzip -d, gzfile, zcat).
+ */
+
+class tsv_sink {
+  public:
+    // creates (or truncates) the file and writes the header.  throws std::runtime_error if it cannot be written.
+    tsv_sink(std::string const & filename, std::vector<std::string> const & columns, int const & level = 6);
+    ~tsv_sink();
+    tsv_sink(tsv_sink const & other) = delete;
+    tsv_sink & operator=(tsv_sink const & other) = delete;
+
+    // the results for features [first, first + count).  values has one array per value column, each with
+    // count * labels.size() entries, feature major, as produced by the omp_sparse_* kernels.  names holds all
+    // feature names (indexed by first + f);  if empty, the 1-based feature number is written instead.
+    void write(std::vector<std::string> const & names, size_t const & first, size_t const & count,
+        std::vector<std::pair<int, size_t> > const & labels, std::vector<double const *> const & values,
+        int const & threads);
+    // flush and close.  throws if the data did not reach the file.
+    void close();
+
+    std::string filename;
+    size_t rows;
+    size_t bytes;    // written to the file, after compression
+
+  protected:
+    FILE * file;
+    bool gz;
+    int level;
+    std::vector<std::string> text;
+    std::vector<std::string> packed;
+
+    void put(std::string const & s);
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "utils_sink.hpp"
+
+/*
+ * streaming TSV result sink
+ *
+ */
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+
+#include <zlib.h>
+#include <omp.h>
+
+
+// deflate in into a complete gzip member.
+static bool _sink_gzip(std::string const & in, int const & level, std::string & out) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    // 15 + 16:  gzip header and trailer.
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+    out.resize(deflateBound(&zs, in.size()) + 32);
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+    zs.avail_in = in.size();
+    zs.next_out = reinterpret_cast<Bytef *>(&out[0]);
+    zs.avail_out = out.size();
+    int ret = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return ret == Z_STREAM_END;
+}
+
+// shortest form that reads back as the same double.  NaN and infinities as R writes them.
+static inline void _sink_append(std::string & s, double const & v) {
+    if (std::isnan(v)) { s.append("NaN"); return; }
+    if (std::isinf(v)) { s.append(v > 0 ? "Inf" : "-Inf"); return; }
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%.15g", v);
+    if (strtod(buf, NULL) != v) n = snprintf(buf, sizeof(buf), "%.17g", v);
+    s.append(buf, n);
+}
+
+tsv_sink::tsv_sink(std::string const & _filename, std::vector<std::string> const & columns, int const & _level) :
+    filename(_filename), rows(0), bytes(0), file(NULL), level(_level) {
+
+    gz = (filename.size() > 3) && (filename.compare(filename.size() - 3, 3, ".gz") == 0);
+    file = fopen(filename.c_str(), "wb");
+    if (file == NULL) throw std::runtime_error("unable to create " + filename);
+
+    std::string header("cluster\tgene");
+    for (auto const & c : columns) {
+        header.push_back('\t');
+        header.append(c);
+    }
+    header.push_back('\n');
+    // the destructor does not run for a constructor that throws:  close and remove the partial file here.
+    try {
+        if (gz) {
+            std::string z;
+            if (!_sink_gzip(header, level, z)) throw std::runtime_error("unable to compress output for " + filename);
+            put(z);
+        } else put(header);
+    } catch (...) {
+        fclose(file);
+        file = NULL;
+        remove(filename.c_str());
+        throw;
+    }
+}
+
+tsv_sink::~tsv_sink() {
+    if (file != NULL) fclose(file);
+}
+
+void tsv_sink::put(std::string const & s) {
+    if (fwrite(s.data(), 1, s.size(), file) != s.size()) throw std::runtime_error("unable to write " + filename);
+    bytes += s.size();
+}
+
+void tsv_sink::write(std::vector<std::string> const & names, size_t const & first, size_t const & count,
+    std::vector<std::pair<int, size_t> > const & labels, std::vector<double const *> const & values,
+    int const & threads) {
+
+    if (file == NULL) throw std::runtime_error("result sink " + filename + " is closed");
+    if ((count == 0) || labels.empty()) return;
+    if (!names.empty() && (first + count > names.size())) throw std::runtime_error("fewer feature names than features");
+
+    size_t const nlabels = labels.size();
+    text.resize(threads);
+    packed.resize(threads);
+    bool ok = true;
+
+    // contiguous feature ranges per thread, so the buffers concatenate in order.
+#pragma omp parallel num_threads(threads) reduction(&&:ok)
+    {
+        int tid = omp_get_thread_num();
+        size_t block = count / threads;
+        size_t rem = count - threads * block;
+        size_t offset = tid * block + (static_cast<size_t>(tid) > rem ? rem : tid);
+        int nid = tid + 1;
+        size_t end = nid * block + (static_cast<size_t>(nid) > rem ? rem : nid);
+
+        std::string & s = text[tid];
+        s.clear();
+        char num[24];
+        for (size_t f = offset; f < end; ++f) {
+            std::string gene = names.empty() ? std::to_string(first + f + 1) : names[first + f];
+            for (size_t l = 0; l < nlabels; ++l) {
+                s.append(num, snprintf(num, sizeof(num), "%d", labels[l].first));
+                s.push_back('\t');
+                s.append(gene);
+                for (auto const & col : values) {
+                    s.push_back('\t');
+                    _sink_append(s, col[f * nlabels + l]);
+                }
+                s.push_back('\n');
+            }
+        }
+        if (gz) ok = _sink_gzip(s, level, packed[tid]);
+    }
+    if (!ok) throw std::runtime_error("unable to compress output for " + filename);
+
+    for (int t = 0; t < threads; ++t) {
+        if (text[t].empty()) continue;
+        put(gz ? packed[t] : text[t]);
+    }
+    rows += count * nlabels;
+}
+
+void tsv_sink::close() {
+    if (file == NULL) return;
+    bool ok = (fflush(file) == 0);
+    ok &= (fclose(file) == 0);
+    file = NULL;
+    if (!ok) throw std::runtime_error("unable to write " + filename);
+}
@@ -101,6 +101,21 @@ extern void _sp_transpose_par(
     PT2 * tp, 
     int const & threads);
 
+// NOTe:  there is no formal definition of sparse matrix.
+// input is column major, so i has the row ids, and p is per column.
+// raw arrays with nelem non-zeros, e.g. memory mapped.
+template <typename XT, typename IT, typename PT, typename IT2, typename PT2>
+extern void _sp_transpose_par(
+    XT const * x, 
+    IT const * i, 
+    PT const * p, 
+    size_t const & nelem,
+    IT2 const & nrow, IT2 const & ncol, 
+    XT * tx, 
+    IT2 * ti, 
+    PT2 * tp, 
+    int const & threads);
+
 // no names.
 template <typename OUT, typename XT, typename IT, typename PT, typename IT2>
 extern OUT _sp_to_dense(
@@ -149,3 +164,22 @@ extern cpp11::writable::r_vector<XT> _sp_rowsums(
     cpp11::r_vector<IT> const & i, 
     IT const & nrow, IT2 const & nzcount, 
     int const & threads);
+
+
+// rows or columns of a CSC matrix, in the given order, repeats allowed.  sel holds nsel 0-based positions.
+// in two steps so that the caller can allocate the output:  the _count functions write op (nsel + 1 entries
+// for columns, ncol + 1 for rows), then the others fill ox and oi.
+template <typename PT, typename PT2>
+extern void _sp_select_cols_count(PT const * p, int const * sel, size_t const & nsel, PT2 * op);
+
+template <typename XT, typename IT, typename PT, typename PT2>
+extern void _sp_select_cols(XT const * x, IT const * i, PT const * p, int const * sel, size_t const & nsel, 
+    PT2 const * op, XT * ox, IT * oi, int const & threads);
+
+template <typename IT, typename PT, typename PT2>
+extern void _sp_select_rows_count(IT const * i, PT const * p, size_t const & nrow, size_t const & ncol, 
+    int const * sel, size_t const & nsel, PT2 * op, int const & threads);
+
+template <typename XT, typename IT, typename PT, typename PT2>
+extern void _sp_select_rows(XT const * x, IT const * i, PT const * p, size_t const & nrow, size_t const & ncol, 
+    int const * sel, size_t const & nsel, PT2 const * op, XT * ox, IT * oi, int const & threads);
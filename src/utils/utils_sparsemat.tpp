@@ -22,6 +22,9 @@
 cpp11::doubles to_cpp(SEXP x, double t) { return cpp11::as_doubles(x); }
 cpp11::integers to_cpp(SEXP x, int t) { return cpp11::as_integers(x); }
 
+static inline double const * _sp_data_ro(cpp11::r_vector<double> const & x) { return REAL_RO(x); }
+static inline int const * _sp_data_ro(cpp11::r_vector<int> const & x) { return INTEGER_RO(x); }
+
 
 // NOTe:  there is no formal definition of sparse matrix.
 // input is column major, so i has the row ids, and p is per column.
@@ -385,6 +388,27 @@ extern void _sp_transpose_par(
     PT2 * tp, 
     int const & threads) {
 
+    _sp_transpose_par(_sp_data_ro(x), _sp_data_ro(i), _sp_data_ro(p), static_cast<size_t>(x.size()), 
+        nrow, ncol, tx, ti, tp, threads);
+}
+
+
+
+// NOTe:  there is no formal definition of sparse matrix.
+// input is column major, so i has the row ids, and p is per column.
+// raw arrays, e.g. memory mapped.
+template <typename XT, typename IT, typename PT, typename IT2, typename PT2>
+extern void _sp_transpose_par(
+    XT const * x, 
+    IT const * i, 
+    PT const * p, 
+    size_t const & nelem,
+    IT2 const & nrow, IT2 const & ncol,
+    XT * tx, 
+    IT2 * ti, 
+    PT2 * tp, 
+    int const & threads) {
+
     // https://www.r-bloggers.com/2020/03/what-is-a-dgcmatrix-object-made-of-sparse-matrix-format-in-r/
     // ======= decompose the input matrix in CSC format, S4 object with slots:
     // i :  int, row numbers, 0-based.
@@ -400,7 +424,6 @@ extern void _sp_transpose_par(
 
   start = std::chrono::steady_clock::now();
 
-    size_t nelem = x.size();
 
     // assume all allocated properly
 
@@ -544,8 +567,8 @@ extern void _sp_transpose_par(
     IT2 rid;   // column id needs to start with 0.  row ids start with 0
     XT val;
     // need to search for cid based on offset.
-    auto pptr = std::upper_bound(p.begin(), p.end(), offset);
-    IT2 cid = std::distance(p.begin(), pptr) - 1;
+    auto pptr = std::upper_bound(p, p + ncol + 1, offset);
+    IT2 cid = std::distance(p, pptr) - 1;
     size_t pos;
     
     for (; offset < end; ++offset) {
@@ -1147,3 +1170,99 @@ extern cpp11::writable::r_vector<XT> _sp_rowsums(
     }
     return out;
 }
+
+
+template <typename PT, typename PT2>
+extern void _sp_select_cols_count(PT const * p, int const * sel, size_t const & nsel, PT2 * op) {
+    op[0] = 0;
+    for (size_t k = 0; k < nsel; ++k) {
+        op[k + 1] = op[k] + (p[sel[k] + 1] - p[sel[k]]);
+    }
+}
+
+template <typename XT, typename IT, typename PT, typename PT2>
+extern void _sp_select_cols(XT const * x, IT const * i, PT const * p, int const * sel, size_t const & nsel, 
+    PT2 const * op, XT * ox, IT * oi, int const & threads) {
+
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+    for (size_t k = 0; k < nsel; ++k) {
+        long s = static_cast<long>(p[sel[k]]);
+        long n = static_cast<long>(p[sel[k] + 1]) - s;
+        long o = static_cast<long>(op[k]);
+        if (n > 0) {
+            memcpy(ox + o, x + s, n * sizeof(XT));
+            memcpy(oi + o, i + s, n * sizeof(IT));
+        }
+    }
+}
+
+// the output rows of each input row, CSR style:  rnew[rp[r], rp[r+1]).
+static void _sp_select_row_map(size_t const & nrow, int const * sel, size_t const & nsel, 
+    std::vector<long> & rp, std::vector<int> & rnew) {
+    rp.assign(nrow + 1, 0);
+    for (size_t k = 0; k < nsel; ++k) ++rp[sel[k] + 1];
+    for (size_t r = 0; r < nrow; ++r) rp[r + 1] += rp[r];
+    rnew.resize(nsel);
+    std::vector<long> pos(rp.begin(), rp.end() - 1);
+    for (size_t k = 0; k < nsel; ++k) rnew[pos[sel[k]]++] = static_cast<int>(k);
+}
+
+template <typename IT, typename PT, typename PT2>
+extern void _sp_select_rows_count(IT const * i, PT const * p, size_t const & nrow, size_t const & ncol, 
+    int const * sel, size_t const & nsel, PT2 * op, int const & threads) {
+    std::vector<long> rp;
+    std::vector<int> rnew;
+    _sp_select_row_map(nrow, sel, nsel, rp, rnew);
+
+    std::vector<long> cnt(ncol);
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 64)
+    for (size_t c = 0; c < ncol; ++c) {
+        long n = 0;
+        long const end = static_cast<long>(p[c + 1]);
+        for (long e = static_cast<long>(p[c]); e < end; ++e) n += rp[i[e] + 1] - rp[i[e]];
+        cnt[c] = n;
+    }
+    op[0] = 0;
+    for (size_t c = 0; c < ncol; ++c) op[c + 1] = op[c] + cnt[c];
+}
+
+template <typename XT, typename IT, typename PT, typename PT2>
+extern void _sp_select_rows(XT const * x, IT const * i, PT const * p, size_t const & nrow, size_t const & ncol, 
+    int const * sel, size_t const & nsel, PT2 const * op, XT * ox, IT * oi, int const & threads) {
+    std::vector<long> rp;
+    std::vector<int> rnew;
+    _sp_select_row_map(nrow, sel, nsel, rp, rnew);
+
+    // increasing selections keep the rows of a column in order.
+    bool sorted = true;
+    for (size_t k = 1; k < nsel; ++k) sorted &= (sel[k] > sel[k - 1]);
+
+#pragma omp parallel num_threads(threads)
+{
+    std::vector<std::pair<IT, XT> > col;
+#pragma omp for schedule(dynamic, 64)
+    for (size_t c = 0; c < ncol; ++c) {
+        long o = static_cast<long>(op[c]);
+        long const end = static_cast<long>(p[c + 1]);
+        if (sorted) {
+            for (long e = static_cast<long>(p[c]); e < end; ++e) {
+                for (long k = rp[i[e]]; k < rp[i[e] + 1]; ++k, ++o) {
+                    ox[o] = x[e];
+                    oi[o] = rnew[k];
+                }
+            }
+        } else {
+            col.clear();
+            for (long e = static_cast<long>(p[c]); e < end; ++e) {
+                for (long k = rp[i[e]]; k < rp[i[e] + 1]; ++k) col.emplace_back(rnew[k], x[e]);
+            }
+            std::sort(col.begin(), col.end(), [](std::pair<IT, XT> const & a, std::pair<IT, XT> const & b) { return a.first < b.first; });
+            for (auto const & v : col) {
+                oi[o] = v.first;
+                ox[o] = v.second;
+                ++o;
+            }
+        }
+    }
+}
+}